@@ -9,6 +9,7 @@
 #include "i8271.h"
 #include "ide.h"
 #include "mem.h"
+#include "metrics.h"
 #include "model.h"
 #include "cmos.h"
 #include "mouse.h"
@@ -16,6 +17,7 @@
 #include "music5000.h"
 #include "mmccard.h"
 #include "paula.h"
+#include "sched.h"
 #include "serial.h"
 #include "scsi.h"
 #include "sid_b-em.h"
@@ -177,7 +179,7 @@ static uint32_t dbg_parse_addr(cpu_debug_t *cpu, const char *arg, const char **e
     return a;
 }
 
-static uint32_t do_readmem(uint32_t addr);
+static inline uint32_t do_readmem(uint32_t addr);
 static void     do_writemem(uint32_t addr, uint32_t val);
 static uint32_t dbg_do_readmem(uint32_t addr);
 static void     dbg_do_writemem(uint32_t addr, uint32_t val);
@@ -227,19 +229,18 @@ static int timetolive = 0;
 
 int cycles;
 uint64_t stopwatch;
+int m6502_stop_pc = -1;
 static int otherstuffcount = 0;
 int romsel;
 
 static void polltime(int c)
 {
     cycles -= c;
-    via_poll(&sysvia, c);
-    via_poll(&uservia, c);
+    sched_poll(c);
     video_poll(c, 1);
-    sound_poll(c);
-    music5000_poll(c);
     stopwatch += c;
     otherstuffcount -= c;
+    // the disc formats pace transfers by counting polls so tick them here.
     if (motoron) {
         if (fdc_time) {
             fdc_time -= c;
@@ -253,6 +254,7 @@ static void polltime(int c)
         }
     }
     tubecycle += c;
+    metrics.polls++;
 }
 
 static int FEslowdown[8] = { 1, 0, 1, 1, 0, 0, 1, 0 };
@@ -285,10 +287,40 @@ void os_paste_start(char *str)
             al_free(clip_paste_str);
         clip_paste_str = clip_paste_ptr = (unsigned char *)str;
         os_paste_ch = -1;
+        /* RAM may have been replaced, e.g. by loading a snapshot, since the
+         * vectors were last written so pick them up from there. */
+        if (ram) {
+            buf_remv = ram[0x22c] | (ram[0x22d] << 8);
+            buf_cnpv = ram[0x22e] | (ram[0x22f] << 8);
+        }
         log_debug("6502: paste start, clip_paste_str=%p", clip_paste_str);
     }
 }
 
+/*
+ * Stop a paste in progress, returning what was still to be pasted so it
+ * can be resumed later with os_paste_start, or NULL if there was none.
+ */
+
+char *os_paste_stop(void)
+{
+    char *rest = NULL;
+
+    if (clip_paste_str) {
+        size_t len = strlen((char *)clip_paste_ptr);
+        if ((rest = al_malloc(len + 2))) {
+            char *ptr = rest;
+            if (os_paste_ch >= 0)
+                *ptr++ = os_paste_ch;
+            memcpy(ptr, clip_paste_ptr, len + 1);
+        }
+        al_free(clip_paste_str);
+        clip_paste_str = clip_paste_ptr = NULL;
+    }
+    os_paste_ch = -1;
+    return rest;
+}
+
 static void os_paste_remv(void)
 {
     int ch;
@@ -340,13 +372,227 @@ static void os_paste_cnpv(void)
     opcode = readmem(pc);
 }
 
+/*
+ * Decoded block cache.
+ *
+ * Fetching an instruction through readmem costs a call, the memory view
+ * counters and the checks for the debugger and for pasting on every byte.
+ * When neither the debugger nor a paste is active straight-line runs of
+ * code in RAM or ROM are instead decoded once into blocks holding the
+ * opcode and operand bytes of each instruction, which the CPU cores then
+ * take their operands from.  A block ends at an unconditional change of
+ * flow, at the end of the page or when full; conditional branches are
+ * included so the block carries on if they are not taken.
+ *
+ * Blocks are keyed by the physical address of the code, worked out from
+ * memlook, so paging a different ROM or RAM bank in finds different
+ * blocks rather than stale ones.  A bitmap marks the bytes that have been
+ * decoded and a write to one of them through writemem discards every
+ * block decoded from that physical page.  Anything that changes memory
+ * without going through writemem must call m6502_flush_blocks, which
+ * also marks the whole of memory as changed for delta snapshots.
+ */
+
+#define BB_CACHE_SIZE 4096  // must be a power of two.
+#define BB_MAX_INSNS  24
+#define BB_PHYS_SIZE  (RAM_SIZE + (ROM_NSLOT + 1) * ROM_SIZE)
+#define BB_NO_PHYS    0xffffffff
+
+typedef struct {
+    uint16_t pc;
+    uint8_t  len;       // zero marks the end of the block.
+    uint8_t  bytes[3];  // opcode followed by up to two operand bytes.
+} bb_insn_t;
+
+typedef struct {
+    uint32_t  phys;
+    uint32_t  gen;
+    bb_insn_t insn[BB_MAX_INSNS + 1];
+} bb_block_t;
+
+bool m6502_block_cache = true;
+
+static bb_block_t bb_cache[BB_CACHE_SIZE];
+static uint32_t bb_gen[BB_PHYS_SIZE >> 8];
+static uint8_t bb_codemap[BB_PHYS_SIZE >> 3];
+static const bb_insn_t *bb_ins;  // instruction being run from a block, or NULL.
+
+static const uint8_t bb_len_nmos[256] =
+{
+/*       0  1  2  3  4  5  6  7  8  9  A  B  C  D  E  F */
+/*00*/  1, 2, 1, 2, 2, 2, 2, 2, 1, 2, 1, 2, 3, 3, 3, 3,
+/*10*/  2, 2, 1, 2, 2, 2, 2, 2, 1, 3, 1, 3, 3, 3, 3, 3,
+/*20*/  3, 2, 1, 2, 2, 2, 2, 2, 1, 2, 1, 2, 3, 3, 3, 3,
+/*30*/  2, 2, 1, 2, 2, 2, 2, 2, 1, 3, 1, 3, 3, 3, 3, 3,
+/*40*/  1, 2, 1, 2, 2, 2, 2, 2, 1, 2, 1, 2, 3, 3, 3, 3,
+/*50*/  2, 2, 1, 2, 2, 2, 2, 2, 1, 3, 1, 3, 3, 3, 3, 3,
+/*60*/  1, 2, 1, 2, 2, 2, 2, 2, 1, 2, 1, 2, 3, 3, 3, 3,
+/*70*/  2, 2, 1, 2, 2, 2, 2, 2, 1, 3, 1, 3, 3, 3, 3, 3,
+/*80*/  2, 2, 2, 2, 2, 2, 2, 2, 1, 2, 1, 2, 3, 3, 3, 3,
+/*90*/  2, 2, 1, 2, 2, 2, 2, 2, 1, 3, 1, 3, 3, 3, 3, 3,
+/*A0*/  2, 2, 2, 2, 2, 2, 2, 2, 1, 2, 1, 2, 3, 3, 3, 3,
+/*B0*/  2, 2, 1, 2, 2, 2, 2, 2, 1, 3, 1, 3, 3, 3, 3, 3,
+/*C0*/  2, 2, 2, 2, 2, 2, 2, 2, 1, 2, 1, 2, 3, 3, 3, 3,
+/*D0*/  2, 2, 1, 2, 2, 2, 2, 2, 1, 3, 1, 3, 3, 3, 3, 3,
+/*E0*/  2, 2, 2, 2, 2, 2, 2, 2, 1, 2, 1, 2, 3, 3, 3, 3,
+/*F0*/  2, 2, 1, 2, 2, 2, 2, 2, 1, 3, 1, 3, 3, 3, 3, 3
+};
+
+static const uint8_t bb_len_cmos[256] =
+{
+/*       0  1  2  3  4  5  6  7  8  9  A  B  C  D  E  F */
+/*00*/  1, 2, 1, 1, 2, 2, 2, 2, 1, 2, 1, 1, 3, 3, 3, 3,
+/*10*/  2, 2, 2, 1, 2, 2, 2, 2, 1, 3, 1, 1, 3, 3, 3, 3,
+/*20*/  3, 2, 1, 1, 2, 2, 2, 2, 1, 2, 1, 1, 3, 3, 3, 3,
+/*30*/  2, 2, 2, 1, 2, 2, 2, 2, 1, 3, 1, 1, 3, 3, 3, 3,
+/*40*/  1, 2, 1, 1, 2, 2, 2, 2, 1, 2, 1, 1, 3, 3, 3, 3,
+/*50*/  2, 2, 2, 1, 2, 2, 2, 2, 1, 3, 1, 1, 3, 3, 3, 3,
+/*60*/  1, 2, 1, 1, 2, 2, 2, 2, 1, 2, 1, 1, 3, 3, 3, 3,
+/*70*/  2, 2, 2, 1, 2, 2, 2, 2, 1, 3, 1, 1, 3, 3, 3, 3,
+/*80*/  2, 2, 1, 1, 2, 2, 2, 2, 1, 2, 1, 1, 3, 3, 3, 3,
+/*90*/  2, 2, 2, 1, 2, 2, 2, 2, 1, 3, 1, 1, 3, 3, 3, 3,
+/*A0*/  2, 2, 2, 1, 2, 2, 2, 2, 1, 2, 1, 1, 3, 3, 3, 3,
+/*B0*/  2, 2, 2, 1, 2, 2, 2, 2, 1, 3, 1, 1, 3, 3, 3, 3,
+/*C0*/  2, 2, 1, 1, 2, 2, 2, 2, 1, 2, 1, 1, 3, 3, 3, 3,
+/*D0*/  2, 2, 2, 1, 2, 2, 2, 2, 1, 3, 1, 1, 3, 3, 3, 3,
+/*E0*/  2, 2, 1, 1, 2, 2, 2, 2, 1, 2, 1, 1, 3, 3, 3, 3,
+/*F0*/  2, 2, 2, 1, 2, 2, 2, 2, 1, 3, 1, 1, 3, 3, 3, 3
+};
+
+static inline uint32_t bb_phys(const uint8_t *ptr)
+{
+    if (ptr >= ram && ptr < ram + RAM_SIZE)
+        return ptr - ram;
+    if (ptr >= rom && ptr < rom + ROM_NSLOT * ROM_SIZE)
+        return RAM_SIZE + (ptr - rom);
+    if (ptr >= os && ptr < os + ROM_SIZE)
+        return RAM_SIZE + ROM_NSLOT * ROM_SIZE + (ptr - os);
+    return BB_NO_PHYS;
+}
+
+static void bb_invalidate(uint32_t phys)
+{
+    bb_gen[phys >> 8]++;
+    memset(bb_codemap + ((phys >> 3) & ~0x1f), 0, 0x20);
+    bb_ins = NULL;
+}
+
+/* Mark the page holding a physical address as changed for delta snapshots. */
+static inline void bb_dirty(uint32_t phys)
+{
+    if (phys < (MEM_DIRTY_PAGES << 8))
+        mem_dirty[phys >> 11] |= 1 << ((phys >> 8) & 7);
+}
+
+/* Note a write to memory which may hold decoded code, marking the page dirty. */
+static inline void bb_write(const uint8_t *ptr)
+{
+    uint32_t phys = bb_phys(ptr);
+    bb_dirty(phys);
+    if (phys != BB_NO_PHYS && bb_codemap[phys >> 3] & (1 << (phys & 7)))
+        bb_invalidate(phys);
+}
+
+void m6502_flush_blocks(void)
+{
+    for (int i = 0; i < (BB_PHYS_SIZE >> 8); i++)
+        bb_gen[i]++;
+    memset(bb_codemap, 0, sizeof(bb_codemap));
+    bb_ins = NULL;
+    mem_dirty_all();
+}
+
+/*
+ * Note a run of bytes changed without going through writemem, e.g. a file
+ * loaded straight into sideways RAM, discarding blocks decoded from it
+ * and marking its pages dirty as bb_write would.
+ */
+void m6502_mem_written(const uint8_t *ptr, size_t len)
+{
+    if (len) {
+        uint32_t first = bb_phys(ptr);
+        uint32_t last = bb_phys(ptr + len - 1);
+        if (first == BB_NO_PHYS || last == BB_NO_PHYS)
+            m6502_flush_blocks();
+        else
+            for (uint32_t page = first >> 8; page <= last >> 8; page++) {
+                bb_dirty(page << 8);
+                bb_invalidate(page << 8);
+            }
+    }
+}
+
+static void bb_decode(bb_block_t *blk, const uint8_t *base, uint32_t phys)
+{
+    const uint8_t *lens = x65c02 ? bb_len_cmos : bb_len_nmos;
+    bb_insn_t *insn = blk->insn;
+    uint16_t addr = pc;
+
+    blk->phys = phys;
+    blk->gen = bb_gen[phys >> 8];
+    for (int n = 0; n < BB_MAX_INSNS && (addr & 0xff) <= 0xfd; n++) {
+        uint8_t opcode = base[addr];
+        insn->pc = addr;
+        insn->len = lens[opcode];
+        insn->bytes[0] = opcode;
+        insn->bytes[1] = base[addr + 1];
+        insn->bytes[2] = base[addr + 2];
+        for (int i = 0; i < 3; i++, phys++)
+            bb_codemap[phys >> 3] |= 1 << (phys & 7);
+        phys += insn->len - 3;
+        addr += insn->len;
+        insn++;
+        if (opcode == 0x00 || opcode == 0x20 || opcode == 0x40 || opcode == 0x4c ||
+            opcode == 0x60 || opcode == 0x6c || (x65c02 && (opcode == 0x7c || opcode == 0x80)))
+            break;
+    }
+    insn->len = 0;
+}
+
+/*
+ * Find the decoded instruction at pc, continuing the current block where
+ * possible, or return NULL if the code has to be run through readmem.
+ */
+
+static inline const bb_insn_t *bb_fetch(void)
+{
+    /* Checked first so the debugger or a paste takes effect mid-block. */
+    if (!m6502_block_cache || dbg_core6502 || debug_memview || clip_paste_ptr)
+        return NULL;
+    if (bb_ins) {
+        const bb_insn_t *next = bb_ins + 1;
+        if (next->len && next->pc == pc)
+            return next;
+    }
+    if ((pc & 0xff) > 0xfd)
+        return NULL;
+
+    unsigned page = pc >> 8;
+    if (memstat[vis20k][page] == MSTAT_IO)
+        return NULL;
+    const uint8_t *base = memlook[vis20k][page];
+    uint32_t phys = bb_phys(base + pc);
+    if (phys == BB_NO_PHYS)
+        return NULL;
+    bb_block_t *blk = bb_cache + ((phys ^ (phys >> 12)) & (BB_CACHE_SIZE - 1));
+    if (blk->phys != phys || blk->gen != bb_gen[phys >> 8] || blk->insn[0].pc != pc)
+        bb_decode(blk, base, phys);
+    return blk->insn;
+}
+
 static inline void fetch_opcode(void)
 {
     pc3 = oldoldpc;
     oldoldpc = oldpc;
     oldpc = pc;
     vis20k = RAMbank[pc >> 12];
+    metrics.instructions++;
 
+    if ((bb_ins = bb_fetch())) {
+        opcode = bb_ins->bytes[0];
+        pc++;
+        return;
+    }
     if (dbg_core6502)
         debug_preexec(&core6502_cpu_debug, debug_addr(pc));
     if (pc == buf_remv && x == 0 && clip_paste_ptr)
@@ -358,6 +604,33 @@ static inline void fetch_opcode(void)
     pc++;
 }
 
+/* Read the next byte of the current instruction without moving on. */
+static inline uint8_t code_byte(void)
+{
+    if (bb_ins)
+        return bb_ins->bytes[(uint16_t)(pc - bb_ins->pc)];
+    return readmem(pc);
+}
+
+static inline uint8_t fetch_byte(void)
+{
+    uint8_t val = code_byte();
+    pc++;
+    return val;
+}
+
+static inline uint16_t getsw(void);
+
+static inline uint16_t fetch_word(void)
+{
+    if (bb_ins) {
+        unsigned off = (uint16_t)(pc - bb_ins->pc);
+        pc += 2;
+        return bb_ins->bytes[off] | (bb_ins->bytes[off + 1] << 8);
+    }
+    return getsw();
+}
+
 static inline uint16_t read_zp_indirect(uint16_t zp)
 {
     return readmem(zp & 0xff) + (readmem((zp + 1) & 0xff) << 8);
@@ -372,17 +645,30 @@ static uint32_t dbg_do_readmem(uint32_t addr) {
     return do_readmem(addr);
 }
 
-static uint32_t do_readmem(uint32_t addr)
+static uint32_t do_readmem_io(uint32_t addr);
+
+/*
+ * Reads of RAM and ROM are a single page table lookup; the counters for
+ * the memory view are only updated while it is open.
+ */
+
+static inline uint32_t do_readmem(uint32_t addr)
 {
     addr &= 0xffff;
 
+    if (debug_memview) {
         if (pc == addr)
             fetchc[addr] = 31;
         else
             readc[addr] = 31;
+    }
+    if (memstat[vis20k][addr >> 8]) // Anything except I/O.
+        return memlook[vis20k][addr >> 8][addr];
+    return do_readmem_io(addr);
+}
 
-        if (memstat[vis20k][addr >> 8]) // Anything except I/O.
-                return memlook[vis20k][addr >> 8][addr];
+static uint32_t do_readmem_io(uint32_t addr)
+{
         if (MASTER && (acccon & 0x40) && addr >= 0xFC00)
                 return os[addr & 0x3FFF];
         if (addr < 0xFE00 || FEslowdown[(addr >> 5) & 7]) {
@@ -392,6 +678,7 @@ static uint32_t do_readmem(uint32_t addr)
                         polltime(1);
                 }
         }
+        sched_sync();
 
         if (addr >= 0xFCFD && addr <= 0xFDFF) {
             // JIM, including paging registers in FRED.
@@ -572,6 +859,7 @@ static void dbg_do_writemem(uint32_t addr, uint32_t val) {
         uint32_t romno = addr >> 28;
         if (romno != (ram_fe30 & 0x7f)) {
             rom[(romno << 14) | (addr & 0x3fff)] = val;
+            bb_write(rom + ((romno << 14) | (addr & 0x3fff)));
             return;
         }
     }
@@ -774,11 +1062,14 @@ static void do_writemem(uint32_t addr, uint32_t val)
 
     addr &= 0xffff;
 
-        writec[addr] = 31;
+        if (debug_memview)
+            writec[addr] = 31;
 
         c = memstat[vis20k][addr >> 8];
         if (c == MSTAT_RAM) {
-            memlook[vis20k][addr >> 8][addr] = (uint8_t)val;
+            uint8_t *ptr = memlook[vis20k][addr >> 8] + addr;
+            *ptr = (uint8_t)val;
+            bb_write(ptr);
             switch(addr) {
                     case 0x022c:
                         buf_remv = (buf_remv & 0xff00) | val;
@@ -801,17 +1092,22 @@ static void do_writemem(uint32_t addr, uint32_t val)
                  * than the one selected by ROMSEL.
                  */
                 log_debug("6502: do_writemem, watford write, addr=%04X, val=%02X", addr, val);
-                if (addr >= 0x8000 && addr < 0xc000)
+                if (addr >= 0x8000 && addr < 0xc000) {
                     weramrom_base[addr] = val;
+                    bb_write(weramrom_base + addr);
+                }
             }
             else {
-                if (addr >= 0xff30 && addr < 0xff40 && weramrom)
+                if (addr >= 0xff30 && addr < 0xff40 && weramrom) {
                     page_weramrom(addr);
+                    bb_ins = NULL;
+                }
                 else
                     log_debug("6502: attempt to write to ROM %x:%04x=%02x, pc=%04X\n", vis20k, addr, val, pc);
             }
             return;
         }
+        bb_ins = NULL; // I/O may page memory so leave the current block.
         if (addr < 0xFC00 || addr >= 0xFF00)
                 return;
         if (addr < 0xFE00 || FEslowdown[(addr >> 5) & 7]) {
@@ -821,6 +1117,7 @@ static void do_writemem(uint32_t addr, uint32_t val)
                         polltime(1);
                 }
         }
+        sched_sync();
 
         if (addr >= 0xFCFD && addr <= 0xFDFF) {
             // JIM, including paging registers in FRED.
@@ -999,6 +1296,7 @@ static void do_writemem(uint32_t addr, uint32_t val)
                 tube_host_write((uint16_t)addr, (uint8_t)val);
                 break;
         }
+        sched_resched();
 }
 
 void writemem(uint16_t addr, uint8_t val)
@@ -1008,6 +1306,30 @@ void writemem(uint16_t addr, uint8_t val)
     do_writemem(addr, val);
 }
 
+/*
+ * Read and write memory as the 6502 currently has it paged, for tools
+ * looking in from outside.  Neither touches I/O, which reads as &FF,
+ * nor takes any time, and writes to ROM are ignored.
+ */
+
+uint8_t m6502_peek(uint16_t addr)
+{
+    if (memstat[vis20k][addr >> 8])
+        return memlook[vis20k][addr >> 8][addr];
+    if (MASTER && (acccon & 0x40) && addr >= 0xFC00)
+        return os[addr & 0x3FFF];
+    return 0xff;
+}
+
+void m6502_poke(uint16_t addr, uint8_t val)
+{
+    if (memstat[vis20k][addr >> 8] == MSTAT_RAM) {
+        uint8_t *ptr = memlook[vis20k][addr >> 8] + addr;
+        *ptr = val;
+        bb_write(ptr);
+    }
+}
+
 int nmi, oldnmi, interrupt, takeint;
 
 /*
@@ -1047,6 +1369,7 @@ void m6502_reset(void)
         ram_fe30 = 0;
         ram_fe34 = 0;
         cycles = 0;
+        m6502_flush_blocks();
 
         pc = readmem(0xFFFC) | (readmem(0xFFFD) << 8);
         p.i = 1;
@@ -1078,12 +1401,13 @@ static inline uint16_t getsw(void)
 
 static void otherstuff_poll(void) {
     otherstuffcount += 128;
+    sched_sync();
     acia_poll(&sysacia);
     if (sound_music5000)
         music2000_poll();
     if (!tapelcount) {
         tape_poll();
-        tapelcount = tapellatch;
+        tapelcount = (tape_fastload && motor) ? tape_fastload_latch() : tapellatch;
     }
     tapelcount--;
     if (motorspin) {
@@ -1106,10 +1430,9 @@ static void otherstuff_poll(void) {
         mcount = 6;
         mouse_poll();
     }
+    sched_resched();
 }
 
-#define getw() getsw()
-
 static inline void setzn(uint8_t v)
 {
     p.z = !v;
@@ -1272,7 +1595,7 @@ static inline void sbc_cmos(uint8_t temp)
 
 static inline void nmos_arr(void)
 {
-    uint_fast8_t s = readmem(pc++);
+    uint_fast8_t s = fetch_byte();
     uint_fast8_t t = a & s;                 /* Perform the AND. */
     if (p.d) {
         uint_fast8_t ah = t >> 4;               /* Separate the high */
@@ -1321,6 +1644,9 @@ void m6502_exec(int slice)
         int tempi;
         int8_t offset;
         cycles += slice;
+        sched_resched();  // anything between slices may have moved a deadline.
+        sched_sync();
+        bb_ins = NULL;
 
         while (cycles > 0) {
                 fetch_opcode();
@@ -1339,8 +1665,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x01:      /*ORA (,x) */
-                        temp = readmem(pc) + x;
-                        pc++;
+                        temp = fetch_byte() + x;
                         addr = read_zp_indirect(temp);
                         polltime(6);
                         takeint = (interrupt && !p.i);
@@ -1354,8 +1679,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x03:      /*Undocumented - SLO (,x) */
-                        temp = readmem(pc) + x;
-                        pc++;
+                        temp = fetch_byte() + x;
                         addr = read_zp_indirect(temp);
                         polltime(6);
                         temp = readmem(addr);
@@ -1371,15 +1695,13 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x04:      /*Undocumented - NOP zp */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         polltime(3);
                         takeint = (interrupt && !p.i);
                         break;
 
                 case 0x05:      /*ORA zp */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         a |= readmem(addr);
                         setzn(a);
                         polltime(3);
@@ -1387,8 +1709,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x06:      /*ASL zp */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         temp = readmem(addr);
                         p.c = temp & 0x80;
                         temp <<= 1;
@@ -1399,8 +1720,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x07:      /*Undocumented - SLO zp */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         temp = readmem(addr);
                         p.c = temp & 0x80;
                         temp <<= 1;
@@ -1420,8 +1740,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x09:      /*ORA imm */
-                        a |= readmem(pc);
-                        pc++;
+                        a |= fetch_byte();
                         setzn(a);
                         polltime(2);
                         takeint = (interrupt && !p.i);
@@ -1436,8 +1755,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x0B:      /*Undocumented - ANC imm */
-                        a &= readmem(pc);
-                        pc++;
+                        a &= fetch_byte();
                         setzn(a);
                         p.c = p.n;
                         polltime(2);
@@ -1445,13 +1763,13 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x0C:      /*Undocumented - NOP abs */
-                        addr = getw();
+                        addr = fetch_word();
                         polltime(4);
                         takeint = (interrupt && !p.i);
                         break;
 
                 case 0x0D:      /*ORA abs */
-                        addr = getw();
+                        addr = fetch_word();
                         polltime(4);
                         takeint = (interrupt && !p.i);
                         a |= readmem(addr);
@@ -1459,7 +1777,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x0E:      /*ASL abs */
-                        addr = getw();
+                        addr = fetch_word();
                         polltime(4);
                         temp = readmem(addr);
                         polltime(1);
@@ -1473,7 +1791,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x0F:      /*Undocumented - SLO abs */
-                        addr = getw();
+                        addr = fetch_word();
                         polltime(4);
                         temp = readmem(addr);
                         polltime(1);
@@ -1488,8 +1806,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x10:
-                        /*BPL*/ offset = (int8_t) readmem(pc);
-                        pc++;
+                        /*BPL*/ offset = (int8_t) fetch_byte();
                         temp = 2;
                         if (!p.n) {
                                 temp++;
@@ -1501,8 +1818,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x11:      /*ORA (),y */
-                        temp = readmem(pc);
-                        pc++;
+                        temp = fetch_byte();
                         addr = read_zp_indirect(temp);
                         if ((addr & 0xFF00) ^ ((addr + y) & 0xFF00))
                                 polltime(1);
@@ -1513,8 +1829,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x13:      /*Undocumented - SLO (),y */
-                        temp = readmem(pc);
-                        pc++;
+                        temp = fetch_byte();
                         addr = read_zp_indirect(temp);
                         polltime(6);
                         temp = readmem(addr + y);
@@ -1530,16 +1845,14 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x14:      /*Undocumented - NOP zp,x */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         readmem((addr + x) & 0xFF);
                         polltime(4);
                         takeint = (interrupt && !p.i);
                         break;
 
                 case 0x15:      /*ORA zp,x */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         a |= readmem((addr + x) & 0xFF);
                         setzn(a);
                         polltime(4);
@@ -1547,8 +1860,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x16:      /*ASL zp,x */
-                        addr = (readmem(pc) + x) & 0xFF;
-                        pc++;
+                        addr = (fetch_byte() + x) & 0xFF;
                         temp = readmem(addr);
                         p.c = temp & 0x80;
                         temp <<= 1;
@@ -1559,8 +1871,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x17:      /*Undocumented - SLO zp,x */
-                        addr = (readmem(pc) + x) & 0xFF;
-                        pc++;
+                        addr = (fetch_byte() + x) & 0xFF;
                         polltime(3);
                         temp = readmem(addr);
                         polltime(1);
@@ -1582,7 +1893,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x19:      /*ORA abs,y */
-                        addr = getw();
+                        addr = fetch_word();
                         if ((addr & 0xFF00) ^ ((addr + y) & 0xFF00))
                                 polltime(1);
                         a |= readmem(addr + y);
@@ -1597,7 +1908,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x1B:      /*Undocumented - SLO abs,y */
-                        addr = getw() + y;
+                        addr = fetch_word() + y;
                         polltime(5);
                         temp = readmem(addr);
                         polltime(1);
@@ -1612,7 +1923,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x1C:      /*Undocumented - NOP abs,x */
-                        addr = getw();
+                        addr = fetch_word();
                         if ((addr & 0xFF00) ^ ((addr + x) & 0xFF00))
                                 polltime(1);
                         readmem(addr);
@@ -1621,7 +1932,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x1D:      /*ORA abs,x */
-                        addr = getw();
+                        addr = fetch_word();
                         if ((addr & 0xFF00) ^ ((addr + x) & 0xFF00))
                                 polltime(1);
                         addr += x;
@@ -1632,7 +1943,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x1E:      /*ASL abs,x */
-                        addr = getw();
+                        addr = fetch_word();
                         readmem((addr & 0xFF00) | ((addr + x) & 0xFF));
                         addr += x;
                         temp = readmem(addr);
@@ -1646,7 +1957,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x1F:      /*Undocumented - SLO abs,x */
-                        addr = getw() + x;
+                        addr = fetch_word() + x;
                         polltime(5);
                         temp = readmem(addr);
                         polltime(1);
@@ -1661,18 +1972,17 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x20:      /*JSR*/
-                        addr = readmem(pc++);
+                        addr = fetch_byte();
                         push(pc >> 8);
                         push((uint8_t)pc);
-                        pc = addr | (readmem(pc) << 8);
+                        pc = addr | (code_byte() << 8);
                         polltime(5);
                         takeint = (interrupt && !p.i);
                         polltime(1);
                         break;
 
                 case 0x21:      /*AND (,x) */
-                        temp = readmem(pc) + x;
-                        pc++;
+                        temp = fetch_byte() + x;
                         addr = read_zp_indirect(temp);
                         a &= readmem(addr);
                         setzn(a);
@@ -1681,8 +1991,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x23:      /*Undocumented - RLA (,x) */
-                        temp = readmem(pc) + x;
-                        pc++;
+                        temp = fetch_byte() + x;
                         addr = read_zp_indirect(temp);
                         polltime(6);
                         temp = readmem(addr);
@@ -1701,8 +2010,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x24:      /*BIT zp */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         temp = readmem(addr);
                         p.z = !(a & temp);
                         p.v = temp & 0x40;
@@ -1712,8 +2020,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x25:      /*AND zp */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         a &= readmem(addr);
                         setzn(a);
                         polltime(3);
@@ -1721,8 +2028,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x26:      /*ROL zp */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         temp = readmem(addr);
                         tempi = p.c;
                         p.c = temp & 0x80;
@@ -1736,8 +2042,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x27:      /*Undocumented - RLA zp */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         temp = readmem(addr);
                         tempi = p.c;
                         p.c = temp & 0x80;
@@ -1759,8 +2064,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x29:
-                        /*AND*/ a &= readmem(pc);
-                        pc++;
+                        /*AND*/ a &= fetch_byte();
                         setzn(a);
                         polltime(2);
                         takeint = (interrupt && !p.i);
@@ -1778,8 +2082,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x2B:      /*Undocumented - ANC imm */
-                        a &= readmem(pc);
-                        pc++;
+                        a &= fetch_byte();
                         setzn(a);
                         p.c = p.n;
                         polltime(2);
@@ -1787,7 +2090,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x2C:      /*BIT abs */
-                        addr = getw();
+                        addr = fetch_word();
                         polltime(4);
                         takeint = (interrupt && !p.i);
                         temp = readmem(addr);
@@ -1797,7 +2100,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x2D:      /*AND abs */
-                        addr = getw();
+                        addr = fetch_word();
                         polltime(4);
                         takeint = (interrupt && !p.i);
                         a &= readmem(addr);
@@ -1805,7 +2108,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x2E:      /*ROL abs */
-                        addr = getw();
+                        addr = fetch_word();
                         polltime(4);
                         temp = readmem(addr);
                         polltime(1);
@@ -1824,7 +2127,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x2F:      /*Undocumented - RLA abs */
-                        addr = getw();  /*Found in The Hobbit */
+                        addr = fetch_word();  /*Found in The Hobbit */
                         temp = readmem(addr);
                         tempi = p.c;
                         p.c = temp & 0x80;
@@ -1839,8 +2142,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x30:
-                        /*BMI*/ offset = (int8_t) readmem(pc);
-                        pc++;
+                        /*BMI*/ offset = (int8_t) fetch_byte();
                         temp = 2;
                         if (p.n) {
                                 temp++;
@@ -1852,8 +2154,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x31:      /*AND (),y */
-                        temp = readmem(pc);
-                        pc++;
+                        temp = fetch_byte();
                         addr = read_zp_indirect(temp);
                         if ((addr & 0xFF00) ^ ((addr + y) & 0xFF00))
                                 polltime(1);
@@ -1864,8 +2165,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x33:      /*Undocumented - RLA (),y */
-                        temp = readmem(pc);
-                        pc++;
+                        temp = fetch_byte();
                         addr = read_zp_indirect(temp);
                         polltime(6);
                         temp = readmem(addr + y);
@@ -1884,16 +2184,14 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x34:      /*Undocumented - NOP zp,x */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         readmem((addr + x) & 0xFF);
                         polltime(4);
                         takeint = (interrupt && !p.i);
                         break;
 
                 case 0x35:      /*AND zp,x */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         a &= readmem((addr + x) & 0xFF);
                         setzn(a);
                         polltime(4);
@@ -1901,8 +2199,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x36:      /*ROL zp,x */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         addr += x;
                         addr &= 0xFF;
                         temp = readmem(addr);
@@ -1918,8 +2215,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x37:      /*Undocumented - RLA zp,x */
-                        addr = (readmem(pc) + x) & 0xFF;
-                        pc++;
+                        addr = (fetch_byte() + x) & 0xFF;
                         temp = readmem(addr);
                         tempi = p.c;
                         p.c = temp & 0x80;
@@ -1940,7 +2236,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x39:      /*AND abs,y */
-                        addr = getw();
+                        addr = fetch_word();
                         if ((addr & 0xFF00) ^ ((addr + y) & 0xFF00))
                                 polltime(1);
                         a &= readmem(addr + y);
@@ -1955,7 +2251,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x3B:      /*Undocumented - RLA abs,y */
-                        addr = getw() + y;
+                        addr = fetch_word() + y;
                         polltime(5);
                         temp = readmem(addr);
                         polltime(1);
@@ -1973,7 +2269,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x3C:      /*Undocumented - NOP abs,x */
-                        addr = getw();
+                        addr = fetch_word();
                         if ((addr & 0xFF00) ^ ((addr + x) & 0xFF00))
                                 polltime(1);
                         readmem(addr + x);
@@ -1982,7 +2278,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x3D:      /*AND abs,x */
-                        addr = getw();
+                        addr = fetch_word();
                         if ((addr & 0xFF00) ^ ((addr + x) & 0xFF00))
                                 polltime(1);
                         addr += x;
@@ -1993,7 +2289,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x3E:      /*ROL abs,x */
-                        addr = getw();
+                        addr = fetch_word();
                         readmem((addr & 0xFF00) | ((addr + x) & 0xFF));
                         addr += x;
                         temp = readmem(addr);
@@ -2010,7 +2306,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x3F:      /*Undocumented - RLA abs,x */
-                        addr = getw() + x;
+                        addr = fetch_word() + x;
                         polltime(5);
                         temp = readmem(addr);
                         polltime(1);
@@ -2038,8 +2334,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x41:      /*EOR (,x) */
-                        temp = readmem(pc) + x;
-                        pc++;
+                        temp = fetch_byte() + x;
                         addr = read_zp_indirect(temp);
                         a ^= readmem(addr);
                         setzn(a);
@@ -2048,8 +2343,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x43:      /*Undocumented - SRE (,x) */
-                        temp = readmem(pc) + x;
-                        pc++;
+                        temp = fetch_byte() + x;
                         addr = read_zp_indirect(temp);
                         polltime(6);
                         temp = readmem(addr);
@@ -2065,16 +2359,14 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x44:      /*Undocumented - NOP zp */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         readmem(addr);
                         polltime(3);
                         takeint = (interrupt && !p.i);
                         break;
 
                 case 0x45:      /*EOR zp */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         a ^= readmem(addr);
                         setzn(a);
                         polltime(3);
@@ -2082,8 +2374,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x46:      /*LSR zp */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         temp = readmem(addr);
                         p.c = temp & 1;
                         temp >>= 1;
@@ -2094,8 +2385,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x47:      /*Undocumented - SRE zp */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         polltime(3);
                         temp = readmem(addr);
                         polltime(1);
@@ -2116,8 +2406,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x49:      /*EOR imm */
-                        a ^= readmem(pc);
-                        pc++;
+                        a ^= fetch_byte();
                         setzn(a);
                         polltime(2);
                         takeint = (interrupt && !p.i);
@@ -2132,8 +2421,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x4B:      /*Undocumented - ASR imm */
-                        a &= readmem(pc);
-                        pc++;
+                        a &= fetch_byte();
                         p.c = a & 1;
                         a >>= 1;
                         setzn(a);
@@ -2142,14 +2430,14 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x4C:
-                        /*JMP*/ addr = getw();
+                        /*JMP*/ addr = fetch_word();
                         pc = addr;
                         polltime(3);
                         takeint = (interrupt && !p.i);
                         break;
 
                 case 0x4D:      /*EOR abs */
-                        addr = getw();
+                        addr = fetch_word();
                         polltime(4);
                         takeint = (interrupt && !p.i);
                         a ^= readmem(addr);
@@ -2157,7 +2445,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x4E:      /*LSR abs */
-                        addr = getw();
+                        addr = fetch_word();
                         polltime(4);
                         temp = readmem(addr);
                         polltime(1);
@@ -2173,7 +2461,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x4F:      /*Undocumented - SRE abs */
-                        addr = getw();
+                        addr = fetch_word();
                         polltime(4);
                         temp = readmem(addr);
                         polltime(1);
@@ -2188,8 +2476,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x50:
-                        /*BVC*/ offset = (int8_t) readmem(pc);
-                        pc++;
+                        /*BVC*/ offset = (int8_t) fetch_byte();
                         temp = 2;
                         if (!p.v) {
                                 temp++;
@@ -2201,8 +2488,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x51:      /*EOR (),y */
-                        temp = readmem(pc);
-                        pc++;
+                        temp = fetch_byte();
                         addr = read_zp_indirect(temp);
                         if ((addr & 0xFF00) ^ ((addr + y) & 0xFF00))
                                 polltime(1);
@@ -2213,8 +2499,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x53:      /*Undocumented - SRE (),y */
-                        temp = readmem(pc);
-                        pc++;
+                        temp = fetch_byte();
                         addr = read_zp_indirect(temp) + y;
                         polltime(6);
                         temp = readmem(addr);
@@ -2230,16 +2515,14 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x54:      /*Undocumented - NOP zp,x */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         readmem((addr + x) & 0xFF);
                         polltime(4);
                         takeint = (interrupt && !p.i);
                         break;
 
                 case 0x55:      /*EOR zp,x */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         a ^= readmem((addr + x) & 0xFF);
                         setzn(a);
                         polltime(4);
@@ -2247,8 +2530,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x56:      /*LSR zp,x */
-                        addr = (readmem(pc) + x) & 0xFF;
-                        pc++;
+                        addr = (fetch_byte() + x) & 0xFF;
                         temp = readmem(addr);
                         p.c = temp & 1;
                         temp >>= 1;
@@ -2259,8 +2541,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x57:      /*Undocumented - SRE zp,x */
-                        addr = (readmem(pc) + x) & 0xFF;
-                        pc++;
+                        addr = (fetch_byte() + x) & 0xFF;
                         polltime(3);
                         temp = readmem(addr);
                         polltime(1);
@@ -2282,7 +2563,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x59:      /*EOR abs,y */
-                        addr = getw();
+                        addr = fetch_word();
                         if ((addr & 0xFF00) ^ ((addr + y) & 0xFF00))
                                 polltime(1);
                         a ^= readmem(addr + y);
@@ -2297,7 +2578,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x5B:      /*Undocumented - SRE abs,y */
-                        addr = getw() + y;
+                        addr = fetch_word() + y;
                         polltime(5);
                         temp = readmem(addr + y);
                         polltime(1);
@@ -2312,7 +2593,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x5C:      /*Undocumented - NOP abs,x */
-                        addr = getw();
+                        addr = fetch_word();
                         polltime(4);
                         if ((addr & 0xFF00) ^ ((addr + x) & 0xFF00)) {
                                 readmem((addr & 0xFF00) | ((addr + x) & 0xFF));
@@ -2323,7 +2604,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x5D:      /*EOR abs,x */
-                        addr = getw();
+                        addr = fetch_word();
                         polltime(4);
                         if ((addr & 0xFF00) ^ ((addr + x) & 0xFF00)) {
                                 readmem((addr & 0xFF00) | ((addr + x) & 0xFF));
@@ -2336,7 +2617,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x5E:      /*LSR abs,x */
-                        addr = getw();
+                        addr = fetch_word();
                         readmem((addr & 0xFF00) | ((addr + x) & 0xFF));
                         addr += x;
                         temp = readmem(addr);
@@ -2350,7 +2631,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x5F:      /*Undocumented - SRE abs,x */
-                        addr = getw() + x;
+                        addr = fetch_word() + x;
                         polltime(5);
                         temp = readmem(addr + x);
                         polltime(1);
@@ -2374,8 +2655,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x61:      /*ADC (,x) */
-                        temp = readmem(pc) + x;
-                        pc++;
+                        temp = fetch_byte() + x;
                         addr = read_zp_indirect(temp);
                         temp = readmem(addr);
                         adc_nmos(temp);
@@ -2384,8 +2664,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x63:      /*Undocumented - RRA (,x) */
-                        temp = readmem(pc) + x;
-                        pc++;
+                        temp = fetch_byte() + x;
                         addr = read_zp_indirect(temp);
                         polltime(6);
                         temp = readmem(addr);
@@ -2403,16 +2682,14 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x64:      /*Undocumented - NOP zp */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         readmem(addr);
                         polltime(3);
                         takeint = (interrupt && !p.i);
                         break;
 
                 case 0x65:      /*ADC zp */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         temp = readmem(addr);
                         adc_nmos(temp);
                         polltime(3);
@@ -2420,8 +2697,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x66:      /*ROR zp */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         temp = readmem(addr);
                         tempi = p.c;
                         p.c = temp & 1;
@@ -2435,8 +2711,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x67:      /*Undocumented - RRA zp */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         polltime(3);
                         temp = readmem(addr);
                         polltime(1);
@@ -2460,8 +2735,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x69:      /*ADC imm */
-                        temp = readmem(pc);
-                        pc++;
+                        temp = fetch_byte();
                         adc_nmos(temp);
                         polltime(2);
                         takeint = (interrupt && !p.i);
@@ -2483,7 +2757,7 @@ void m6502_exec(int slice)
                     break;
 
                 case 0x6C:      /*JMP () */
-                        addr = getw();
+                        addr = fetch_word();
                         if ((addr & 0xFF) == 0xFF)
                                 pc = readmem(addr) | (readmem(addr - 0xFF) <<
                                                       8);
@@ -2494,7 +2768,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x6D:      /*ADC abs */
-                        addr = getw();
+                        addr = fetch_word();
                         polltime(4);
                         takeint = (interrupt && !p.i);
                         temp = readmem(addr);
@@ -2502,7 +2776,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x6E:      /*ROR abs */
-                        addr = getw();
+                        addr = fetch_word();
                         polltime(4);
                         temp = readmem(addr);
                         polltime(1);
@@ -2523,7 +2797,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x6F:      /*Undocumented - RRA abs */
-                        addr = getw();
+                        addr = fetch_word();
                         polltime(4);
                         temp = readmem(addr);
                         polltime(1);
@@ -2540,8 +2814,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x70:
-                        /*BVS*/ offset = (int8_t) readmem(pc);
-                        pc++;
+                        /*BVS*/ offset = (int8_t) fetch_byte();
                         temp = 2;
                         if (p.v) {
                                 temp++;
@@ -2553,8 +2826,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x71:      /*ADC (),y */
-                        temp = readmem(pc);
-                        pc++;
+                        temp = fetch_byte();
                         addr = read_zp_indirect(temp);
                         if ((addr & 0xFF00) ^ ((addr + y) & 0xFF00))
                                 polltime(1);
@@ -2565,8 +2837,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x73:      /*Undocumented - RRA (,y) */
-                        temp = readmem(pc);
-                        pc++;
+                        temp = fetch_byte();
                         addr = read_zp_indirect(temp);
                         polltime(6);
                         temp = readmem(addr);
@@ -2584,16 +2855,14 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x74:      /*Undocumented - NOP zp,x */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         readmem((addr + x) & 0xFF);
                         polltime(4);
                         takeint = (interrupt && !p.i);
                         break;
 
                 case 0x75:      /*ADC zp,x */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         temp = readmem((addr + x) & 0xFF);
                         adc_nmos(temp);
                         polltime(4);
@@ -2601,8 +2870,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x76:      /*ROR zp,x */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         addr += x;
                         addr &= 0xFF;
                         temp = readmem(addr);
@@ -2618,8 +2886,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x77:      /*Undocumented - RRA zp,x */
-                        addr = (readmem(pc) + x) & 0xFF;
-                        pc++;
+                        addr = (fetch_byte() + x) & 0xFF;
                         polltime(3);
                         temp = readmem(addr);
                         polltime(1);
@@ -2643,7 +2910,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x79:      /*ADC abs,y */
-                        addr = getw();
+                        addr = fetch_word();
                         if ((addr & 0xFF00) ^ ((addr + y) & 0xFF00))
                                 polltime(1);
                         temp = readmem(addr + y);
@@ -2658,7 +2925,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x7B:      /*Undocumented - RRA abs,y */
-                        addr = getw() + y;
+                        addr = fetch_word() + y;
                         polltime(5);
                         temp = readmem(addr);
                         polltime(1);
@@ -2675,7 +2942,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x7C:      /*Undocumented - NOP abs,x */
-                        addr = getw();
+                        addr = fetch_word();
                         if ((addr & 0xFF00) ^ ((addr + x) & 0xFF00))
                                 polltime(1);
                         readmem(addr);
@@ -2684,7 +2951,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x7D:      /*ADC abs,x */
-                        addr = getw();
+                        addr = fetch_word();
                         if ((addr & 0xFF00) ^ ((addr + x) & 0xFF00))
                                 polltime(1);
                         addr += x;
@@ -2695,7 +2962,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x7E:      /*ROR abs,x */
-                        addr = getw();
+                        addr = fetch_word();
                         readmem((addr & 0xFF00) | ((addr + x) & 0xFF));
                         addr += x;
                         temp = readmem(addr);
@@ -2712,7 +2979,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x7F:      /*Undocumented - RRA abs,x */
-                        addr = getw();
+                        addr = fetch_word();
                         polltime(5);
                         temp = readmem(addr + x);
                         polltime(1);
@@ -2729,15 +2996,13 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x80:      /*Undocumented - NOP imm */
-                        readmem(pc);
-                        pc++;
+                        fetch_byte();
                         polltime(2);
                         takeint = (interrupt && !p.i);
                         break;
 
                 case 0x81:      /*STA (,x) */
-                        temp = readmem(pc) + x;
-                        pc++;
+                        temp = fetch_byte() + x;
                         addr = read_zp_indirect(temp);
                         writemem(addr, a);
                         polltime(6);
@@ -2745,15 +3010,13 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x82:      /*Undocumented - NOP imm *//*Should sometimes lock up the machine */
-                        readmem(pc);
-                        pc++;
+                        fetch_byte();
                         polltime(2);
                         takeint = (interrupt && !p.i);
                         break;
 
                 case 0x83:      /*Undocumented - SAX (,x) */
-                        temp = readmem(pc) + x;
-                        pc++;
+                        temp = fetch_byte() + x;
                         addr = read_zp_indirect(temp);
                         writemem(addr, a & x);
                         polltime(6);
@@ -2761,32 +3024,28 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x84:      /*STY zp */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         writemem(addr, y);
                         polltime(3);
                         takeint = (interrupt && !p.i);
                         break;
 
                 case 0x85:      /*STA zp */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         writemem(addr, a);
                         polltime(3);
                         takeint = (interrupt && !p.i);
                         break;
 
                 case 0x86:      /*STX zp */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         writemem(addr, x);
                         polltime(3);
                         takeint = (interrupt && !p.i);
                         break;
 
                 case 0x87:      /*Undocumented - SAX zp */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         writemem(addr, a & x);
                         polltime(3);
                         takeint = (interrupt && !p.i);
@@ -2800,8 +3059,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x89:      /*Undocumented - NOP imm */
-                        readmem(pc);
-                        pc++;
+                        fetch_byte();
                         polltime(2);
                         takeint = (interrupt && !p.i);
                         break;
@@ -2814,8 +3072,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x8B:      /*Undocumented - ANE */
-                        temp = readmem(pc);
-                        pc++;
+                        temp = fetch_byte();
                         a = (a | 0xEE) & x & temp;      /*Internal parameter always 0xEE on BBC, always 0xFF on Electron */
                         setzn(a);
                         polltime(2);
@@ -2823,36 +3080,35 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x8C:      /*STY abs */
-                        addr = getw();
+                        addr = fetch_word();
                         polltime(4);
                         takeint = (interrupt && !p.i);
                         writemem(addr, y);
                         break;
 
                 case 0x8D:      /*STA abs */
-                        addr = getw();
+                        addr = fetch_word();
                         polltime(4);
                         takeint = (interrupt && !p.i);
                         writemem(addr, a);
                         break;
 
                 case 0x8E:      /*STX abs */
-                        addr = getw();
+                        addr = fetch_word();
                         polltime(4);
                         takeint = (interrupt && !p.i);
                         writemem(addr, x);
                         break;
 
                 case 0x8F:      /*Undocumented - SAX abs */
-                        addr = getw();
+                        addr = fetch_word();
                         polltime(4);
                         takeint = (interrupt && !p.i);
                         writemem(addr, a & x);
                         break;
 
                 case 0x90:
-                        /*BCC*/ offset = (int8_t) readmem(pc);
-                        pc++;
+                        /*BCC*/ offset = (int8_t) fetch_byte();
                         temp = 2;
                         if (!p.c) {
                                 temp++;
@@ -2864,8 +3120,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x91:      /*STA (),y */
-                        temp = readmem(pc);
-                        pc++;
+                        temp = fetch_byte();
                         addr = read_zp_indirect(temp) + y;
                         writemem(addr, a);
                         polltime(6);
@@ -2873,8 +3128,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x93:      /*Undocumented - SHA (),y */
-                        temp = readmem(pc);
-                        pc++;
+                        temp = fetch_byte();
                         addr = read_zp_indirect(temp);
                         writemem(addr + y, a & x & ((addr >> 8) + 1));
                         polltime(6);
@@ -2882,32 +3136,28 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x94:      /*STY zp,x */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         writemem((addr + x) & 0xFF, y);
                         polltime(4);
                         takeint = (interrupt && !p.i);
                         break;
 
                 case 0x95:      /*STA zp,x */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         writemem((addr + x) & 0xFF, a);
                         polltime(4);
                         takeint = (interrupt && !p.i);
                         break;
 
                 case 0x96:      /*STX zp,y */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         writemem((addr + y) & 0xFF, x);
                         polltime(4);
                         takeint = (interrupt && !p.i);
                         break;
 
                 case 0x97:      /*Undocumented - SAX zp,y */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         writemem((addr + y) & 0xFF, a & x);
                         polltime(4);
                         takeint = (interrupt && !p.i);
@@ -2921,7 +3171,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x99:      /*STA abs,y */
-                        addr = getw();
+                        addr = fetch_word();
                         polltime(4);
                         readmem((addr & 0xFF00) | ((addr + y) & 0xFF));
                         polltime(1);
@@ -2936,7 +3186,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x9B:      /*Undocumented - SHS abs,y */
-                        addr = getw();
+                        addr = fetch_word();
                         readmem((addr & 0xFF00) + ((addr + y) & 0xFF));
                         writemem(addr + y, a & x & ((addr >> 8) + 1));
                         s = a & x;
@@ -2945,7 +3195,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x9C:      /*Undocumented - SHY abs,x */
-                        addr = getw();
+                        addr = fetch_word();
                         readmem((addr & 0xFF00) + ((addr + x) & 0xFF));
                         writemem(addr + x, y & ((addr >> 8) + 1));
                         polltime(5);
@@ -2953,7 +3203,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x9D:      /*STA abs,x */
-                        addr = getw();
+                        addr = fetch_word();
                         polltime(4);
                         readmem((addr & 0xFF00) | ((addr + x) & 0xFF));
                         polltime(1);
@@ -2962,7 +3212,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x9E:      /*Undocumented - SHX abs,y */
-                        addr = getw();
+                        addr = fetch_word();
                         polltime(4);
                         readmem((addr & 0xFF00) | ((addr + x) & 0xFF));
                         polltime(1);
@@ -2971,7 +3221,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0x9F:      /*Undocumented - SHA abs,y */
-                        addr = getw();
+                        addr = fetch_word();
                         polltime(4);
                         readmem((addr & 0xFF00) | ((addr + x) & 0xFF));
                         polltime(1);
@@ -2980,16 +3230,14 @@ void m6502_exec(int slice)
                         break;
 
                 case 0xA0:      /*LDY imm */
-                        y = readmem(pc);
-                        pc++;
+                        y = fetch_byte();
                         setzn(y);
                         polltime(2);
                         takeint = (interrupt && !p.i);
                         break;
 
                 case 0xA1:      /*LDA (,x) */
-                        temp = readmem(pc) + x;
-                        pc++;
+                        temp = fetch_byte() + x;
                         addr = read_zp_indirect(temp);
                         a = readmem(addr);
                         setzn(a);
@@ -2998,16 +3246,14 @@ void m6502_exec(int slice)
                         break;
 
                 case 0xA2:      /*LDX imm */
-                        x = readmem(pc);
-                        pc++;
+                        x = fetch_byte();
                         setzn(x);
                         polltime(2);
                         takeint = (interrupt && !p.i);
                         break;
 
                 case 0xA3:      /*Undocumented - LAX (,y) */
-                        temp = readmem(pc) + x;
-                        pc++;
+                        temp = fetch_byte() + x;
                         addr = read_zp_indirect(temp);
                         a = x = readmem(addr);
                         setzn(a);
@@ -3016,8 +3262,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0xA4:      /*LDY zp */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         y = readmem(addr);
                         setzn(y);
                         polltime(3);
@@ -3025,8 +3270,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0xA5:      /*LDA zp */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         a = readmem(addr);
                         setzn(a);
                         polltime(3);
@@ -3034,8 +3278,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0xA6:      /*LDX zp */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         x = readmem(addr);
                         setzn(x);
                         polltime(3);
@@ -3043,8 +3286,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0xA7:      /*Undocumented - LAX zp */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         a = x = readmem(addr);
                         setzn(a);
                         polltime(3);
@@ -3059,8 +3301,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0xA9:      /*LDA imm */
-                        a = readmem(pc);
-                        pc++;
+                        a = fetch_byte();
                         setzn(a);
                         polltime(1);
                         takeint = (interrupt && !p.i);
@@ -3075,8 +3316,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0xAB:      /*Undocumented - LAX */
-                        temp = readmem(pc);
-                        pc++;
+                        temp = fetch_byte();
                         a = x = ((a | 0xEE) & temp);    /*WAAAAY more complicated than this, but it varies from machine to machine anyway */
                         setzn(a);
                         polltime(2);
@@ -3084,7 +3324,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0xAC:      /*LDY abs */
-                        addr = getw();
+                        addr = fetch_word();
                         polltime(4);
                         takeint = (interrupt && !p.i);
                         y = readmem(addr);
@@ -3092,7 +3332,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0xAD:      /*LDA abs */
-                        addr = getw();
+                        addr = fetch_word();
                         polltime(4);
                         takeint = (interrupt && !p.i);
                         a = readmem(addr);
@@ -3100,7 +3340,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0xAE:      /*LDX abs */
-                        addr = getw();
+                        addr = fetch_word();
                         polltime(4);
                         takeint = (interrupt && !p.i);
                         x = readmem(addr);
@@ -3108,7 +3348,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0xAF:      /*LAX abs */
-                        addr = getw();
+                        addr = fetch_word();
                         polltime(4);
                         takeint = (interrupt && !p.i);
                         a = x = readmem(addr);
@@ -3116,8 +3356,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0xB0:
-                        /*BCS*/ offset = (int8_t) readmem(pc);
-                        pc++;
+                        /*BCS*/ offset = (int8_t) fetch_byte();
                         temp = 2;
                         if (p.c) {
                                 temp++;
@@ -3129,8 +3368,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0xB1:      /*LDA (),y */
-                        temp = readmem(pc);
-                        pc++;
+                        temp = fetch_byte();
                         addr = read_zp_indirect(temp);
                         if ((addr & 0xFF00) ^ ((addr + y) & 0xFF00))
                                 polltime(1);
@@ -3141,8 +3379,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0xB3:      /*LAX (),y */
-                        temp = readmem(pc);
-                        pc++;
+                        temp = fetch_byte();
                         addr = read_zp_indirect(temp);
                         if ((addr & 0xFF00) ^ ((addr + y) & 0xFF00))
                                 polltime(1);
@@ -3153,8 +3390,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0xB4:      /*LDY zp,x */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         y = readmem((addr + x) & 0xFF);
                         setzn(y);
                         polltime(4);
@@ -3162,8 +3398,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0xB5:      /*LDA zp,x */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         a = readmem((addr + x) & 0xFF);
                         setzn(a);
                         polltime(4);
@@ -3171,8 +3406,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0xB6:      /*LDX zp,y */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         x = readmem((addr + y) & 0xFF);
                         setzn(x);
                         polltime(4);
@@ -3180,8 +3414,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0xB7:      /*LAX zp,y */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         a = x = readmem((addr + y) & 0xFF);
                         setzn(a);
                         polltime(4);
@@ -3195,7 +3428,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0xB9:      /*LDA abs,y */
-                        addr = getw();
+                        addr = fetch_word();
                         polltime(3);
                         if ((addr & 0xFF00) ^ ((addr + y) & 0xFF00))
                                 polltime(1);
@@ -3213,7 +3446,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0xBB:      /*Undocumented - LAS abs,y */
-                        addr = getw();
+                        addr = fetch_word();
                         polltime(3);
                         if ((addr & 0xFF00) ^ ((addr + y) & 0xFF00))
                                 polltime(1);
@@ -3224,7 +3457,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0xBC:      /*LDY abs,x */
-                        addr = getw();
+                        addr = fetch_word();
                         if ((addr & 0xFF00) ^ ((addr + x) & 0xFF00))
                                 polltime(1);
                         y = readmem(addr + x);
@@ -3234,7 +3467,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0xBD:      /*LDA abs,x */
-                        addr = getw();
+                        addr = fetch_word();
                         if ((addr & 0xFF00) ^ ((addr + x) & 0xFF00))
                                 polltime(1);
                         a = readmem(addr + x);
@@ -3244,7 +3477,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0xBE:      /*LDX abs,y */
-                        addr = getw();
+                        addr = fetch_word();
                         if ((addr & 0xFF00) ^ ((addr + y) & 0xFF00))
                                 polltime(1);
                         x = readmem(addr + y);
@@ -3254,7 +3487,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0xBF:      /*LAX abs,y */
-                        addr = getw();
+                        addr = fetch_word();
                         if ((addr & 0xFF00) ^ ((addr + y) & 0xFF00))
                                 polltime(1);
                         a = x = readmem(addr + y);
@@ -3264,8 +3497,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0xC0:      /*CPY imm */
-                        temp = readmem(pc);
-                        pc++;
+                        temp = fetch_byte();
                         setzn(y - temp);
                         p.c = (y >= temp);
                         polltime(2);
@@ -3273,8 +3505,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0xC1:      /*CMP (,x) */
-                        temp = readmem(pc) + x;
-                        pc++;
+                        temp = fetch_byte() + x;
                         addr = read_zp_indirect(temp);
                         temp = readmem(addr);
                         setzn(a - temp);
@@ -3284,15 +3515,13 @@ void m6502_exec(int slice)
                         break;
 
                 case 0xC2:      /*Undocumented - NOP imm *//*Should sometimes lock up the machine */
-                        readmem(pc);
-                        pc++;
+                        fetch_byte();
                         polltime(2);
                         takeint = (interrupt && !p.i);
                         break;
 
                 case 0xC3:      /*Undocumented - DCP (,x) */
-                        temp = readmem(pc) + x;
-                        pc++;
+                        temp = fetch_byte() + x;
                         addr = read_zp_indirect(temp);
                         polltime(6);
                         temp = readmem(addr);
@@ -3307,8 +3536,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0xC4:      /*CPY zp */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         temp = readmem(addr);
                         setzn(y - temp);
                         p.c = (y >= temp);
@@ -3317,8 +3545,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0xC5:      /*CMP zp */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         temp = readmem(addr);
                         setzn(a - temp);
                         p.c = (a >= temp);
@@ -3327,8 +3554,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0xC6:      /*DEC zp */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         temp = readmem(addr) - 1;
                         writemem(addr, temp);
                         setzn(temp);
@@ -3337,8 +3563,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0xC7:      /*Undocumented - DCP zp */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         temp = readmem(addr) - 1;
                         writemem(addr, temp);
                         setzn(a - temp);
@@ -3355,8 +3580,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0xC9:      /*CMP imm */
-                        temp = readmem(pc);
-                        pc++;
+                        temp = fetch_byte();
                         setzn(a - temp);
                         p.c = (a >= temp);
                         polltime(2);
@@ -3371,8 +3595,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0xCB:      /*Undocumented - SBX imm */
-                        temp = readmem(pc);
-                        pc++;
+                        temp = fetch_byte();
                         setzn((a & x) - temp);
                         p.c = ((a & x) >= temp);
                         x = (a & x) - temp;
@@ -3381,7 +3604,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0xCC:      /*CPY abs */
-                        addr = getw();
+                        addr = fetch_word();
                         polltime(4);
                         takeint = (interrupt && !p.i);
                         temp = readmem(addr);
@@ -3390,7 +3613,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0xCD:      /*CMP abs */
-                        addr = getw();
+                        addr = fetch_word();
                         polltime(4);
                         takeint = (interrupt && !p.i);
                         temp = readmem(addr);
@@ -3399,7 +3622,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0xCE:      /*DEC abs */
-                        addr = getw();
+                        addr = fetch_word();
                         polltime(4);
                         temp = readmem(addr) - 1;
                         polltime(1);
@@ -3414,7 +3637,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0xCF:      /*Undocumented - DCP abs */
-                        addr = getw();
+                        addr = fetch_word();
                         temp = readmem(addr) - 1;
                         writemem(addr, temp);
                         setzn(a - temp);
@@ -3424,8 +3647,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0xD0:
-                        /*BNE*/ offset = (int8_t) readmem(pc);
-                        pc++;
+                        /*BNE*/ offset = (int8_t) fetch_byte();
                         temp = 2;
                         if (!p.z) {
                                 temp++;
@@ -3437,8 +3659,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0xD1:      /*CMP (),y */
-                        temp = readmem(pc);
-                        pc++;
+                        temp = fetch_byte();
                         addr = read_zp_indirect(temp);
                         if ((addr & 0xFF00) ^ ((addr + y) & 0xFF00))
                                 polltime(1);
@@ -3450,8 +3671,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0xD3:      /*Undocumented - DCP (),y */
-                        temp = readmem(pc);
-                        pc++;
+                        temp = fetch_byte();
                         addr = read_zp_indirect(temp) + y;
                         polltime(6);
                         temp = readmem(addr);
@@ -3465,16 +3685,14 @@ void m6502_exec(int slice)
                         break;
 
                 case 0xD4:      /*Undocumented - NOP zp,x */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         readmem((addr + x) & 0xFF);
                         polltime(4);
                         takeint = (interrupt && !p.i);
                         break;
 
                 case 0xD5:      /*CMP zp,x */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         temp = readmem((addr + x) & 0xFF);
                         setzn(a - temp);
                         p.c = (a >= temp);
@@ -3483,8 +3701,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0xD6:      /*DEC zp,x */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         temp = readmem((addr + x) & 0xFF) - 1;
                         setzn(temp);
                         writemem((addr + x) & 0xFF, temp);
@@ -3493,8 +3710,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0xD7:      /*Undocumented - DCP zp,x */
-                        addr = (readmem(pc) + x) & 0xFF;
-                        pc++;
+                        addr = (fetch_byte() + x) & 0xFF;
                         temp = readmem(addr) - 1;
                         writemem(addr, temp);
                         setzn(a - temp);
@@ -3510,7 +3726,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0xD9:      /*CMP abs,y */
-                        addr = getw();
+                        addr = fetch_word();
                         if ((addr & 0xFF00) ^ ((addr + y) & 0xFF00))
                                 polltime(1);
                         temp = readmem(addr + y);
@@ -3526,7 +3742,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0xDB:      /*Undocumented - DCP abs,y */
-                        addr = getw();
+                        addr = fetch_word();
                         readmem((addr & 0xFF00) | ((addr + x) & 0xFF));
                         addr += y;
                         polltime(5);
@@ -3541,7 +3757,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0xDC:      /*Undocumented - NOP abs,x */
-                        addr = getw();
+                        addr = fetch_word();
                         if ((addr & 0xFF00) ^ ((addr + x) & 0xFF00))
                                 polltime(1);
                         readmem(addr + x);
@@ -3550,7 +3766,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0xDD:      /*CMP abs,x */
-                        addr = getw();
+                        addr = fetch_word();
                         if ((addr & 0xFF00) ^ ((addr + x) & 0xFF00))
                                 polltime(1);
                         temp = readmem(addr + x);
@@ -3561,7 +3777,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0xDE:      /*DEC abs,x */
-                        addr = getw();
+                        addr = fetch_word();
                         readmem((addr & 0xFF00) | ((addr + x) & 0xFF));
                         addr += x;
                         polltime(5);
@@ -3575,7 +3791,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0xDF:      /*Undocumented - DCP abs,x */
-                        addr = getw();
+                        addr = fetch_word();
                         readmem((addr & 0xFF00) | ((addr + x) & 0xFF));
                         addr += x;
                         polltime(5);
@@ -3590,8 +3806,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0xE0:      /*CPX imm */
-                        temp = readmem(pc);
-                        pc++;
+                        temp = fetch_byte();
                         setzn(x - temp);
                         p.c = (x >= temp);
                         polltime(2);
@@ -3599,8 +3814,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0xE1:      /*SBC (,x) *//*This was missed out of every B-em version since 0.6 as it was never used! */
-                        temp = readmem(pc) + x;
-                        pc++;
+                        temp = fetch_byte() + x;
                         addr = read_zp_indirect(temp);
                         temp = readmem(addr);
                         sbc_nmos(temp);
@@ -3609,15 +3823,13 @@ void m6502_exec(int slice)
                         break;
 
                 case 0xE2:      /*Undocumented - NOP imm *//*Should sometimes lock up the machine */
-                        readmem(pc);
-                        pc++;
+                        fetch_byte();
                         polltime(2);
                         takeint = (interrupt && !p.i);
                         break;
 
                 case 0xE3:      /*Undocumented - ISB (,x) */
-                        temp = readmem(pc) + x;
-                        pc++;
+                        temp = fetch_byte() + x;
                         addr = read_zp_indirect(temp);
                         polltime(6);
                         temp = readmem(addr);
@@ -3631,8 +3843,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0xE4:      /*CPX zp */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         temp = readmem(addr);
                         setzn(x - temp);
                         p.c = (x >= temp);
@@ -3641,8 +3852,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0xE5:      /*SBC zp */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         temp = readmem(addr);
                         sbc_nmos(temp);
                         polltime(3);
@@ -3650,8 +3860,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0xE6:      /*INC zp */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         temp = readmem(addr) + 1;
                         writemem(addr, temp);
                         setzn(temp);
@@ -3660,8 +3869,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0xE7:      /*Undocumented - ISB zp */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         polltime(3);
                         temp = readmem(addr);
                         polltime(1);
@@ -3681,8 +3889,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0xE9:      /*SBC imm */
-                        temp = readmem(pc);
-                        pc++;
+                        temp = fetch_byte();
                         sbc_nmos(temp);
                         polltime(2);
                         takeint = (interrupt && !p.i);
@@ -3694,15 +3901,14 @@ void m6502_exec(int slice)
                         break;
 
                 case 0xEB:      /*Undocumented - SBC imm */
-                        temp = readmem(pc);
-                        pc++;
+                        temp = fetch_byte();
                         sbc_nmos(temp);
                         polltime(2);
                         takeint = (interrupt && !p.i);
                         break;
 
                 case 0xEC:      /*CPX abs */
-                        addr = getw();
+                        addr = fetch_word();
                         polltime(4);
                         takeint = (interrupt && !p.i);
                         temp = readmem(addr);
@@ -3711,7 +3917,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0xED:      /*SBC abs */
-                        addr = getw();
+                        addr = fetch_word();
                         polltime(4);
                         takeint = (interrupt && !p.i);
                         temp = readmem(addr);
@@ -3719,7 +3925,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0xEE:      /*INC abs */
-                        addr = getw();
+                        addr = fetch_word();
                         polltime(4);
                         temp = readmem(addr) + 1;
                         polltime(1);
@@ -3734,7 +3940,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0xEF:      /*Undocumented - ISB abs */
-                        addr = getw();
+                        addr = fetch_word();
                         polltime(4);
                         temp = readmem(addr);
                         polltime(1);
@@ -3747,8 +3953,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0xF0:
-                        /*BEQ*/ offset = (int8_t) readmem(pc);
-                        pc++;
+                        /*BEQ*/ offset = (int8_t) fetch_byte();
                         temp = 2;
                         if (p.z) {
                                 temp++;
@@ -3761,8 +3966,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0xF1:      /*SBC (),y */
-                        temp = readmem(pc);
-                        pc++;
+                        temp = fetch_byte();
                         addr = read_zp_indirect(temp);
                         if ((addr & 0xFF00) ^ ((addr + y) & 0xFF00))
                                 polltime(1);
@@ -3773,8 +3977,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0xF3:      /*Undocumented - ISB (),y */
-                        temp = readmem(pc);
-                        pc++;
+                        temp = fetch_byte();
                         addr = read_zp_indirect(temp) + y;
                         polltime(6);
                         temp = readmem(addr);
@@ -3788,15 +3991,13 @@ void m6502_exec(int slice)
                         break;
 
                 case 0xF4:      /*Undocumented - NOP zpx */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         polltime(4);
                         takeint = (interrupt && !p.i);
                         break;
 
                 case 0xF5:      /*SBC zp,x */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         temp = readmem((addr + x) & 0xFF);
                         sbc_nmos(temp);
                         polltime(4);
@@ -3804,8 +4005,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0xF6:      /*INC zp,x */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         temp = readmem((addr + x) & 0xFF) + 1;
                         writemem((addr + x) & 0xFF, temp);
                         setzn(temp);
@@ -3814,8 +4014,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0xF7:      /*Undocumented - ISB zp,x */
-                        addr = (readmem(pc) + x) & 0xFF;
-                        pc++;
+                        addr = (fetch_byte() + x) & 0xFF;
                         polltime(3);
                         temp = readmem(addr);
                         polltime(1);
@@ -3835,7 +4034,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0xF9:      /*SBC abs,y */
-                        addr = getw();
+                        addr = fetch_word();
                         if ((addr & 0xFF00) ^ ((addr + y) & 0xFF00))
                                 polltime(1);
                         temp = readmem(addr + y);
@@ -3850,7 +4049,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0xFB:      /*Undocumented - ISB abs,y */
-                        addr = getw() + y;
+                        addr = fetch_word() + y;
                         polltime(5);
                         temp = readmem(addr);
                         polltime(1);
@@ -3863,7 +4062,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0xFC:      /*Undocumented - NOP abs,x */
-                        addr = getw();
+                        addr = fetch_word();
                         if ((addr & 0xFF00) ^ ((addr + x) & 0xFF00))
                                 polltime(1);
                         readmem(addr + x);
@@ -3872,7 +4071,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0xFD:      /*SBC abs,x */
-                        addr = getw();
+                        addr = fetch_word();
                         if ((addr & 0xFF00) ^ ((addr + x) & 0xFF00))
                                 polltime(1);
                         temp = readmem(addr + x);
@@ -3882,7 +4081,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0xFE:      /*INC abs,x */
-                        addr = getw();
+                        addr = fetch_word();
                         readmem((addr & 0xFF00) | ((addr + x) & 0xFF));
                         addr += x;
                         temp = readmem(addr) + 1;
@@ -3894,7 +4093,7 @@ void m6502_exec(int slice)
                         break;
 
                 case 0xFF:      /*Undocumented - ISB abs,x */
-                        addr = getw() + x;
+                        addr = fetch_word() + x;
                         polltime(5);
                         temp = readmem(addr);
                         polltime(1);
@@ -4044,10 +4243,20 @@ void m6502_exec(int slice)
                 if (otherstuffcount <= 0)
                     otherstuff_poll();
                 if (tube_exec && tubecycle) {
-                        tubecycles += (tubecycle * tube_multipler) >> 1;
+                    if (tube_use_thread && !tube_no_thread) {
+                        if (tubecycle >= TUBE_THREAD_BATCH) {
+                            tube_thread_run(tubecycle);
+                            tubecycle = 0;
+                        }
+                    }
+                    else {
+                        int credit = (tubecycle * tube_multipler) >> 1;
+                        tubecycles += credit;
+                        metrics.tube_cycles += credit;
                         if (tubecycles > 3)
                                 tube_exec();
                         tubecycle = 0;
+                    }
                 }
 
                 if (nmi && !oldnmi) {
@@ -4059,7 +4268,10 @@ void m6502_exec(int slice)
                         polltime(7);
                 }
                 oldnmi = nmi;
+                if (pc == m6502_stop_pc)
+                        break;
         }
+        sched_sync();
 }
 
 void m65c02_exec(int slice)
@@ -4070,6 +4282,9 @@ void m65c02_exec(int slice)
         int tempi;
         int8_t offset;
         cycles += slice;
+        sched_resched();  // anything between slices may have moved a deadline.
+        sched_sync();
+        bb_ins = NULL;
 //        log_debug("PC = %04X\n",pc);
 //        log_debug("Exec cycles %i\n",cycles);
         while (cycles > 0) {
@@ -4090,8 +4305,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0x01:      /*ORA (,x) */
-                        temp = readmem(pc) + x;
-                        pc++;
+                        temp = fetch_byte() + x;
                         addr = read_zp_indirect(temp);
                         polltime(6);
                         takeint = (interrupt && !p.i);
@@ -4103,12 +4317,11 @@ void m65c02_exec(int slice)
                         if (dbg_core6502)
                             debug_trap(&core6502_cpu_debug, debug_addr(oldpc), 1);
                         polltime(2);
-                        (void)readmem(pc++);
+                        fetch_byte();
                         break;
 
                 case 0x04:      /*TSB zp */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         temp = readmem(addr);
                         p.z = !(temp & a);
                         temp |= a;
@@ -4117,8 +4330,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0x05:      /*ORA zp */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         a |= readmem(addr);
                         setzn(a);
                         polltime(3);
@@ -4126,8 +4338,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0x06:      /*ASL zp */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         temp = readmem(addr);
                         p.c = temp & 0x80;
                         temp <<= 1;
@@ -4146,8 +4357,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0x09:      /*ORA imm */
-                        a |= readmem(pc);
-                        pc++;
+                        a |= fetch_byte();
                         setzn(a);
                         polltime(2);
                         takeint = (interrupt && !p.i);
@@ -4162,7 +4372,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0x0C:      /*TSB abs */
-                        addr = getw();
+                        addr = fetch_word();
                         temp = readmem(addr);
                         p.z = !(temp & a);
                         temp |= a;
@@ -4171,7 +4381,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0x0D:      /*ORA abs */
-                        addr = getw();
+                        addr = fetch_word();
                         polltime(4);
                         takeint = (interrupt && !p.i);
                         a |= readmem(addr);
@@ -4179,7 +4389,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0x0E:      /*ASL abs */
-                        addr = getw();
+                        addr = fetch_word();
                         polltime(4);
                         temp = readmem(addr);
                         polltime(1);
@@ -4193,8 +4403,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0x10:
-                        /*BPL*/ offset = (int8_t) readmem(pc);
-                        pc++;
+                        /*BPL*/ offset = (int8_t) fetch_byte();
                         temp = 2;
                         if (!p.n) {
                                 temp++;
@@ -4206,8 +4415,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0x11:      /*ORA (),y */
-                        temp = readmem(pc);
-                        pc++;
+                        temp = fetch_byte();
                         addr = read_zp_indirect(temp);
                         if ((addr & 0xFF00) ^ ((addr + y) & 0xFF00))
                                 polltime(1);
@@ -4218,8 +4426,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0x12:      /*ORA () */
-                        temp = readmem(pc);
-                        pc++;
+                        temp = fetch_byte();
                         addr = read_zp_indirect(temp);
                         a |= readmem(addr);
                         setzn(a);
@@ -4227,8 +4434,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0x14:      /*TRB zp */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         temp = readmem(addr);
                         p.z = !(temp & a);
                         temp &= ~a;
@@ -4237,7 +4443,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0x15:      /*ORA zp,x */
-                        addr = (readmem(pc++) + x) & 0xff;
+                        addr = (fetch_byte() + x) & 0xff;
                         a |= readmem(addr);
                         setzn(a);
                         polltime(4);
@@ -4245,7 +4451,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0x16:      /*ASL zp,x */
-                        addr = (readmem(pc++) + x) & 0xFF;
+                        addr = (fetch_byte() + x) & 0xFF;
                         temp = readmem(addr);
                         writemem(addr, temp);
                         p.c = temp & 0x80;
@@ -4263,7 +4469,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0x19:      /*ORA abs,y */
-                        addr = getw();
+                        addr = fetch_word();
                         if ((addr & 0xFF00) ^ ((addr + y) & 0xFF00))
                                 polltime(1);
                         a |= readmem(addr + y);
@@ -4279,7 +4485,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0x1C:      /*TRB abs */
-                        addr = getw();
+                        addr = fetch_word();
                         temp = readmem(addr);
                         p.z = !(temp & a);
                         temp &= ~a;
@@ -4288,7 +4494,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0x1D:      /*ORA abs,x */
-                        addr = getw();
+                        addr = fetch_word();
                         if ((addr & 0xFF00) ^ ((addr + x) & 0xFF00))
                                 polltime(1);
                         addr += x;
@@ -4299,7 +4505,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0x1E:      /*ASL abs,x */
-                        addr = getw();
+                        addr = fetch_word();
                         readmem((addr & 0xFF00) | ((addr + x) & 0xFF));
                         tempw =
                             ((addr & 0xFF00) ^ ((addr + x) & 0xFF00)) ? 1 : 0;
@@ -4315,18 +4521,17 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0x20:      /*JSR*/
-                        addr = readmem(pc++);
+                        addr = fetch_byte();
                         push(pc >> 8);
                         push((uint8_t)pc);
-                        pc = addr | (readmem(pc) << 8);
+                        pc = addr | (code_byte() << 8);
                         polltime(5);
                         takeint = (interrupt && !p.i);
                         polltime(1);
                         break;
 
                 case 0x21:      /*AND (,x) */
-                        temp = readmem(pc) + x;
-                        pc++;
+                        temp = fetch_byte() + x;
                         addr = read_zp_indirect(temp);
                         a &= readmem(addr);
                         setzn(a);
@@ -4335,8 +4540,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0x24:      /*BIT zp */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         temp = readmem(addr);
                         p.z = !(a & temp);
                         p.v = temp & 0x40;
@@ -4346,8 +4550,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0x25:      /*AND zp */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         a &= readmem(addr);
                         setzn(a);
                         polltime(3);
@@ -4355,8 +4558,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0x26:      /*ROL zp */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         temp = readmem(addr);
                         tempi = p.c;
                         p.c = temp & 0x80;
@@ -4377,8 +4579,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0x29:
-                        /*AND*/ a &= readmem(pc);
-                        pc++;
+                        /*AND*/ a &= fetch_byte();
                         setzn(a);
                         polltime(2);
                         takeint = (interrupt && !p.i);
@@ -4396,7 +4597,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0x2C:      /*BIT abs */
-                        addr = getw();
+                        addr = fetch_word();
                         polltime(3);
                         takeint = (interrupt && !p.i);
                         polltime(1);
@@ -4407,7 +4608,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0x2D:      /*AND abs */
-                        addr = getw();
+                        addr = fetch_word();
                         polltime(4);
                         takeint = (interrupt && !p.i);
                         a &= readmem(addr);
@@ -4415,7 +4616,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0x2E:      /*ROL abs */
-                        addr = getw();
+                        addr = fetch_word();
                         polltime(4);
                         temp = readmem(addr);
                         polltime(1);
@@ -4432,8 +4633,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0x30:
-                        /*BMI*/ offset = (int8_t) readmem(pc);
-                        pc++;
+                        /*BMI*/ offset = (int8_t) fetch_byte();
                         temp = 2;
                         if (p.n) {
                                 temp++;
@@ -4445,8 +4645,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0x31:      /*AND (),y */
-                        temp = readmem(pc);
-                        pc++;
+                        temp = fetch_byte();
                         addr = read_zp_indirect(temp);
                         if ((addr & 0xFF00) ^ ((addr + y) & 0xFF00))
                                 polltime(1);
@@ -4457,8 +4656,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0x32:      /*AND () */
-                        temp = readmem(pc);
-                        pc++;
+                        temp = fetch_byte();
                         addr = read_zp_indirect(temp);
                         a &= readmem(addr);
                         setzn(a);
@@ -4466,8 +4664,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0x34:      /*BIT zp,x */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         temp = readmem((addr + x) & 0xFF);
                         p.z = !(a & temp);
                         p.v = temp & 0x40;
@@ -4476,7 +4673,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0x35:      /*AND zp,x */
-                        addr = (readmem(pc++) + x) & 0xff;
+                        addr = (fetch_byte() + x) & 0xff;
                         a &= readmem(addr);
                         setzn(a);
                         polltime(4);
@@ -4484,7 +4681,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0x36:      /*ROL zp,x */
-                        addr = (readmem(pc++) + x) & 0xff;
+                        addr = (fetch_byte() + x) & 0xff;
                         temp = readmem(addr);
                         writemem(addr, temp);
                         tempi = p.c;
@@ -4505,7 +4702,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0x39:      /*AND abs,y */
-                        addr = getw();
+                        addr = fetch_word();
                         if ((addr & 0xFF00) ^ ((addr + y) & 0xFF00))
                                 polltime(1);
                         a &= readmem(addr + y);
@@ -4521,7 +4718,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0x3C:      /*BIT abs,x */
-                        addr = getw();
+                        addr = fetch_word();
                         if ((addr & 0xFF00) ^ ((addr + x) & 0xFF00))
                                 polltime(1);
                         addr += x;
@@ -4533,7 +4730,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0x3D:      /*AND abs,x */
-                        addr = getw();
+                        addr = fetch_word();
                         if ((addr & 0xFF00) ^ ((addr + x) & 0xFF00))
                                 polltime(1);
                         addr += x;
@@ -4544,7 +4741,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0x3E:      /*ROL abs,x */
-                        addr = getw();
+                        addr = fetch_word();
                         readmem((addr & 0xFF00) | ((addr + x) & 0xFF));
                         tempw =
                             ((addr & 0xFF00) ^ ((addr + x) & 0xFF00)) ? 1 : 0;
@@ -4572,8 +4769,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0x41:      /*EOR (,x) */
-                        temp = readmem(pc) + x;
-                        pc++;
+                        temp = fetch_byte() + x;
                         addr = read_zp_indirect(temp);
                         a ^= readmem(addr);
                         setzn(a);
@@ -4582,13 +4778,12 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0x44: /* NOP */
-                        readmem(pc++);
+                        fetch_byte();
                         polltime(3);
                         break;
 
                 case 0x45:      /*EOR zp */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         a ^= readmem(addr);
                         setzn(a);
                         polltime(3);
@@ -4596,8 +4791,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0x46:      /*LSR zp */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         temp = readmem(addr);
                         p.c = temp & 1;
                         temp >>= 1;
@@ -4614,8 +4808,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0x49:      /*EOR imm */
-                        a ^= readmem(pc);
-                        pc++;
+                        a ^= fetch_byte();
                         setzn(a);
                         polltime(2);
                         takeint = (interrupt && !p.i);
@@ -4630,14 +4823,14 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0x4C:
-                        /*JMP*/ addr = getw();
+                        /*JMP*/ addr = fetch_word();
                         pc = addr;
                         polltime(3);
                         takeint = (interrupt && !p.i);
                         break;
 
                 case 0x4D:      /*EOR abs */
-                        addr = getw();
+                        addr = fetch_word();
                         polltime(4);
                         takeint = (interrupt && !p.i);
                         a ^= readmem(addr);
@@ -4645,7 +4838,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0x4E:      /*LSR abs */
-                        addr = getw();
+                        addr = fetch_word();
                         polltime(4);
                         temp = readmem(addr);
                         polltime(1);
@@ -4659,8 +4852,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0x50:
-                        /*BVC*/ offset = (int8_t) readmem(pc);
-                        pc++;
+                        /*BVC*/ offset = (int8_t) fetch_byte();
                         temp = 2;
                         if (!p.v) {
                                 temp++;
@@ -4672,8 +4864,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0x51:      /*EOR (),y */
-                        temp = readmem(pc);
-                        pc++;
+                        temp = fetch_byte();
                         addr = read_zp_indirect(temp);
                         if ((addr & 0xFF00) ^ ((addr + y) & 0xFF00))
                                 polltime(1);
@@ -4684,8 +4875,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0x52:      /*EOR () */
-                        temp = readmem(pc);
-                        pc++;
+                        temp = fetch_byte();
                         addr = read_zp_indirect(temp);
                         a ^= readmem(addr);
                         setzn(a);
@@ -4693,7 +4883,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0x55:      /*EOR zp,x */
-                        addr = (readmem(pc++) + x) & 0xff;
+                        addr = (fetch_byte() + x) & 0xff;
                         a ^= readmem(addr);
                         setzn(a);
                         polltime(4);
@@ -4701,7 +4891,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0x56:      /*LSR zp,x */
-                        addr = (readmem(pc++) + x) & 0xFF;
+                        addr = (fetch_byte() + x) & 0xFF;
                         temp = readmem(addr);
                         writemem(addr, temp);
                         p.c = temp & 1;
@@ -4719,7 +4909,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0x59:      /*EOR abs,y */
-                        addr = getw();
+                        addr = fetch_word();
                         if ((addr & 0xFF00) ^ ((addr + y) & 0xFF00))
                                 polltime(1);
                         a ^= readmem(addr + y);
@@ -4734,13 +4924,13 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0x5C: /* NOP */
-                        readmem(pc++);
-                        readmem(pc++);
+                        fetch_byte();
+                        fetch_byte();
                         polltime(8);
                         break;
 
                 case 0x5D:      /*EOR abs,x */
-                        addr = getw();
+                        addr = fetch_word();
                         polltime(4);
                         if ((addr & 0xFF00) ^ ((addr + x) & 0xFF00)) {
                                 readmem((addr & 0xFF00) | ((addr + x) & 0xFF));
@@ -4753,7 +4943,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0x5E:      /*LSR abs,x */
-                        addr = getw();
+                        addr = fetch_word();
                         readmem((addr & 0xFF00) | ((addr + x) & 0xFF));
                         tempw =
                             ((addr & 0xFF00) ^ ((addr + x) & 0xFF00)) ? 1 : 0;
@@ -4778,8 +4968,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0x61:      /*ADC (,x) */
-                        temp = readmem(pc) + x;
-                        pc++;
+                        temp = fetch_byte() + x;
                         addr = read_zp_indirect(temp);
                         temp = readmem(addr);
                         adc_cmos(temp);
@@ -4788,15 +4977,13 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0x64:      /*STZ zp */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         writemem(addr, 0);
                         polltime(3);
                         break;
 
                 case 0x65:      /*ADC zp */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         temp = readmem(addr);
                         adc_cmos(temp);
                         polltime(3);
@@ -4804,8 +4991,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0x66:      /*ROR zp */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         temp = readmem(addr);
                         tempi = p.c;
                         p.c = temp & 1;
@@ -4826,8 +5012,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0x69:      /*ADC imm */
-                        temp = readmem(pc);
-                        pc++;
+                        temp = fetch_byte();
                         adc_cmos(temp);
                         polltime(2);
                         takeint = (interrupt && !p.i);
@@ -4845,14 +5030,14 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0x6C:      /*JMP () */
-                        addr = getw();
+                        addr = fetch_word();
                         pc = readmem(addr) | (readmem(addr + 1) << 8);
                         polltime(6);
                         takeint = (interrupt && !p.i);
                         break;
 
                 case 0x6D:      /*ADC abs */
-                        addr = getw();
+                        addr = fetch_word();
                         polltime(4);
                         takeint = (interrupt && !p.i);
                         temp = readmem(addr);
@@ -4860,7 +5045,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0x6E:      /*ROR abs */
-                        addr = getw();
+                        addr = fetch_word();
                         polltime(4);
                         temp = readmem(addr);
                         polltime(1);
@@ -4881,8 +5066,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0x70:
-                        /*BVS*/ offset = (int8_t) readmem(pc);
-                        pc++;
+                        /*BVS*/ offset = (int8_t) fetch_byte();
                         temp = 2;
                         if (p.v) {
                                 temp++;
@@ -4894,8 +5078,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0x71:      /*ADC (),y */
-                        temp = readmem(pc);
-                        pc++;
+                        temp = fetch_byte();
                         addr = read_zp_indirect(temp);
                         if ((addr & 0xFF00) ^ ((addr + y) & 0xFF00))
                                 polltime(1);
@@ -4906,8 +5089,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0x72:      /*ADC () */
-                        temp = readmem(pc);
-                        pc++;
+                        temp = fetch_byte();
                         addr = read_zp_indirect(temp);
                         temp = readmem(addr);
                         adc_cmos(temp);
@@ -4915,14 +5097,13 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0x74:      /*STZ zp,x */
-                        addr = (readmem(pc++) +x) & 0xff;
+                        addr = (fetch_byte() +x) & 0xff;
                         writemem(addr, 0);
                         polltime(4);
                         break;
 
                 case 0x75:      /*ADC zp,x */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         temp = readmem((addr + x) & 0xFF);
                         adc_cmos(temp);
                         polltime(4);
@@ -4930,7 +5111,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0x76:      /*ROR zp,x */
-                        addr = (readmem(pc++) + x) & 0xff;
+                        addr = (fetch_byte() + x) & 0xff;
                         temp = readmem(addr);
                         writemem(addr, temp);
                         tempi = p.c;
@@ -4951,7 +5132,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0x79:      /*ADC abs,y */
-                        addr = getw();
+                        addr = fetch_word();
                         if ((addr & 0xFF00) ^ ((addr + y) & 0xFF00))
                                 polltime(1);
                         temp = readmem(addr + y);
@@ -4967,14 +5148,14 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0x7C:      /*JMP (,x) */
-                        addr = getw();
+                        addr = fetch_word();
                         addr += x;
                         pc = readmem(addr) | (readmem(addr + 1) << 8);
                         polltime(6);
                         break;
 
                 case 0x7D:      /*ADC abs,x */
-                        addr = getw();
+                        addr = fetch_word();
                         if ((addr & 0xFF00) ^ ((addr + x) & 0xFF00))
                                 polltime(1);
                         addr += x;
@@ -4985,7 +5166,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0x7E:      /*ROR abs,x */
-                        addr = getw();
+                        addr = fetch_word();
                         readmem((addr & 0xFF00) | ((addr + x) & 0xFF));
                         tempw =
                             ((addr & 0xFF00) ^ ((addr + x) & 0xFF00)) ? 1 : 0;
@@ -5004,8 +5185,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0x80:
-                        /*BRA*/ offset = (int8_t) readmem(pc);
-                        pc++;
+                        /*BRA*/ offset = (int8_t) fetch_byte();
                         temp = 3;
                         if ((pc & 0xFF00) ^ ((pc + offset) & 0xFF00))
                                 temp++;
@@ -5014,8 +5194,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0x81:      /*STA (,x) */
-                        temp = readmem(pc) + x;
-                        pc++;
+                        temp = fetch_byte() + x;
                         addr = read_zp_indirect(temp);
                         writemem(addr, a);
                         polltime(6);
@@ -5023,24 +5202,21 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0x84:      /*STY zp */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         writemem(addr, y);
                         polltime(3);
                         takeint = (interrupt && !p.i);
                         break;
 
                 case 0x85:      /*STA zp */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         writemem(addr, a);
                         polltime(3);
                         takeint = (interrupt && !p.i);
                         break;
 
                 case 0x86:      /*STX zp */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         writemem(addr, x);
                         polltime(3);
                         takeint = (interrupt && !p.i);
@@ -5054,8 +5230,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0x89:      /*BIT imm */
-                        temp = readmem(pc);
-                        pc++;
+                        temp = fetch_byte();
                         p.z = !(a & temp);
                         polltime(2);
                         break;
@@ -5068,14 +5243,14 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0x8C:      /*STY abs */
-                        addr = getw();
+                        addr = fetch_word();
                         polltime(4);
                         takeint = (interrupt && !p.i);
                         writemem(addr, y);
                         break;
 
                 case 0x8D:      /*STA abs */
-                        addr = getw();
+                        addr = fetch_word();
                         polltime(3);
                         takeint = (interrupt && !p.i);
                         polltime(1);
@@ -5083,15 +5258,14 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0x8E:      /*STX abs */
-                        addr = getw();
+                        addr = fetch_word();
                         polltime(4);
                         takeint = (interrupt && !p.i);
                         writemem(addr, x);
                         break;
 
                 case 0x90:
-                        /*BCC*/ offset = (int8_t) readmem(pc);
-                        pc++;
+                        /*BCC*/ offset = (int8_t) fetch_byte();
                         temp = 2;
                         if (!p.c) {
                                 temp++;
@@ -5103,8 +5277,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0x91:      /*STA (),y */
-                        temp = readmem(pc);
-                        pc++;
+                        temp = fetch_byte();
                         addr = read_zp_indirect(temp) + y;
                         writemem(addr, a);
                         polltime(6);
@@ -5112,31 +5285,28 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0x92:      /*STA () */
-                        temp = readmem(pc++);
+                        temp = fetch_byte();
                         addr = read_zp_indirect(temp);
                         writemem(addr, a);
                         polltime(5);
                         break;
 
                 case 0x94:      /*STY zp,x */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         writemem((addr + x) & 0xFF, y);
                         polltime(4);
                         takeint = (interrupt && !p.i);
                         break;
 
                 case 0x95:      /*STA zp,x */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         writemem((addr + x) & 0xFF, a);
                         polltime(4);
                         takeint = (interrupt && !p.i);
                         break;
 
                 case 0x96:      /*STX zp,y */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         writemem((addr + y) & 0xFF, x);
                         polltime(4);
                         takeint = (interrupt && !p.i);
@@ -5150,7 +5320,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0x99:      /*STA abs,y */
-                        addr = getw();
+                        addr = fetch_word();
                         polltime(4);
                         readmem((addr & 0xFF00) | ((addr + y) & 0xFF));
                         polltime(1);
@@ -5165,14 +5335,14 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0x9C:      /*STZ abs */
-                        addr = getw();
+                        addr = fetch_word();
                         polltime(4);
                         takeint = (interrupt && !p.i);
                         writemem(addr, 0);
                         break;
 
                 case 0x9D:      /*STA abs,x */
-                        addr = getw();
+                        addr = fetch_word();
                         polltime(4);
                         readmem((addr & 0xFF00) | ((addr + x) & 0xFF));
                         polltime(1);
@@ -5181,7 +5351,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0x9E:      /*STZ abs,x */
-                        addr = getw();
+                        addr = fetch_word();
                         addr += x;
                         polltime(4);
                         writemem(addr, 0);
@@ -5189,16 +5359,14 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0xA0:      /*LDY imm */
-                        y = readmem(pc);
-                        pc++;
+                        y = fetch_byte();
                         setzn(y);
                         polltime(2);
                         takeint = (interrupt && !p.i);
                         break;
 
                 case 0xA1:      /*LDA (,x) */
-                        temp = readmem(pc) + x;
-                        pc++;
+                        temp = fetch_byte() + x;
                         addr = read_zp_indirect(temp);
                         a = readmem(addr);
                         setzn(a);
@@ -5207,16 +5375,14 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0xA2:      /*LDX imm */
-                        x = readmem(pc);
-                        pc++;
+                        x = fetch_byte();
                         setzn(x);
                         polltime(2);
                         takeint = (interrupt && !p.i);
                         break;
 
                 case 0xA4:      /*LDY zp */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         y = readmem(addr);
                         setzn(y);
                         polltime(3);
@@ -5224,8 +5390,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0xA5:      /*LDA zp */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         a = readmem(addr);
                         setzn(a);
                         polltime(3);
@@ -5233,8 +5398,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0xA6:      /*LDX zp */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         x = readmem(addr);
                         setzn(x);
                         polltime(3);
@@ -5249,8 +5413,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0xA9:      /*LDA imm */
-                        a = readmem(pc);
-                        pc++;
+                        a = fetch_byte();
                         setzn(a);
                         polltime(1);
                         takeint = (interrupt && !p.i);
@@ -5265,7 +5428,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0xAC:      /*LDY abs */
-                        addr = getw();
+                        addr = fetch_word();
                         polltime(4);
                         takeint = (interrupt && !p.i);
                         y = readmem(addr);
@@ -5273,7 +5436,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0xAD:      /*LDA abs */
-                        addr = getw();
+                        addr = fetch_word();
                         polltime(4);
                         takeint = (interrupt && !p.i);
                         a = readmem(addr);
@@ -5281,7 +5444,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0xAE:      /*LDX abs */
-                        addr = getw();
+                        addr = fetch_word();
                         polltime(4);
                         takeint = (interrupt && !p.i);
                         x = readmem(addr);
@@ -5289,8 +5452,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0xB0:
-                        /*BCS*/ offset = (int8_t) readmem(pc);
-                        pc++;
+                        /*BCS*/ offset = (int8_t) fetch_byte();
                         temp = 2;
                         if (p.c) {
                                 temp++;
@@ -5302,8 +5464,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0xB1:      /*LDA (),y */
-                        temp = readmem(pc);
-                        pc++;
+                        temp = fetch_byte();
                         addr = read_zp_indirect(temp);
                         if ((addr & 0xFF00) ^ ((addr + y) & 0xFF00))
                                 polltime(1);
@@ -5314,8 +5475,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0xB2:      /*LDA () */
-                        temp = readmem(pc);
-                        pc++;
+                        temp = fetch_byte();
                         addr = read_zp_indirect(temp);
                         a = readmem(addr);
                         setzn(a);
@@ -5323,7 +5483,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0xB4:      /*LDY zp,x */
-                        addr = (readmem(pc++) + x) & 0xff;
+                        addr = (fetch_byte() + x) & 0xff;
                         y = readmem(addr);
                         setzn(y);
                         polltime(4);
@@ -5331,7 +5491,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0xB5:      /*LDA zp,x */
-                        addr = (readmem(pc++) + x) & 0xff;
+                        addr = (fetch_byte() + x) & 0xff;
                         a = readmem(addr);
                         setzn(a);
                         polltime(4);
@@ -5339,7 +5499,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0xB6:      /*LDX zp,y */
-                        addr = (readmem(pc++) + y) & 0xff;
+                        addr = (fetch_byte() + y) & 0xff;
                         x = readmem(addr);
                         setzn(x);
                         polltime(4);
@@ -5353,7 +5513,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0xB9:      /*LDA abs,y */
-                        addr = getw();
+                        addr = fetch_word();
                         polltime(3);
                         if ((addr & 0xFF00) ^ ((addr + y) & 0xFF00))
                                 polltime(1);
@@ -5371,7 +5531,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0xBC:      /*LDY abs,x */
-                        addr = getw();
+                        addr = fetch_word();
                         if ((addr & 0xFF00) ^ ((addr + x) & 0xFF00))
                                 polltime(1);
                         y = readmem(addr + x);
@@ -5381,7 +5541,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0xBD:      /*LDA abs,x */
-                        addr = getw();
+                        addr = fetch_word();
                         if ((addr & 0xFF00) ^ ((addr + x) & 0xFF00))
                                 polltime(1);
                         a = readmem(addr + x);
@@ -5391,7 +5551,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0xBE:      /*LDX abs,y */
-                        addr = getw();
+                        addr = fetch_word();
                         if ((addr & 0xFF00) ^ ((addr + y) & 0xFF00))
                                 polltime(1);
                         x = readmem(addr + y);
@@ -5401,8 +5561,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0xC0:      /*CPY imm */
-                        temp = readmem(pc);
-                        pc++;
+                        temp = fetch_byte();
                         setzn(y - temp);
                         p.c = (y >= temp);
                         polltime(2);
@@ -5410,8 +5569,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0xC1:      /*CMP (,x) */
-                        temp = readmem(pc) + x;
-                        pc++;
+                        temp = fetch_byte() + x;
                         addr = read_zp_indirect(temp);
                         temp = readmem(addr);
                         setzn(a - temp);
@@ -5421,8 +5579,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0xC4:      /*CPY zp */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         temp = readmem(addr);
                         setzn(y - temp);
                         p.c = (y >= temp);
@@ -5431,8 +5588,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0xC5:      /*CMP zp */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         temp = readmem(addr);
                         setzn(a - temp);
                         p.c = (a >= temp);
@@ -5441,8 +5597,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0xC6:      /*DEC zp */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         temp = readmem(addr) - 1;
                         writemem(addr, temp);
                         setzn(temp);
@@ -5458,8 +5613,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0xC9:      /*CMP imm */
-                        temp = readmem(pc);
-                        pc++;
+                        temp = fetch_byte();
                         setzn(a - temp);
                         p.c = (a >= temp);
                         polltime(2);
@@ -5482,7 +5636,7 @@ void m65c02_exec(int slice)
 #endif
 
                 case 0xCC:      /*CPY abs */
-                        addr = getw();
+                        addr = fetch_word();
                         polltime(4);
                         takeint = (interrupt && !p.i);
                         temp = readmem(addr);
@@ -5491,7 +5645,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0xCD:      /*CMP abs */
-                        addr = getw();
+                        addr = fetch_word();
                         polltime(4);
                         takeint = (interrupt && !p.i);
                         temp = readmem(addr);
@@ -5500,7 +5654,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0xCE:      /*DEC abs */
-                        addr = getw();
+                        addr = fetch_word();
                         polltime(4);
                         temp = readmem(addr) - 1;
                         polltime(1);
@@ -5515,8 +5669,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0xD0:
-                        /*BNE*/ offset = (int8_t) readmem(pc);
-                        pc++;
+                        /*BNE*/ offset = (int8_t) fetch_byte();
                         temp = 2;
                         if (!p.z) {
                                 temp++;
@@ -5528,8 +5681,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0xD1:      /*CMP (),y */
-                        temp = readmem(pc);
-                        pc++;
+                        temp = fetch_byte();
                         addr = read_zp_indirect(temp);
                         if ((addr & 0xFF00) ^ ((addr + y) & 0xFF00))
                                 polltime(1);
@@ -5541,8 +5693,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0xD2:      /*CMP () */
-                        temp = readmem(pc);
-                        pc++;
+                        temp = fetch_byte();
                         addr = read_zp_indirect(temp);
                         temp = readmem(addr);
                         setzn(a - temp);
@@ -5551,7 +5702,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0xD5:      /*CMP zp,x */
-                        addr = (readmem(pc++) + x) & 0xff;
+                        addr = (fetch_byte() + x) & 0xff;
                         temp = readmem(addr);
                         setzn(a - temp);
                         p.c = (a >= temp);
@@ -5560,7 +5711,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0xD6:      /*DEC zp,x */
-                        addr = (readmem(pc++) + x) & 0xFF;
+                        addr = (fetch_byte() + x) & 0xFF;
                         temp = readmem(addr);
                         writemem(addr, temp);
                         writemem(addr, --temp);
@@ -5576,7 +5727,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0xD9:      /*CMP abs,y */
-                        addr = getw();
+                        addr = fetch_word();
                         if ((addr & 0xFF00) ^ ((addr + y) & 0xFF00))
                                 polltime(1);
                         temp = readmem(addr + y);
@@ -5592,7 +5743,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0xDD:      /*CMP abs,x */
-                        addr = getw();
+                        addr = fetch_word();
                         if ((addr & 0xFF00) ^ ((addr + x) & 0xFF00))
                                 polltime(1);
                         temp = readmem(addr + x);
@@ -5603,7 +5754,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0xDE:      /*DEC abs,x */
-                        addr = getw();
+                        addr = fetch_word();
                         readmem((addr & 0xFF00) | ((addr + x) & 0xFF));
                         addr += x;
                         temp = readmem(addr) - 1;
@@ -5615,8 +5766,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0xE0:      /*CPX imm */
-                        temp = readmem(pc);
-                        pc++;
+                        temp = fetch_byte();
                         setzn(x - temp);
                         p.c = (x >= temp);
                         polltime(2);
@@ -5624,8 +5774,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0xE1:      /*SBC (,x) */
-                        temp = readmem(pc) + x;
-                        pc++;
+                        temp = fetch_byte() + x;
                         addr = read_zp_indirect(temp);
                         temp = readmem(addr);
                         sbc_cmos(temp);
@@ -5634,8 +5783,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0xE4:      /*CPX zp */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         temp = readmem(addr);
                         setzn(x - temp);
                         p.c = (x >= temp);
@@ -5644,8 +5792,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0xE5:      /*SBC zp */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         temp = readmem(addr);
                         sbc_cmos(temp);
                         polltime(3);
@@ -5653,8 +5800,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0xE6:      /*INC zp */
-                        addr = readmem(pc);
-                        pc++;
+                        addr = fetch_byte();
                         temp = readmem(addr) + 1;
                         writemem(addr, temp);
                         setzn(temp);
@@ -5670,8 +5816,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0xE9:      /*SBC imm */
-                        temp = readmem(pc);
-                        pc++;
+                        temp = fetch_byte();
                         sbc_cmos(temp);
                         polltime(2);
                         takeint = (interrupt && !p.i);
@@ -5683,7 +5828,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0xEC:      /*CPX abs */
-                        addr = getw();
+                        addr = fetch_word();
                         polltime(4);
                         takeint = (interrupt && !p.i);
                         temp = readmem(addr);
@@ -5692,7 +5837,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0xED:      /*SBC abs */
-                        addr = getw();
+                        addr = fetch_word();
                         polltime(4);
                         takeint = (interrupt && !p.i);
                         temp = readmem(addr);
@@ -5700,7 +5845,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0xEE:      /*INC abs */
-                        addr = getw();
+                        addr = fetch_word();
                         polltime(4);
                         temp = readmem(addr) + 1;
                         polltime(1);
@@ -5712,8 +5857,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0xF0:
-                        /*BEQ*/ offset = (int8_t) readmem(pc);
-                        pc++;
+                        /*BEQ*/ offset = (int8_t) fetch_byte();
                         temp = 2;
                         if (p.z) {
                                 temp++;
@@ -5726,8 +5870,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0xF1:      /*SBC (),y */
-                        temp = readmem(pc);
-                        pc++;
+                        temp = fetch_byte();
                         addr = read_zp_indirect(temp);
                         if ((addr & 0xFF00) ^ ((addr + y) & 0xFF00))
                                 polltime(1);
@@ -5738,8 +5881,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0xF2:      /*SBC () */
-                        temp = readmem(pc);
-                        pc++;
+                        temp = fetch_byte();
                         addr = read_zp_indirect(temp);
                         temp = readmem(addr);
                         sbc_cmos(temp);
@@ -5747,7 +5889,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0xF5:      /*SBC zp,x */
-                        addr = (readmem(pc++) + x) & 0xff;
+                        addr = (fetch_byte() + x) & 0xff;
                         temp = readmem(addr);
                         sbc_cmos(temp);
                         polltime(4);
@@ -5755,7 +5897,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0xF6:      /*INC zp,x */
-                        addr = (readmem(pc++) + x) & 0xff;
+                        addr = (fetch_byte() + x) & 0xff;
                         temp = readmem(addr);
                         writemem(addr, temp);
                         writemem(addr, ++temp);
@@ -5771,7 +5913,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0xF9:      /*SBC abs,y */
-                        addr = getw();
+                        addr = fetch_word();
                         if ((addr & 0xFF00) ^ ((addr + y) & 0xFF00))
                                 polltime(1);
                         temp = readmem(addr + y);
@@ -5787,7 +5929,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0xFD:      /*SBC abs,x */
-                        addr = getw();
+                        addr = fetch_word();
                         if ((addr & 0xFF00) ^ ((addr + x) & 0xFF00))
                                 polltime(1);
                         temp = readmem(addr + x);
@@ -5797,7 +5939,7 @@ void m65c02_exec(int slice)
                         break;
 
                 case 0xFE:      /*INC abs,x */
-                        addr = getw();
+                        addr = fetch_word();
                         readmem((addr & 0xFF00) | ((addr + x) & 0xFF));
                         addr += x;
                         temp = readmem(addr) + 1;
@@ -5879,10 +6021,20 @@ void m65c02_exec(int slice)
                 interrupt &= ~128;
                 if (tube_exec && tubecycle && !(tubeula.r1stat & TUBE_STAT_P)) {
 //                        log_debug("tubeexec %i %i %i\n",tubecycles,tubecycle,tube_shift);
-                        tubecycles += (tubecycle * tube_multipler) >> 1;
+                    if (tube_use_thread && !tube_no_thread) {
+                        if (tubecycle >= TUBE_THREAD_BATCH) {
+                            tube_thread_run(tubecycle);
+                            tubecycle = 0;
+                        }
+                    }
+                    else {
+                        int credit = (tubecycle * tube_multipler) >> 1;
+                        tubecycles += credit;
+                        metrics.tube_cycles += credit;
                         if (tubecycles > 3)
                                 tube_exec();
                         tubecycle = 0;
+                    }
                 }
 
                 if (otherstuffcount <= 0)
@@ -5900,7 +6052,10 @@ void m65c02_exec(int slice)
 //                        printf("NMI\n");
                 }
                 oldnmi = nmi;
+                if (pc == m6502_stop_pc)
+                        break;
         }
+        sched_sync();
 }
 
 void m6502_savestate(FILE * f)
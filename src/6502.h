@@ -23,17 +23,23 @@ extern int interrupt;
 extern int nmi;
 
 extern uint64_t stopwatch;
+extern int m6502_stop_pc; /* leave exec when PC reaches this, -1 for never */
 extern int romsel;
 extern uint8_t ram1k, ram4k, ram8k;
+extern bool m6502_block_cache;
 
 void m6502_reset(void);
 void m6502_exec(int slice);
 void m65c02_exec(int slice);
 void dumpregs(void);
 void m6502_update_swram(void);
+void m6502_flush_blocks(void);
+void m6502_mem_written(const uint8_t *ptr, size_t len);
 
 uint8_t readmem(uint16_t addr);
 void writemem(uint16_t addr, uint8_t val);
+uint8_t m6502_peek(uint16_t addr);
+void m6502_poke(uint16_t addr, uint8_t val);
 
 void m6502_savestate(FILE *f);
 void m6502_loadstate(FILE *f);
@@ -41,5 +47,6 @@ void m6502_loadstate(FILE *f);
 extern cpu_debug_t core6502_cpu_debug;
 
 void os_paste_start(char *str);
+char *os_paste_stop(void);
 
 #endif
@@ -25,6 +25,10 @@ void acia_receive(ACIA *acia, uint8_t val);
 void acia_savestate(ACIA *acia, FILE *f);
 void acia_loadstate(ACIA *acia, FILE *f);
 
+static inline bool acia_rx_full(ACIA *acia) {
+    return acia->status_reg & 0x01; /* receive data register full */
+}
+
 void acia_dcdhigh(ACIA *acia);
 void acia_dcdlow(ACIA *acia);
 void acia_ctson(ACIA *acia);
@@ -0,0 +1,538 @@
+/*
+ * C API for driving emulated machines from another program.  See bem.h
+ * for how several machines take turns on the single emulation core.
+ */
+
+#include "b-em.h"
+#include <errno.h>
+#include <allegro5/allegro_image.h>
+
+#include "6502.h"
+#include "adc.h"
+#include "bem.h"
+#include "config.h"
+#include "csw.h"
+#include "debugger.h"
+#include "disc.h"
+#include "fdi.h"
+#include "hfe.h"
+#include "ide.h"
+#include "keyboard.h"
+#include "led.h"
+#include "main.h"
+#include "mem.h"
+#include "model.h"
+#include "pal.h"
+#include "paula.h"
+#include "savestate.h"
+#include "scsi.h"
+#include "sid_b-em.h"
+#include "sound.h"
+#include "tape.h"
+#include "tube.h"
+#include "uef.h"
+#include "vdfs.h"
+#include "video.h"
+#include "video_render.h"
+
+#define BEM_SLICE  40000
+#define BEM_SETTLE 100     // slices to wait for a disc command to finish.
+
+struct bem_machine {
+    int model;
+    int tube;
+    int autoboot;
+    bool quit;
+    FILE *state;          // parked state, NULL if never run.
+    char *state_buf;      // memory behind it, if any.
+    long snap_start;      // where in it the snapshot starts.
+    char *discfn[2];
+    char *tapefn;
+    char *paste;          // rest of an OS paste when parked.
+};
+
+static ALLEGRO_MUTEX *bem_mutex;
+static bem_machine *resident;
+static int default_model, default_tube;
+
+bool bem_init(const char *vroot, const char *vdir)
+{
+    if (!al_init()) {
+        fputs("Failed to initialise Allegro!\n", stderr);
+        return false;
+    }
+    key_init();
+    config_load();
+    log_open();
+    log_no_msgbox();
+    log_info("bem: starting %s", VERSION_STR);
+    model_loadcfg();
+    default_model = curmodel;
+    default_tube = selecttube;
+
+    /* Nothing is heard or seen so keep the sound and LED code idle. */
+    sound_internal = sound_beebsid = sound_dac = false;
+    sound_ddnoise = sound_tape = false;
+    sound_music5000 = sound_paula = false;
+    vid_ledlocation = LED_LOC_NONE;
+
+    video_init_headless();
+    mode7_makechars();
+    al_init_image_addon();
+    mem_init();
+
+    sid_init();
+    sid_settype(sidmethod, cursid);
+    paula_init();
+    adc_init();
+    pal_init();
+    disc_init();
+    fdi_init();
+    hfe_init();
+    scsi_init();
+    ide_init();
+    vdfs_init(vroot, vdir);
+
+    /* Media named in the config file belong to the GUI, not to machines. */
+    for (int d = 0; d < 2; d++) {
+        if (drives[d].discfn) {
+            al_destroy_path(drives[d].discfn);
+            drives[d].discfn = NULL;
+        }
+    }
+    if (tape_fn) {
+        al_destroy_path(tape_fn);
+        tape_fn = NULL;
+    }
+
+    if (!(bem_mutex = al_create_mutex())) {
+        log_error("bem: unable to create mutex");
+        return false;
+    }
+    return true;
+}
+
+void bem_close(void)
+{
+    tube_thread_stop();
+    mem_close();
+    uef_close();
+    csw_close();
+    disc_close(0);
+    disc_close(1);
+    scsi_close();
+    ide_close();
+    vdfs_close();
+    video_close();
+    if (bem_mutex) {
+        al_destroy_mutex(bem_mutex);
+        bem_mutex = NULL;
+    }
+    log_close();
+}
+
+static void bem_load_media(bem_machine *m)
+{
+    for (int d = 0; d < 2; d++) {
+        if (drives[d].discfn) {
+            al_destroy_path(drives[d].discfn);
+            drives[d].discfn = NULL;
+        }
+        if (m->discfn[d]) {
+            drives[d].discfn = al_create_path(m->discfn[d]);
+            disc_load(d, drives[d].discfn);
+            if (defaultwriteprot)
+                drives[d].writeprot = 1;
+        }
+    }
+    if (tape_fn) {
+        al_destroy_path(tape_fn);
+        tape_fn = NULL;
+    }
+    if (m->tapefn) {
+        tape_fn = al_create_path(m->tapefn);
+        tape_load(tape_fn);
+    }
+}
+
+static void bem_exec(void)
+{
+    if (autoboot)
+        autoboot--;
+    if (x65c02)
+        m65c02_exec(BEM_SLICE);
+    else
+        m6502_exec(BEM_SLICE);
+    if (savestate_wantload)
+        savestate_doload();
+    if (savestate_wantsave)
+        savestate_dosave();
+}
+
+/*
+ * Snapshots do not include the disc controllers so a command in
+ * progress is let finish before the machine is parked.  That normally
+ * takes a few milliseconds of emulated time, which the machine being
+ * parked runs on for without a stop PC and without bem_run counting it.
+ */
+
+static void bem_settle(void)
+{
+    for (int i = 0; fdc_type != FDC_NONE && fdc_busy && fdc_busy(); i++) {
+        if (i == BEM_SETTLE) {
+            log_warn("bem: disc command still in progress when parking machine");
+            break;
+        }
+        bem_exec();
+    }
+}
+
+#ifndef WIN32
+
+/* The state is written to a memory stream and read from its buffer. */
+
+static FILE *bem_state_open(char **bufp, size_t *sizep)
+{
+    return open_memstream(bufp, sizep);
+}
+
+static FILE *bem_state_reopen(FILE *fp, char **bufp, size_t *sizep)
+{
+    fclose(fp);  // sets the buffer and size.
+    return fmemopen(*bufp, *sizep, "rb");
+}
+
+#else
+
+/* Windows has no memory streams so the state is kept in a temporary file. */
+
+static FILE *bem_state_open(char **bufp, size_t *sizep)
+{
+    *bufp = NULL;
+    *sizep = 0;
+    return tmpfile();
+}
+
+static FILE *bem_state_reopen(FILE *fp, char **bufp, size_t *sizep)
+{
+    return fp;
+}
+
+#endif
+
+/*
+ * The parked state is the keyboard paste and tape position followed by
+ * a snapshot.  The tape position is put back after the tape has been
+ * loaded again.
+ */
+
+static bool bem_park(bem_machine *m)
+{
+    char *buf;
+    size_t size;
+    FILE *fp = bem_state_open(&buf, &size);
+
+    if (!fp) {
+        log_error("bem: unable to open a stream for machine state: %s", strerror(errno));
+        return false;
+    }
+    bem_settle();
+    key_paste_save(fp);
+    tape_savepos(fp);
+    long snap_start = ftell(fp);
+    if (!savestate_save_file(fp)) {
+        fclose(fp);
+        free(buf);
+        return false;
+    }
+    if (!(fp = bem_state_reopen(fp, &buf, &size))) {
+        log_error("bem: unable to reopen machine state: %s", strerror(errno));
+        free(buf);
+        return false;
+    }
+    if (m->state)
+        fclose(m->state);
+    free(m->state_buf);
+    m->state = fp;
+    m->state_buf = buf;
+    m->snap_start = snap_start;
+    m->autoboot = autoboot;
+    m->paste = os_paste_stop();
+    key_paste_cancel();
+    disc_close(0);
+    disc_close(1);
+    tape_close();
+    return true;
+}
+
+static bool bem_activate(bem_machine *m)
+{
+    if (resident == m)
+        return true;
+    if (resident && !bem_park(resident))
+        return false;
+    resident = NULL;
+    if (m->state) {
+        fseek(m->state, m->snap_start, SEEK_SET);
+        if (!savestate_load_file(m->state))
+            return false;
+    }
+    else {
+        curmodel = (m->model == BEM_DEFAULT) ? default_model : m->model;
+        selecttube = (m->tube == BEM_DEFAULT) ? default_tube : m->tube;
+        model_init();
+        main_reset();
+    }
+    oldmodel = curmodel;
+    bem_load_media(m);
+    if (m->state) {
+        rewind(m->state);
+        key_paste_load(m->state);
+        tape_loadpos(m->state);
+    }
+    autoboot = m->autoboot;
+    if (m->paste) {
+        os_paste_start(m->paste);
+        m->paste = NULL;
+    }
+    resident = m;
+    return true;
+}
+
+bem_machine *bem_create(int model, int tube)
+{
+    bem_machine *m = calloc(1, sizeof(bem_machine));
+
+    if (!m) {
+        log_error("bem: out of memory creating machine");
+        return NULL;
+    }
+    m->model = model;
+    m->tube = tube;
+    return m;
+}
+
+void bem_destroy(bem_machine *m)
+{
+    al_lock_mutex(bem_mutex);
+    if (resident == m) {
+        al_free(os_paste_stop());
+        key_paste_cancel();
+        disc_close(0);
+        disc_close(1);
+        tape_close();
+        resident = NULL;
+    }
+    al_unlock_mutex(bem_mutex);
+    if (m->state)
+        fclose(m->state);
+    free(m->state_buf);
+    free(m->discfn[0]);
+    free(m->discfn[1]);
+    free(m->tapefn);
+    if (m->paste)
+        al_free(m->paste);
+    free(m);
+}
+
+bool bem_load_disc(bem_machine *m, int drive, const char *fn, bool boot)
+{
+    bool ok = false;
+    char *copy;
+
+    if (drive < 0 || drive > 1)
+        return false;
+    if (!(copy = strdup(fn))) {
+        log_error("bem: out of memory copying filename");
+        return false;
+    }
+    al_lock_mutex(bem_mutex);
+    if (bem_activate(m)) {
+        disc_close(drive);
+        free(m->discfn[drive]);
+        m->discfn[drive] = copy;
+        if (drives[drive].discfn)
+            al_destroy_path(drives[drive].discfn);
+        drives[drive].discfn = al_create_path(fn);
+        if (!disc_load(drive, drives[drive].discfn)) {
+            if (defaultwriteprot)
+                drives[drive].writeprot = 1;
+            if (boot)
+                autoboot = 150;
+            ok = true;
+        }
+    }
+    else
+        free(copy);
+    al_unlock_mutex(bem_mutex);
+    return ok;
+}
+
+bool bem_load_tape(bem_machine *m, const char *fn)
+{
+    bool ok = false;
+    char *copy;
+
+    if (!(copy = strdup(fn))) {
+        log_error("bem: out of memory copying filename");
+        return false;
+    }
+    al_lock_mutex(bem_mutex);
+    if (bem_activate(m)) {
+        tape_close();
+        free(m->tapefn);
+        m->tapefn = copy;
+        if (tape_fn)
+            al_destroy_path(tape_fn);
+        tape_fn = al_create_path(fn);
+        tape_load(tape_fn);
+        ok = tape_loaded;
+    }
+    else
+        free(copy);
+    al_unlock_mutex(bem_mutex);
+    return ok;
+}
+
+bool bem_load_snapshot(bem_machine *m, const char *fn)
+{
+    bool ok = false;
+
+    al_lock_mutex(bem_mutex);
+    if (bem_activate(m)) {
+        savestate_load(fn);
+        if (savestate_wantload) {
+            savestate_doload();
+            ok = true;
+        }
+    }
+    al_unlock_mutex(bem_mutex);
+    return ok;
+}
+
+bool bem_save_snapshot(bem_machine *m, const char *fn)
+{
+    bool ok = false;
+
+    al_lock_mutex(bem_mutex);
+    if (bem_activate(m)) {
+        savestate_save(fn);
+        if (savestate_wantsave) {
+            savestate_dosave();
+            ok = true;
+        }
+    }
+    al_unlock_mutex(bem_mutex);
+    return ok;
+}
+
+void bem_paste(bem_machine *m, const char *str, bool via_keyboard)
+{
+    al_lock_mutex(bem_mutex);
+    if (bem_activate(m))
+        debug_paste(str, via_keyboard ? key_paste_start : os_paste_start);
+    al_unlock_mutex(bem_mutex);
+}
+
+/*
+ * Run for at least the given number of cycles, returning early if the
+ * host 6502 reaches stop_pc (-1 for none) or the machine asks to quit.
+ * Returns the number of cycles actually run.
+ */
+
+uint64_t bem_run(bem_machine *m, uint64_t cycles, int stop_pc)
+{
+    uint64_t start = 0, end = 0;
+
+    al_lock_mutex(bem_mutex);
+    if (bem_activate(m)) {
+        start = end = stopwatch;
+        m6502_stop_pc = stop_pc;
+        quitting = false;
+        while (stopwatch - start < cycles) {
+            bem_exec();
+            if (quitting) {
+                m->quit = true;
+                break;
+            }
+            if (pc == stop_pc)
+                break;
+        }
+        m6502_stop_pc = -1;
+        end = stopwatch;
+    }
+    al_unlock_mutex(bem_mutex);
+    return end - start;
+}
+
+bool bem_quit_requested(bem_machine *m)
+{
+    return m->quit;
+}
+
+uint16_t bem_get_pc(bem_machine *m)
+{
+    uint16_t value = 0;
+
+    al_lock_mutex(bem_mutex);
+    if (bem_activate(m))
+        value = pc;
+    al_unlock_mutex(bem_mutex);
+    return value;
+}
+
+uint8_t bem_read(bem_machine *m, uint16_t addr)
+{
+    uint8_t value = 0;
+
+    al_lock_mutex(bem_mutex);
+    if (bem_activate(m))
+        value = m6502_peek(addr);
+    al_unlock_mutex(bem_mutex);
+    return value;
+}
+
+void bem_write(bem_machine *m, uint16_t addr, uint8_t val)
+{
+    al_lock_mutex(bem_mutex);
+    if (bem_activate(m))
+        m6502_poke(addr, val);
+    al_unlock_mutex(bem_mutex);
+}
+
+/*
+ * Save the next complete frame as an image, the format being chosen
+ * from the file extension.  This runs the machine for up to one frame,
+ * or two in turbo mode so there is a whole frame drawn to save.
+ */
+
+bool bem_dump_screen(bem_machine *m, const char *fn)
+{
+    bool ok = false;
+
+    al_lock_mutex(bem_mutex);
+    if (bem_activate(m)) {
+        int frame = framesrun;
+        bool was_turbo = turbo;
+        if (turbo) {
+            turbo = false;
+            for (int i = 0; i < 10 && framesrun == frame; i++)
+                bem_exec();
+            frame = framesrun;
+        }
+        strncpy(vid_scrshotname, fn, sizeof vid_scrshotname-1);
+        vid_scrshotname[sizeof vid_scrshotname-1] = 0;
+        vid_savescrshot = 1;
+        for (int i = 0; i < 10 && framesrun == frame; i++)
+            bem_exec();
+        if (framesrun != frame)
+            ok = true;
+        else {
+            vid_savescrshot = 0;
+            log_error("bem: no frame was produced for the screen dump");
+        }
+        turbo = was_turbo;
+    }
+    al_unlock_mutex(bem_mutex);
+    return ok;
+}
@@ -0,0 +1,47 @@
+#ifndef __INC_BEM_H
+#define __INC_BEM_H
+
+/*
+ * C API for driving emulated machines from another program, without a
+ * display or audio, for example in a test farm or fuzzer.
+ *
+ * The emulation core is a single set of globals so it holds one
+ * machine at a time and machines never run in parallel.  Any number of
+ * machines may be created and they take turns on the core: using one
+ * that is not active parks the active one in a snapshot, kept in memory
+ * or, on Windows, in a temporary file, and restores the one being used.
+ * Each switch costs a full snapshot saved and loaded.  Calls on machines
+ * are serialised by a lock so they may come from several threads but
+ * they still run one at a time.
+ *
+ * Parking keeps what a snapshot keeps plus the disc and tape images,
+ * the position of the tape and any paste still in progress.  Snapshots
+ * do not hold the disc controller so a disc command in progress is let
+ * finish first, which runs the machine being parked on, normally by a
+ * few milliseconds of emulated time and at most by about two seconds.
+ */
+
+#define BEM_DEFAULT (-2)  // use the model or tube from the config file.
+
+typedef struct bem_machine bem_machine;
+
+bool bem_init(const char *vroot, const char *vdir);
+void bem_close(void);
+
+bem_machine *bem_create(int model, int tube);
+void bem_destroy(bem_machine *m);
+
+bool bem_load_disc(bem_machine *m, int drive, const char *fn, bool autoboot);
+bool bem_load_tape(bem_machine *m, const char *fn);
+bool bem_load_snapshot(bem_machine *m, const char *fn);
+bool bem_save_snapshot(bem_machine *m, const char *fn);
+void bem_paste(bem_machine *m, const char *str, bool via_keyboard);
+
+uint64_t bem_run(bem_machine *m, uint64_t cycles, int stop_pc);
+bool bem_quit_requested(bem_machine *m);
+uint16_t bem_get_pc(bem_machine *m);
+uint8_t bem_read(bem_machine *m, uint16_t addr);
+void bem_write(bem_machine *m, uint16_t addr, uint8_t val);
+bool bem_dump_screen(bem_machine *m, const char *fn);
+
+#endif
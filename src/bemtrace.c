@@ -0,0 +1,383 @@
+/*
+ * bemtrace - decode a binary execution trace written by the debugger's
+ * btrace command, disassembling each instruction with the same
+ * disassemblers the debugger uses.
+ */
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "bintrace.h"
+#include "logging.h"
+#include "6502debug.h"
+#include "65816.h"
+#include "z80dis.h"
+#include "mc6809nc/mc6809_dis.h"
+#include "musahi/m68k.h"
+
+struct code_entry {
+    uint32_t pc;
+    uint8_t  len;
+    uint8_t  bytes[BINTRACE_MAX_CODE];
+};
+
+static char cpu_name[256];
+static unsigned header_flags;
+static int nregs;
+static char reg_names[BINTRACE_MAX_REGS][256];
+
+static struct code_entry code_cache[BINTRACE_CACHE];
+static const struct code_entry *cur_code;
+static uint32_t regs[BINTRACE_MAX_REGS];
+
+static uint32_t range_start = 0, range_end = UINT32_MAX;
+static uint64_t max_count = UINT64_MAX;
+static bool show_regs = true;
+
+static const char xdigs[] = "0123456789ABCDEF";
+
+/*
+ * The disassemblers read memory through these, which here return the
+ * bytes recorded for the instruction being decoded.
+ */
+
+static uint8_t code_byte(uint32_t addr)
+{
+    uint32_t offset = addr - cur_code->pc;
+    return offset < cur_code->len ? cur_code->bytes[offset] : 0;
+}
+
+static uint32_t code_read(uint32_t addr)
+{
+    return code_byte(addr);
+}
+
+uint8_t tube_z80_readmem(uint32_t addr)
+{
+    return code_byte(addr);
+}
+
+uint8_t copro_mc6809nc_read(uint16_t addr)
+{
+    return code_byte(addr);
+}
+
+uint8_t x86_readmem(uint32_t addr)
+{
+    return code_byte(addr);
+}
+
+unsigned int m68k_read_disassembler_8(unsigned int addr)
+{
+    return code_byte(addr);
+}
+
+unsigned int m68k_read_disassembler_16(unsigned int addr)
+{
+    return (code_byte(addr) << 8) | code_byte(addr + 1);
+}
+
+unsigned int m68k_read_disassembler_32(unsigned int addr)
+{
+    return (m68k_read_disassembler_16(addr) << 16) | m68k_read_disassembler_16(addr + 2);
+}
+
+extern int i386_dasm_one(char *buffer, uint32_t eip, int addr_size, int op_size);
+
+/* What the disassemblers need from the rest of the emulator. */
+
+w65816p_t w65816p;
+
+void log_fatal(const char *fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    fputs("bemtrace: ", stderr);
+    vfprintf(stderr, fmt, ap);
+    putc('\n', stderr);
+    va_end(ap);
+}
+
+size_t debug_print_8bit(uint32_t value, char *buf, size_t bufsize)
+{
+    if (bufsize >= 3) {
+        buf[2] = 0;
+        buf[0] = xdigs[(value >> 4) & 0x0f];
+        buf[1] = xdigs[value & 0x0f];
+    }
+    return 3;
+}
+
+bool symbol_find_by_addr_near(symbol_table *symtab, uint32_t addr, uint32_t min, uint32_t max, uint32_t *addr_found, const char **ret)
+{
+    return false;
+}
+
+/* As the core 6502 prints addresses, with any ROM bank in the top bits. */
+
+static size_t print_addr(cpu_debug_t *cpu, uint32_t addr, char *buf, size_t bufsize, bool include_symbol)
+{
+    uint32_t msw = addr & 0xf0000000;
+    if (msw)
+        return snprintf(buf, bufsize, "%1X:%04X", msw >> 28, addr & 0xFFFF);
+    return snprintf(buf, bufsize, "%04X", addr & 0xFFFF);
+}
+
+static cpu_debug_t trace_cpu = {
+    .memread    = code_read,
+    .print_addr = print_addr
+};
+
+static void print_bytes(uint32_t addr, char *buf, size_t bufsize)
+{
+    size_t len = snprintf(buf, bufsize, "%08X:", addr);
+    for (int i = 0; i < cur_code->len && len < bufsize; i++)
+        len += snprintf(buf + len, bufsize - len, " %02X", cur_code->bytes[i]);
+}
+
+static void disassemble(uint32_t addr, char *buf, size_t bufsize)
+{
+    if (!strcmp(cpu_name, "core6502"))
+        dbg6502_disassemble(&trace_cpu, addr, buf, bufsize, (header_flags & BINTRACE_CMOS) ? M65C02 : M6502);
+    else if (!strcmp(cpu_name, "tube6502"))
+        dbg6502_disassemble(&trace_cpu, addr, buf, bufsize, M65C02);
+    else if (!strcmp(cpu_name, "65816")) {
+        /* The trace holds no flags but the length recorded shows the width of an immediate operand. */
+        w65816p.e = 0;
+        w65816p.m = w65816p.ex = cur_code->len < 3;
+        dbg6502_disassemble(&trace_cpu, addr, buf, bufsize, W65816);
+    }
+    else if (!strcmp(cpu_name, "Z80"))
+        z80_disassemble(&trace_cpu, addr, buf, bufsize);
+    else if (!strcmp(cpu_name, "MC6809NC"))
+        mc6809_disassemble(&trace_cpu, addr, buf, bufsize);
+    else if (!strcmp(cpu_name, "MC68000")) {
+        size_t len = snprintf(buf, bufsize, "%08X: ", addr);
+        m68k_disassemble(buf + len, bufsize - len, addr, M68K_CPU_TYPE_68020);
+    }
+    else if (!strcmp(cpu_name, "80x86")) {
+        char instr[100];
+        i386_dasm_one(instr, addr, 0, 0);
+        size_t len = snprintf(buf, bufsize, "%08X: ", addr);
+        snprintf(buf + len, bufsize - len, "%s", instr);
+    }
+    else
+        print_bytes(addr, buf, bufsize);
+}
+
+static void print_record(uint64_t ticks, uint32_t pc)
+{
+    char buf[256];
+
+    disassemble(pc, buf, sizeof(buf));
+    char *sym = strchr(buf, '\\');
+    if (sym)
+        *sym = '\0';
+    printf("%12" PRIu64 " %-52s", ticks, buf);
+    if (show_regs)
+        for (int r = 0; r < nregs; r++)
+            printf(" %s=%X", reg_names[r], regs[r]);
+    putchar('\n');
+}
+
+static const unsigned char *get_varint(const unsigned char *p, const unsigned char *end, uint64_t *value)
+{
+    uint64_t result = 0;
+    int shift = 0;
+    int byte;
+
+    do {
+        if (p >= end || shift > 63)
+            return NULL;
+        byte = *p++;
+        result |= (uint64_t)(byte & 0x7f) << shift;
+        shift += 7;
+    } while (byte & 0x80);
+    *value = result;
+    return p;
+}
+
+static const unsigned char *get_svarint(const unsigned char *p, const unsigned char *end, int64_t *value)
+{
+    uint64_t raw;
+
+    if ((p = get_varint(p, end, &raw)))
+        *value = (int64_t)(raw >> 1) ^ -(int64_t)(raw & 1);
+    return p;
+}
+
+static bool decode_block(const unsigned char *p, const unsigned char *end, uint32_t records, uint64_t *count)
+{
+    uint32_t pc = 0;
+    uint64_t ticks = 0;
+    int64_t delta;
+    uint64_t mask;
+
+    memset(regs, 0, sizeof(regs));
+    memset(code_cache, 0, sizeof(code_cache));
+
+    while (records--) {
+        if (p >= end)
+            return false;
+        int tag = *p++;
+        if (!(p = get_svarint(p, end, &delta)))
+            return false;
+        pc += (uint32_t)delta;
+        if (((tag >> 2) & BINTRACE_TICKS) == BINTRACE_TICKS) {
+            if (!(p = get_svarint(p, end, &delta)))
+                return false;
+            ticks += delta;
+        }
+        else
+            ticks += (tag >> 2) & BINTRACE_TICKS;
+        if (tag & BINTRACE_REGS) {
+            if (!(p = get_varint(p, end, &mask)))
+                return false;
+            for (int r = 0; r < nregs; r++) {
+                if (mask & ((uint64_t)1 << r)) {
+                    if (!(p = get_svarint(p, end, &delta)))
+                        return false;
+                    regs[r] += (uint32_t)delta;
+                }
+            }
+        }
+        struct code_entry *ce = code_cache + (pc % BINTRACE_CACHE);
+        if (tag & BINTRACE_CODE) {
+            if (p >= end || *p > BINTRACE_MAX_CODE || end - p <= *p)
+                return false;
+            ce->pc = pc;
+            ce->len = *p++;
+            memcpy(ce->bytes, p, ce->len);
+            p += ce->len;
+        }
+        else if (ce->pc != pc || !ce->len)
+            return false;
+        cur_code = ce;
+        if (pc >= range_start && pc <= range_end) {
+            print_record(ticks, pc);
+            if (++*count >= max_count)
+                return true;
+        }
+    }
+    return true;
+}
+
+static bool get_name(FILE *fp, char *name)
+{
+    int len = getc(fp);
+    if (len == EOF || fread(name, len, 1, fp) != 1)
+        return false;
+    name[len] = '\0';
+    return true;
+}
+
+static uint32_t get_le32(const unsigned char *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static int decode_trace(const char *fn, FILE *fp)
+{
+    unsigned char hdr[18];
+
+    if (fread(hdr, sizeof(hdr), 1, fp) != 1 || memcmp(hdr, BINTRACE_MAGIC, 8)) {
+        fprintf(stderr, "bemtrace: %s is not a B-em binary trace\n", fn);
+        return 1;
+    }
+    if (hdr[8] != BINTRACE_VERSION) {
+        fprintf(stderr, "bemtrace: %s is trace version %d, only %d is supported\n", fn, hdr[8], BINTRACE_VERSION);
+        return 1;
+    }
+    header_flags = hdr[9];
+    time_t opened = get_le32(hdr + 10) | ((uint64_t)get_le32(hdr + 14) << 32);
+    if (!get_name(fp, cpu_name) || (nregs = getc(fp)) == EOF || nregs > BINTRACE_MAX_REGS) {
+        fprintf(stderr, "bemtrace: %s has a bad header\n", fn);
+        return 1;
+    }
+    for (int r = 0; r < nregs; r++) {
+        if (!get_name(fp, reg_names[r])) {
+            fprintf(stderr, "bemtrace: %s has a bad header\n", fn);
+            return 1;
+        }
+    }
+    char when[20];
+    strftime(when, sizeof(when), "%d/%m/%Y %H:%M:%S", localtime(&opened));
+    printf("%s trace of %s opened at %s\n", fn, cpu_name, when);
+
+    unsigned char *data = malloc(BINTRACE_BLOCK);
+    if (!data) {
+        fprintf(stderr, "bemtrace: out of memory\n");
+        return 1;
+    }
+    uint64_t count = 0;
+    int status = 0;
+    while (count < max_count && fread(hdr, 8, 1, fp) == 1) {
+        uint32_t size = get_le32(hdr);
+        uint32_t records = get_le32(hdr + 4);
+        if (size > BINTRACE_BLOCK || fread(data, size, 1, fp) != 1 || !decode_block(data, data + size, records, &count)) {
+            fprintf(stderr, "bemtrace: %s is truncated or corrupt\n", fn);
+            status = 1;
+            break;
+        }
+    }
+    free(data);
+    return status;
+}
+
+static void usage(void)
+{
+    fputs("Usage: bemtrace [-q] [-n count] [-r start-end] trace-file ...\n"
+          "  -q           do not show registers\n"
+          "  -n count     stop after count instructions\n"
+          "  -r start-end only show instructions between these hex addresses\n", stderr);
+}
+
+int main(int argc, char **argv)
+{
+    int opt, status = 0;
+
+    while ((opt = getopt(argc, argv, "qn:r:")) != -1) {
+        switch (opt) {
+            case 'q':
+                show_regs = false;
+                break;
+            case 'n':
+                max_count = strtoull(optarg, NULL, 10);
+                break;
+            case 'r':
+                if (sscanf(optarg, "%" SCNx32 "-%" SCNx32, &range_start, &range_end) != 2) {
+                    usage();
+                    return 1;
+                }
+                break;
+            default:
+                usage();
+                return 1;
+        }
+    }
+    if (optind >= argc) {
+        usage();
+        return 1;
+    }
+    for (; optind < argc; optind++) {
+        const char *fn = argv[optind];
+        FILE *fp = fopen(fn, "rb");
+        if (fp) {
+            status |= decode_trace(fn, fp);
+            fclose(fp);
+        }
+        else {
+            fprintf(stderr, "bemtrace: unable to open %s: %s\n", fn, strerror(errno));
+            status = 1;
+        }
+    }
+    return status;
+}
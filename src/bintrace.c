@@ -0,0 +1,307 @@
+/*
+ * Binary execution trace writer.
+ *
+ * Records are encoded into large blocks in memory as each instruction
+ * is executed and a writer thread puts the full blocks to the file, so
+ * tracing costs little more than the encoding.  See bintrace.h for the
+ * format and bemtrace.c for a reader.
+ */
+
+#include "b-em.h"
+#include <errno.h>
+#include <time.h>
+
+#include "6502.h"
+#include "bintrace.h"
+#include "model.h"
+
+#define BLOCK_QUEUE  8
+#define RECORD_MAX   512
+
+struct block {
+    struct block *next;
+    uint32_t used;
+    uint32_t records;
+    unsigned char data[BINTRACE_BLOCK];
+};
+
+struct code_entry {
+    uint32_t pc;
+    uint8_t  len;    // zero for an empty entry.
+    uint8_t  bytes[BINTRACE_MAX_CODE];
+};
+
+static cpu_debug_t *trace_cpu;
+static FILE *trace_fp;
+static int trace_nregs;
+static bool trace_failed;
+
+static ALLEGRO_THREAD *writer;
+static ALLEGRO_MUTEX *mutex;
+static ALLEGRO_COND *cond;
+static struct block *full_head, *full_tail, *spare;
+static int full_count;
+static bool stopping;
+
+/* Encoding state, which starts over with each block. */
+
+static struct block *cur;
+static uint32_t prev_pc;
+static uint64_t prev_ticks;
+static uint32_t prev_regs[BINTRACE_MAX_REGS];
+static struct code_entry code_cache[BINTRACE_CACHE];
+
+static void put_le32(uint32_t value, FILE *fp)
+{
+    putc(value, fp);
+    putc(value >> 8, fp);
+    putc(value >> 16, fp);
+    putc(value >> 24, fp);
+}
+
+static void put_name(const char *name, FILE *fp)
+{
+    size_t len = strlen(name);
+    if (len > 255)
+        len = 255;
+    putc(len, fp);
+    fwrite(name, len, 1, fp);
+}
+
+static void write_block(struct block *blk)
+{
+    put_le32(blk->used, trace_fp);
+    put_le32(blk->records, trace_fp);
+    if (fwrite(blk->data, blk->used, 1, trace_fp) != 1)
+        trace_failed = true;
+}
+
+static void *writer_proc(ALLEGRO_THREAD *thread, void *data)
+{
+    al_lock_mutex(mutex);
+    for (;;) {
+        while (!full_head && !stopping)
+            al_wait_cond(cond, mutex);
+        struct block *blk = full_head;
+        if (!blk)
+            break;
+        if (!(full_head = blk->next))
+            full_tail = NULL;
+        full_count--;
+        al_unlock_mutex(mutex);
+        write_block(blk);
+        al_lock_mutex(mutex);
+        blk->next = spare;
+        spare = blk;
+        al_broadcast_cond(cond);
+    }
+    al_unlock_mutex(mutex);
+    return NULL;
+}
+
+static void start_block(struct block *blk)
+{
+    blk->used = 0;
+    blk->records = 0;
+    cur = blk;
+    prev_pc = 0;
+    prev_ticks = 0;
+    memset(prev_regs, 0, sizeof(prev_regs));
+    memset(code_cache, 0, sizeof(code_cache));
+}
+
+/*
+ * Hand the current block to the writer thread and start another,
+ * waiting if the writer has fallen too far behind.
+ */
+static void queue_block(void)
+{
+    al_lock_mutex(mutex);
+    while (full_count >= BLOCK_QUEUE)
+        al_wait_cond(cond, mutex);
+    cur->next = NULL;
+    if (full_tail)
+        full_tail->next = cur;
+    else
+        full_head = cur;
+    full_tail = cur;
+    full_count++;
+    al_broadcast_cond(cond);
+    struct block *blk = spare;
+    if (blk)
+        spare = blk->next;
+    else if (!(blk = malloc(sizeof(struct block)))) {
+        while (!spare)
+            al_wait_cond(cond, mutex);
+        blk = spare;
+        spare = blk->next;
+    }
+    al_unlock_mutex(mutex);
+    start_block(blk);
+}
+
+static unsigned char *put_varint(unsigned char *p, uint64_t value)
+{
+    while (value >= 0x80) {
+        *p++ = value | 0x80;
+        value >>= 7;
+    }
+    *p++ = value;
+    return p;
+}
+
+static unsigned char *put_svarint(unsigned char *p, int64_t value)
+{
+    return put_varint(p, ((uint64_t)value << 1) ^ (uint64_t)(value >> 63));
+}
+
+void bintrace_write(cpu_debug_t *cpu, uint32_t addr)
+{
+    if (cpu != trace_cpu)
+        return;
+    if (cur->used > BINTRACE_BLOCK - RECORD_MAX)
+        queue_block();
+
+    unsigned char *start = cur->data + cur->used;
+    unsigned char *p = put_svarint(start + 1, (int32_t)(addr - prev_pc));
+    int tag;
+    prev_pc = addr;
+
+    int64_t ticks = stopwatch - prev_ticks;
+    prev_ticks = stopwatch;
+    if (ticks >= 0 && ticks < BINTRACE_TICKS)
+        tag = ticks << 2;
+    else {
+        tag = BINTRACE_TICKS << 2;
+        p = put_svarint(p, ticks);
+    }
+
+    uint32_t regs[BINTRACE_MAX_REGS];
+    uint64_t mask = 0;
+    for (int r = 0; r < trace_nregs; r++)
+        if ((regs[r] = cpu->reg_get(r)) != prev_regs[r])
+            mask |= (uint64_t)1 << r;
+    if (mask) {
+        tag |= BINTRACE_REGS;
+        p = put_varint(p, mask);
+        for (int r = 0; r < trace_nregs; r++) {
+            if (mask & ((uint64_t)1 << r)) {
+                p = put_svarint(p, (int32_t)(regs[r] - prev_regs[r]));
+                prev_regs[r] = regs[r];
+            }
+        }
+    }
+
+    struct code_entry *ce = code_cache + (addr % BINTRACE_CACHE);
+    bool hit = ce->len && ce->pc == addr;
+    for (int i = 0; hit && i < ce->len; i++)
+        hit = cpu->memread(addr + i) == ce->bytes[i];
+    if (!hit) {
+        char buf[256];
+        uint32_t len = cpu->disassemble(cpu, addr, buf, sizeof(buf)) - addr;
+        if (len < 1)
+            len = 1;
+        else if (len > BINTRACE_MAX_CODE)
+            len = BINTRACE_MAX_CODE;
+        ce->pc = addr;
+        ce->len = len;
+        tag |= BINTRACE_CODE;
+        *p++ = len;
+        for (int i = 0; i < len; i++)
+            *p++ = ce->bytes[i] = cpu->memread(addr + i);
+    }
+    *start = tag;
+    cur->used = p - cur->data;
+    cur->records++;
+}
+
+bool bintrace_active(cpu_debug_t *cpu)
+{
+    return trace_fp && cpu == trace_cpu;
+}
+
+static void free_blocks(struct block *blk)
+{
+    while (blk) {
+        struct block *next = blk->next;
+        free(blk);
+        blk = next;
+    }
+}
+
+void bintrace_close(void)
+{
+    if (!trace_fp)
+        return;
+    if (cur->records)
+        queue_block();
+    al_lock_mutex(mutex);
+    stopping = true;
+    al_broadcast_cond(cond);
+    al_unlock_mutex(mutex);
+    al_join_thread(writer, NULL);
+    al_destroy_thread(writer);
+    al_destroy_cond(cond);
+    al_destroy_mutex(mutex);
+    writer = NULL;
+    free(cur);
+    free_blocks(spare);
+    spare = cur = NULL;
+    if (fclose(trace_fp) || trace_failed)
+        log_error("bintrace: error writing trace file");
+    trace_fp = NULL;
+    trace_cpu = NULL;
+}
+
+bool bintrace_open(cpu_debug_t *cpu, const char *fn)
+{
+    bintrace_close();
+    FILE *fp = fopen(fn, "wb");
+    if (!fp) {
+        log_error("bintrace: unable to open trace file '%s': %s", fn, strerror(errno));
+        return false;
+    }
+    int nregs = 0;
+    while (cpu->reg_names[nregs] && nregs < BINTRACE_MAX_REGS)
+        nregs++;
+
+    fwrite(BINTRACE_MAGIC, 8, 1, fp);
+    putc(BINTRACE_VERSION, fp);
+    putc((cpu == &core6502_cpu_debug && x65c02) ? BINTRACE_CMOS : 0, fp);
+    uint64_t now = time(NULL);
+    put_le32(now, fp);
+    put_le32(now >> 32, fp);
+    put_name(cpu->cpu_name, fp);
+    putc(nregs, fp);
+    for (int r = 0; r < nregs; r++)
+        put_name(cpu->reg_names[r], fp);
+
+    if (!(cur = malloc(sizeof(struct block)))) {
+        log_error("bintrace: out of memory for trace buffer");
+        fclose(fp);
+        return false;
+    }
+    mutex = al_create_mutex();
+    cond = al_create_cond();
+    full_head = full_tail = spare = NULL;
+    full_count = 0;
+    stopping = false;
+    if (!mutex || !cond || !(writer = al_create_thread(writer_proc, NULL))) {
+        log_error("bintrace: unable to create trace writer thread");
+        if (cond)
+            al_destroy_cond(cond);
+        if (mutex)
+            al_destroy_mutex(mutex);
+        free(cur);
+        cur = NULL;
+        fclose(fp);
+        return false;
+    }
+    trace_fp = fp;
+    trace_cpu = cpu;
+    trace_nregs = nregs;
+    trace_failed = false;
+    start_block(cur);
+    al_start_thread(writer);
+    return true;
+}
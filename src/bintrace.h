@@ -0,0 +1,55 @@
+#ifndef __INC_BINTRACE_H
+#define __INC_BINTRACE_H
+
+#include <stdbool.h>
+#include "cpu_debug.h"
+
+/*
+ * Binary execution trace.
+ *
+ * The file starts with a header:
+ *
+ *   "BEMTRACE", version byte, flags byte, le64 time opened,
+ *   CPU name, register count, register names
+ *
+ * where names are a length byte followed by the characters.  The
+ * records follow in blocks, each a le32 byte count and a le32 record
+ * count followed by the records.  Each record is:
+ *
+ *   tag byte      bit 0 set if code bytes follow, bit 1 set if any
+ *                 register changed, bits 2-7 the clock ticks since the
+ *                 previous record or 63 if a signed varint of them
+ *                 follows.
+ *   varint        change in PC from the previous record.
+ *   [varint]      ticks, if not in the tag.
+ *   [varint]      mask of registers changed, then for each a varint
+ *                 of the change in its value.
+ *   [code]        length byte and the bytes of the instruction, when
+ *                 the code cache does not already hold them.
+ *
+ * Varints are seven bits per byte, least significant first, with the
+ * top bit set on all but the last and signed values zig-zag encoded.
+ * The code cache is BINTRACE_CACHE entries indexed by the low bits of
+ * the PC, each the last bytes recorded for an instruction there.
+ * Ticks are of the 2MHz system clock whatever the CPU.  All delta
+ * state and the code cache start over at the start of each block, so
+ * a reader may start at any block.
+ */
+
+#define BINTRACE_MAGIC    "BEMTRACE"
+#define BINTRACE_VERSION  1
+#define BINTRACE_CMOS     0x01     // header flag: core is a 65C02.
+#define BINTRACE_CODE     0x01     // record tag bits.
+#define BINTRACE_REGS     0x02
+#define BINTRACE_TICKS    0x3f     // ticks in tag are ((tag >> 2) & this).
+#define BINTRACE_MAX_REGS 64
+#define BINTRACE_MAX_CODE 16
+#define BINTRACE_CACHE    4096
+#define BINTRACE_BLOCK    (1 << 20)
+
+extern bool bintrace_open(cpu_debug_t *cpu, const char *fn);
+extern void bintrace_close(void);
+extern bool bintrace_active(cpu_debug_t *cpu);
+extern void bintrace_write(cpu_debug_t *cpu, uint32_t addr);
+
+#endif
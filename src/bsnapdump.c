@@ -513,6 +513,11 @@ static void dump_one(char *hexout, const char *fn, FILE *fp)
     music5000_loadstate(fp);}*/
 }
 
+static void dump_base_id(const unsigned char *data)
+{
+    printf("Base snapshot identifier:\n  %02X%02X%02X%02X\n", data[3], data[2], data[1], data[0]);
+}
+
 static void dump_section(char *hexout, const char *fn, FILE *fp, int key, long size)
 {
     long start = ftell(fp);
@@ -575,6 +580,14 @@ static void dump_section(char *hexout, const char *fn, FILE *fp, int key, long s
         case 'J':
             fputs("JIM memory\n", stdout);
             dump_compressed(hexout, fn, fp, size);
+            break;
+        case 'B':
+        case 'b':
+            small_section(fn, fp, 4, dump_base_id);
+            break;
+        case 'D':
+            fputs("Memory changed since base snapshot\n", stdout);
+            dump_compressed(hexout, fn, fp, size);
     }
     fseek(fp, start+size, SEEK_SET);
 }
@@ -622,6 +635,7 @@ static bool snapdump(char *hexout, const char *fn)
                     dump_two(hexout, fn, fp);
                     break;
                 case '3':
+                case '4':
                     dump_three(hexout, fn, fp);
                     break;
                 default:
@@ -3,6 +3,7 @@
 
 #include "b-em.h"
 
+#include "6502.h"
 #include "config.h"
 #include "ddnoise.h"
 #include "disc.h"
@@ -16,6 +17,8 @@
 #include "music5000.h"
 #include "ide.h"
 #include "midi.h"
+#include "metrics.h"
+#include "rewind.h"
 #include "scsi.h"
 #include "sdf.h"
 #include "sn76489.h"
@@ -165,12 +168,15 @@ void config_load(void)
     al_remove_config_key(bem_cfg, "", "video_resize");
     al_remove_config_key(bem_cfg, "", "tube6502speed");
     defaultwriteprot = get_config_bool("disc", "defaultwriteprotect", 1);
+    disc_fast        = get_config_bool("disc", "fastdisc", 0);
 
     autopause        = get_config_bool(NULL, "autopause", false);
 
     curmodel         = get_config_int(NULL, "model",         3);
     selecttube       = get_config_int(NULL, "tube",         -1);
     tube_speed_num   = get_config_int(NULL, "tubespeed",     0);
+    m6502_block_cache = get_config_bool(NULL, "blockcache",   true);
+    tube_use_thread  = get_config_bool(NULL, "tubethread",    false);
 
     sound_internal   = get_config_bool("sound", "sndinternal",   true);
     sound_beebsid    = get_config_bool("sound", "sndbeebsid",    true);
@@ -213,8 +219,10 @@ void config_load(void)
     mono_white_col = get_config_colour("video", "mono_white", al_map_rgb(255, 255, 255));
 
     mode7_fontfile   = get_config_string("video", "mode7font", "saa5050");
+    vid_render_thread = get_config_bool("video", "renderthread", false);
 
     fasttape         = get_config_bool("tape", "fasttape",      0);
+    tape_fastload    = get_config_bool("tape", "fastload",      0);
 
     scsi_enabled     = get_config_bool("disc", "scsienable", 0);
     ide_enable       = get_config_bool("disc", "ideenable",     0);
@@ -226,6 +234,18 @@ void config_load(void)
 
     mem_jim_setsize(get_config_int(NULL, "jim_mem_size", 0));
 
+    rewind_enabled   = get_config_bool(NULL, "rewind", false);
+    rewind_interval  = get_config_int(NULL, "rewind_interval", 25);
+    rewind_budget    = get_config_int(NULL, "rewind_mb", 64);
+    if (rewind_interval < 1)
+        rewind_interval = 1;
+
+    if ((p = get_config_string(NULL, "metrics", NULL))) {
+        free(metrics_dest);
+        metrics_dest = strdup(p);
+    }
+    metrics_interval = get_config_int(NULL, "metrics_interval", 1000);
+
     mouse_amx        = get_config_bool(NULL, "mouse_amx",     0);
     mouse_stick      = get_config_bool(NULL, "mouse_stick",   0);
     kbdips           = get_config_int(NULL, "kbdips", 0);
@@ -321,6 +341,7 @@ void config_save(void)
         set_config_string("disc", "mmb", mmb_fn);
         set_config_string("disc", "mmccard", mmccard_fn);
         set_config_bool("disc", "defaultwriteprotect", defaultwriteprot);
+        set_config_bool("disc", "fastdisc", disc_fast);
 
         if (tape_loaded)
             al_set_config_value(bem_cfg, "tape", "tape", al_path_cstr(tape_fn, ALLEGRO_NATIVE_PATH_SEP));
@@ -332,6 +353,8 @@ void config_save(void)
         set_config_int(NULL, "model", curmodel);
         set_config_int(NULL, "tube", selecttube);
         set_config_int(NULL, "tubespeed", tube_speed_num);
+        set_config_bool(NULL, "blockcache", m6502_block_cache);
+        set_config_bool(NULL, "tubethread", tube_use_thread);
 
         set_config_bool("sound", "sndinternal", sound_internal);
         set_config_bool("sound", "sndbeebsid",  sound_beebsid);
@@ -364,8 +387,10 @@ void config_save(void)
             set_config_int("video", "ledlocation", vid_ledlocation);
         set_config_int("video", "ledvisibility", vid_ledvisibility);
         set_config_string("video", "mode7font", mode7_fontfile);
+        set_config_bool("video", "renderthread", vid_render_thread);
 
         set_config_bool("tape", "fasttape", fasttape);
+        set_config_bool("tape", "fastload", tape_fastload);
 
         set_config_bool("disc", "scsienable", scsi_enabled);
         set_config_bool("disc", "ideenable", ide_enable);
@@ -378,6 +403,9 @@ void config_save(void)
         set_config_bool(NULL, "keypad", keypad);
         set_config_int(NULL, "key_mode", key_mode);
         set_config_int(NULL, "jim_mem_size", mem_jim_size);
+        set_config_bool(NULL, "rewind", rewind_enabled);
+        set_config_int(NULL, "rewind_interval", rewind_interval);
+        set_config_int(NULL, "rewind_mb", rewind_budget);
 
         set_config_bool(NULL, "mouse_amx", mouse_amx);
         set_config_bool(NULL, "mouse_stick", mouse_stick);
@@ -12,10 +12,12 @@ int csw_toneon=0;
 
 static int csw_intone = 1, csw_indat = 0, csw_datbits = 0, csw_enddat = 0;
 static uint8_t *csw_dat = NULL;
-static int      csw_point;
+static uint32_t csw_len;
+static uint32_t csw_point;
 static uint8_t  csw_head[0x34];
 static int      csw_skip = 0;
 static int      csw_loop = 1;
+static bool     csw_scanning = false;
 int csw_ena;
 
 static void csw_read_failed(FILE *csw_f, const char *fn)
@@ -26,29 +28,79 @@ static void csw_read_failed(FILE *csw_f, const char *fn)
         log_error("csw: premature EOF on '%s'", fn);
 }
 
-#define CSW_MAXLEN (8 * 1024 * 1024)
+/* Inflate the pulse data into a buffer of the right size, growing it
+ * until the whole stream fits. */
 
-void csw_load(const char *fn)
+static uint8_t *csw_inflate(const uint8_t *src, unsigned long srclen, unsigned long *destlen, const char *fn)
 {
-    FILE *csw_f;
-    int end,c;
-    unsigned long destlen = CSW_MAXLEN;
-    uint8_t *tempin;
+    unsigned long alloc = srclen * 8 + 65536;
+    uint8_t *dest;
+    int res;
 
-    /*Allocate buffer*/
-    if (!csw_dat) {
-        if (!(csw_dat = malloc(CSW_MAXLEN))) {
+    for (;;) {
+        if (!(dest = malloc(alloc))) {
             log_error("csw: out of memory reading '%s'", fn);
-            return;
+            return NULL;
+        }
+        *destlen = alloc;
+        res = uncompress(dest, destlen, src, srclen);
+        if (res == Z_OK)
+            return dest;
+        free(dest);
+        if (res != Z_BUF_ERROR || *destlen < alloc) {
+            log_error("csw: unable to decompress '%s': %s", fn, zError(res));
+            return NULL;
         }
+        alloc *= 2;
     }
+}
+
+static void csw_reset(void)
+{
+    csw_point   = 0;
+    csw_indat   = 0;
+    csw_intone  = 1;
+    csw_datbits = 0;
+    csw_enddat  = 0;
+    csw_skip    = 0;
+    csw_toneon  = 0;
+}
+
+/* Run the whole tape through the decoder once so the catalogue is
+ * ready without winding through the tape again. */
+
+static void csw_catalogue(void)
+{
+    int tapespeed = sysacia_tapespeed;
+
+    tape_cat_reset();
+    csw_reset();
+    sysacia_tapespeed = 0;
+    csw_scanning = true;
+    csw_loop = 0;
+    while (!csw_loop)
+        csw_poll();
+    csw_scanning = false;
+    sysacia_tapespeed = tapespeed;
+    csw_reset();
+}
+
+void csw_load(const char *fn)
+{
+    FILE *csw_f;
+    long end;
+    int c;
+    unsigned long destlen;
+    uint8_t *tempin;
+
+    csw_close();
 
     /*Open file and get size*/
     if (!(csw_f = fopen(fn,"rb"))) {
         log_warn("csw: unable to open CSW file '%s': %s", fn, strerror(errno));
         return;
     }
-    fseek(csw_f, -1, SEEK_END);
+    fseek(csw_f, 0, SEEK_END);
     end = ftell(csw_f);
     fseek(csw_f, 0, SEEK_SET);
 
@@ -58,23 +110,26 @@ void csw_load(const char *fn)
             getc(csw_f);
         /*Allocate temporary memory and read file into memory*/
         end -= ftell(csw_f);
+        if (end <= 0) {
+            log_error("csw: no pulse data in '%s'", fn);
+            fclose(csw_f);
+            return;
+        }
         if ((tempin = malloc(end))) {
             if (fread(tempin, end, 1, csw_f) == 1) {
                 fclose(csw_f);
                 if (2 == csw_head[0x21]) {
                     /*Decompress*/
-                    uncompress(csw_dat, (unsigned long *)&destlen, tempin, end);
-                } else {
-                    if (end >= CSW_MAXLEN) {
-                        log_error("csw: out of memory reading '%s'", fn);
+                    csw_dat = csw_inflate(tempin, end, &destlen, fn);
+                    free(tempin);
+                    if (!csw_dat)
                         return;
-                    }
-                    memcpy(csw_dat, tempin, end);
+                } else {
+                    csw_dat = tempin;
                     destlen = end;
                 }
-                free(tempin);
-                /*Reset data pointer*/
-                csw_point = 0;
+                csw_len = destlen;
+                csw_catalogue();
                 acia_dcdhigh(&sysacia);
                 tapellatch  = (1000000 / (1200 / 10)) / 64;
                 tapelcount  = 0;
@@ -101,37 +156,80 @@ void csw_close()
         free(csw_dat);
         csw_dat = NULL;
     }
+    csw_len = 0;
+}
+
+/* Where playback has got to, for putting a tape back where it was
+ * after it has been closed and loaded again. */
+
+typedef struct {
+    uint32_t point;
+    int      intone, indat, datbits, enddat, skip, loop, toneon;
+} csw_pos_t;
+
+void csw_savepos(FILE *f)
+{
+    csw_pos_t cp = {
+        csw_point, csw_intone, csw_indat, csw_datbits, csw_enddat,
+        csw_skip, csw_loop, csw_toneon
+    };
+    fwrite(&cp, sizeof(cp), 1, f);
+}
+
+void csw_loadpos(FILE *f)
+{
+    csw_pos_t cp;
+
+    if (fread(&cp, sizeof(cp), 1, f) == 1 && cp.point <= csw_len) {
+        csw_point = cp.point;
+        csw_intone = cp.intone;
+        csw_indat = cp.indat;
+        csw_datbits = cp.datbits;
+        csw_enddat = cp.enddat;
+        csw_skip = cp.skip;
+        csw_loop = cp.loop;
+        csw_toneon = cp.toneon;
+    }
 }
 
-static int ffound, fdat;
-static int infilenames;
 static void csw_receive(uint8_t val)
 {
         csw_toneon--;
-        if (infilenames)
-        {
-                ffound = 1;
-                fdat = val;
-        }
+        if (csw_scanning)
+           tape_cat_byte(val, csw_toneon == 1);
         else
            acia_receive(&sysacia, val);
 }
 
+static void csw_dcdhigh(void)
+{
+        if (!csw_scanning)
+           acia_dcdhigh(&sysacia);
+}
+
+static void csw_dcdlow(void)
+{
+        if (!csw_scanning)
+           acia_dcdlow(&sysacia);
+}
+
 void csw_poll()
 {
         int c;
         uint8_t dat;
-        if (!csw_dat) return;
+        if (!csw_len) return;
 
         for (c = 0; c < 10; c++)
         {
-                dat = csw_dat[csw_point++];
-
-                if (csw_point >= (8 * 1024 * 1024))
+                if (csw_point >= csw_len)
                 {
                         csw_point = 0;
                         csw_loop = 1;
+                        if (csw_scanning)
+                           return;
                 }
+                dat = csw_dat[csw_point++];
+
                 if (csw_skip)
                    csw_skip--;
                 else if (csw_intone && dat > 0xD) /*Not in tone any more - data start bit*/
@@ -142,7 +240,7 @@ void csw_poll()
                         csw_indat = 1;
 
                         csw_datbits = csw_enddat = 0;
-                        acia_dcdlow(&sysacia);
+                        csw_dcdlow();
                         return;
                 }
                 else if (csw_indat && csw_datbits != -1 && csw_datbits != -2)
@@ -181,7 +279,7 @@ void csw_poll()
                 {
                         if (dat <= 0xD) /*Back in tone again*/
                         {
-                                acia_dcdhigh(&sysacia);
+                                csw_dcdhigh();
                                 csw_toneon  = 2;
                                 csw_indat   = 0;
                                 csw_intone  = 1;
@@ -198,120 +296,3 @@ void csw_poll()
                 }
         }
 }
-
-#define getcswbyte()            ffound = 0; \
-                                while (!ffound && !csw_loop) \
-                                { \
-                                        csw_poll(); \
-                                } \
-                                if (csw_loop) break;
-
-static uint8_t ffilename[16];
-void csw_findfilenames()
-{
-        int temp, temps, tempd, tempi, tempsk, tempspd;
-        uint8_t tb;
-        int c;
-        int fsize = 0;
-        char s[256];
-        uint32_t run, load;
-        uint8_t status;
-        int skip;
-        if (!csw_dat) return;
-        temp    = csw_point;
-        temps   = csw_indat;
-        tempi   = csw_intone;
-        tempd   = csw_datbits;
-        tempsk  = csw_skip;
-        tempspd = sysacia_tapespeed;
-        csw_point = 0;
-
-        csw_indat = csw_intone = csw_datbits = csw_skip = 0;
-        csw_intone = 1;
-        sysacia_tapespeed = 0;
-
-//        gzseek(csw,12,SEEK_SET);
-        csw_loop = 0;
-        infilenames = 1;
-        while (!csw_loop)
-        {
-//                log_debug("Start\n");
-                ffound = 0;
-                while (!ffound && !csw_loop)
-                {
-                        csw_poll();
-                }
-                if (csw_loop) break;
-//                log_debug("FDAT %02X csw_toneon %i\n",fdat,csw_toneon);
-                if (fdat == 0x2A && csw_toneon == 1)
-                {
-                        c = 0;
-                        do
-                        {
-                                ffound = 0;
-                                while (!ffound && !csw_loop)
-                                {
-                                        csw_poll();
-                                }
-                                if (csw_loop) break;
-                                ffilename[c++] = fdat;
-                        } while (fdat != 0x0 && c <= 10);
-                        if (csw_loop) break;
-                        c--;
-                        while (c < 13) ffilename[c++] = 32;
-                        ffilename[c] = 0;
-
-                                getcswbyte();
-                                tb = fdat;
-                                getcswbyte();
-                                load = tb | (fdat << 8);
-                                getcswbyte();
-                                tb = fdat;
-                                getcswbyte();
-                                load |= (tb | (fdat << 8)) << 16;
-
-                                getcswbyte();
-                                tb = fdat;
-                                getcswbyte();
-                                run = tb | (fdat << 8);
-                                getcswbyte();
-                                tb = fdat;
-                                getcswbyte();
-                                run |= (tb | (fdat << 8)) << 16;
-
-                                getcswbyte();
-                                getcswbyte();
-
-                                getcswbyte();
-                                tb = fdat;
-                                getcswbyte();
-                                skip = tb | (fdat << 8);
-
-                                fsize += skip;
-
-                                getcswbyte();
-                                status = fdat;
-
-//log_debug("Got block - %08X %08X %02X\n",load,run,status);
-                        if (status & 0x80)
-                        {
-                                sprintf(s, "%s Size %04X Load %08X Run %08X", ffilename, fsize, load, run);
-                                cataddname(s);
-                                fsize = 0;
-                        }
-                        for (c = 0; c < skip + 8; c++)
-                        {
-                                getcswbyte();
-                        }
-                }
-        }
-        infilenames = 0;
-        csw_indat   = temps;
-        csw_intone  = tempi;
-        csw_datbits = tempd;
-        csw_skip    = tempsk;
-        sysacia_tapespeed = tempspd;
-        csw_point   = temp;
-        csw_loop = 0;
-}
-
@@ -4,7 +4,8 @@
 void csw_load(const char *fn);
 void csw_close(void);
 void csw_poll(void);
-void csw_findfilenames(void);
+void csw_savepos(FILE *f);
+void csw_loadpos(FILE *f);
 
 extern int csw_ena;
 extern int csw_toneon;
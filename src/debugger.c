@@ -10,9 +10,13 @@
 #include "cpu_debug.h"
 #include "debugger.h"
 #include "b-em.h"
+#include "bintrace.h"
 #include "main.h"
 #include "mem.h"
 #include "model.h"
+#include "rewind.h"
+#include "sampler.h"
+#include "tube.h"
 #include "6502.h"
 #include "keyboard.h"
 #include "debugger_symbols.h"
@@ -59,6 +63,49 @@ struct breakpoint {
     int        num;
 };
 
+/*
+ * The breakpoints of a CPU are compiled into a map so the usual case of
+ * an access with nothing set at its address costs one bit test.  Each
+ * kind of access has a bitmap with a bit per 256 byte page, set if a
+ * point covers the page, and a list of the points concerned.  Pages
+ * beyond the first 16MB share bits, so a set bit may be a false alarm
+ * that the check of the list then rules out.
+ */
+
+typedef enum {
+    ACCESS_EXEC,
+    ACCESS_READ,
+    ACCESS_WRITE,
+    ACCESS_INPUT,
+    ACCESS_OUTPUT,
+    ACCESS_COUNT
+} access_type;
+
+static const access_type break_access[] = {
+    ACCESS_EXEC,    // BREAK_EXEC
+    ACCESS_READ,    // BREAK_READ
+    ACCESS_WRITE,   // BREAK_WRITE
+    ACCESS_WRITE,   // BREAK_CHANGE
+    ACCESS_INPUT,   // BREAK_INPUT
+    ACCESS_OUTPUT,  // BREAK_OUTPUT
+    ACCESS_EXEC,    // WATCH_EXEC
+    ACCESS_READ,    // WATCH_READ
+    ACCESS_WRITE,   // WATCH_WRITE
+    ACCESS_WRITE,   // WATCH_CHANGE
+    ACCESS_INPUT,   // WATCH_INPUT
+    ACCESS_OUTPUT,  // WATCH_OUTPUT
+    ACCESS_EXEC     // TRACE_EXEC
+};
+
+#define MAP_PAGE_SHIFT 8
+#define MAP_PAGES      0x10000
+
+struct breakpoint_map {
+    uint32_t   (*pages)[MAP_PAGES / 32];  // by access type, NULL to check every page.
+    int        first[ACCESS_COUNT + 1];  // index into points by access type.
+    breakpoint *points[];
+};
+
 int debug_core = 0;
 int debug_tube = 0;
 int debug_step = 0;
@@ -154,6 +201,10 @@ static void debug_memview_open(void)
     if (!mem_thread) {
         if ((mem_thread = al_create_thread(mem_thread_proc, NULL))) {
             log_debug("debugger: memory view thread created");
+            memset(readc, 0, sizeof(readc));
+            memset(writec, 0, sizeof(writec));
+            memset(fetchc, 0, sizeof(fetchc));
+            debug_memview = true;
             al_start_thread(mem_thread);
         }
         else
@@ -164,6 +215,7 @@ static void debug_memview_open(void)
 static void debug_memview_close(void)
 {
     if (mem_thread) {
+        debug_memview = false;
         al_join_thread(mem_thread, NULL);
         mem_thread = NULL;
     }
@@ -275,6 +327,7 @@ static inline void debug_cons_close(void) {}
 #include "via.h"
 #include "sysvia.h"
 #include "uservia.h"
+#include "sched.h"
 #include "video.h"
 #include "sn76489.h"
 #include "model.h"
@@ -282,6 +335,7 @@ static inline void debug_cons_close(void) {}
 void debug_kill()
 {
     close_trace("emulator quit");
+    bintrace_close();
     debug_memview_close();
     debug_cons_close();
 }
@@ -300,6 +354,7 @@ static void enable_tube_debug(void)
 {
     if (curtube != -1)
     {
+        tube_thread_stop();
         debug_cons_open();
         debug_step = 1;
         debug_tube = 1;
@@ -387,6 +442,7 @@ void debug_toggle_tube(void)
 }
 
 int readc[65536], writec[65536], fetchc[65536];
+bool debug_memview;
 
 static uint32_t debug_memaddr=0;
 static uint32_t debug_disaddr=0;
@@ -416,6 +472,7 @@ static const char helptext[] =
     "    bclearo n  - clear output breakpoint n or output breakpoint at n\n"
     "    blist      - list current breakpoints\n"
     "    break n    - set a breakpoint at n\n"
+    "    btrace fn  - binary trace to file for bemtrace, close file if no fn\n"
     "    breakr n   - break on reads from address n\n"
     "    breakw n   - break on writes to address n\n"
     "    breaki n   - break on input from I/O port\n"
@@ -436,10 +493,12 @@ static const char helptext[] =
     "    r vidproc  - print VIDPROC registers\n"
     "    r sound    - print Sound registers\n"
     "    reset      - reset emulated machine\n"
+    "    rewind [n] - go back n rewind snapshots (or 1 if no parameter)\n"
     "    rset r v   - set a CPU register\n"
     "    ruler [s [c]] - draw a ruler to help with hexdumps.\n"
     "                 starts at 's' for 'c' bytes\n"
     "    s [n]      - step n instructions (or 1 if no parameter)\n"
+    "    sample...  - various sampling profiler sub-commands\n"
     "    swatch [n] - start/clear/print stopwatches\n"
     "    symbol name=[rom:]addr\n"
     "               - add debugger symbol\n"
@@ -464,7 +523,12 @@ static const char helptext[] =
     "    profile print         - show profiling stats\n"
     "    profile file <file>   - write profiling stats to <file>\n"
     "    profile reset         - reset profiling counters\n"
-    "    profile stop          - stop profiling and free memory\n";
+    "    profile stop          - stop profiling and free memory\n"
+    "    sample [c]            - sample the PC and call stack every c 2MHz cycles\n"
+    "    sample print [n]      - show the n most sampled stacks (default 20)\n"
+    "    sample file <file>    - write the stacks to <file> for a flame graph\n"
+    "    sample reset          - reset the samples\n"
+    "    sample stop           - stop sampling and free memory\n";
 
 static char xdigs[] = "0123456789ABCDEF";
 
@@ -615,6 +679,65 @@ static void print_point(cpu_debug_t *cpu, const breakpoint *bp, const char *desc
     }
 }
 
+/*
+ * Compile the list of breakpoints into the map, which must be done
+ * whenever the list changes.  If there is no memory for the page bitmap
+ * the points are still listed by access type but checked on every
+ * access; if there is none for the map at all no point is checked.
+ */
+static void map_points(cpu_debug_t *cpu)
+{
+    if (cpu->point_map) {
+        free(cpu->point_map->pages);
+        free(cpu->point_map);
+        cpu->point_map = NULL;
+    }
+
+    int count = 0;
+    for (breakpoint *bp = cpu->breakpoints; bp; bp = bp->next)
+        count++;
+    if (!count)
+        return;
+    breakpoint_map *map = malloc(sizeof(breakpoint_map) + count * sizeof(breakpoint *));
+    if (!map) {
+        log_error("debugger: unable to map breakpoints, out of memory");
+        debug_outf("    unable to map breakpoints, out of memory, none will be checked\n");
+        return;
+    }
+    if (!(map->pages = calloc(ACCESS_COUNT, sizeof(*map->pages))))
+        log_warn("debugger: no memory for the breakpoint page map, checking every access");
+    int index = 0;
+    for (access_type access = 0; access < ACCESS_COUNT; access++) {
+        map->first[access] = index;
+        uint32_t *bits = map->pages ? map->pages[access] : NULL;
+        for (breakpoint *bp = cpu->breakpoints; bp; bp = bp->next) {
+            if (break_access[bp->type] == access) {
+                map->points[index++] = bp;
+                if (!bits)
+                    continue;
+                uint32_t first = bp->start >> MAP_PAGE_SHIFT;
+                uint32_t last = bp->end >> MAP_PAGE_SHIFT;
+                if (last - first >= MAP_PAGES - 1)
+                    memset(bits, 0xff, sizeof(*map->pages));
+                else {
+                    for (uint32_t page = first; page != last + 1; page++) {
+                        uint32_t bit = page & (MAP_PAGES - 1);
+                        bits[bit >> 5] |= 1u << (bit & 31);
+                    }
+                }
+            }
+        }
+    }
+    map->first[ACCESS_COUNT] = index;
+    cpu->point_map = map;
+}
+
+static inline bool map_maybe(const breakpoint_map *map, access_type access, uint32_t addr)
+{
+    uint32_t bit = (addr >> MAP_PAGE_SHIFT) & (MAP_PAGES - 1);
+    return map && (!map->pages || (map->pages[access][bit >> 5] & (1u << (bit & 31))));
+}
+
 static void set_point(cpu_debug_t *cpu, break_type type, const char *desc, uint32_t start, uint32_t end)
 {
     for (breakpoint *bp = cpu->breakpoints; bp; bp = bp->next) {
@@ -635,7 +758,16 @@ static void set_point(cpu_debug_t *cpu, break_type type, const char *desc, uint3
         bp->type = type;
         bp->num = breakpseq++;
         cpu->breakpoints = bp;
-        print_point(cpu, bp, desc, " set");
+        map_points(cpu);
+        if (cpu->point_map)
+            print_point(cpu, bp, desc, " set");
+        else {
+            /* Unmapped points would never be checked so refuse this one. */
+            cpu->breakpoints = bp->next;
+            free(bp);
+            map_points(cpu);
+            debug_outf("    unable to set %s, out of memory\n", desc);
+        }
     }
     else
         debug_outf("    unable to set %s, out of memory\n", desc);
@@ -696,6 +828,7 @@ static void parse_clrpnt(cpu_debug_t *cpu, break_type type, char *arg, const cha
             prev->next = found->next;
         else
             cpu->breakpoints = found->next;
+        map_points(cpu);
         print_point(cpu, found, desc, " cleared");
         free(found);
     }
@@ -1131,6 +1264,47 @@ static void debugger_profile(cpu_debug_t *cpu, const char *iptr)
     }
 }
 
+static void debugger_sample(cpu_debug_t *cpu, const char *iptr)
+{
+    if (!strcasecmp(iptr, "stop"))
+        sampler_stop(cpu);
+    else if (!strcasecmp(iptr, "reset"))
+        sampler_reset(cpu);
+    else if (!strncasecmp(iptr, "print", 5)) {
+        unsigned limit = strtoul(iptr + 5, NULL, 10);
+        unsigned count = sampler_write(cpu, NULL, debug_outf, limit ? limit : 20);
+        debug_outf("%u samples shown\n", count);
+    }
+    else if (!strncasecmp(iptr, "file", 4)) {
+        iptr += 4;
+        while (isspace(*iptr))
+            ++iptr;
+        FILE *fp = fopen(iptr, "w");
+        if (fp) {
+            unsigned count = sampler_write(cpu, fp, NULL, 0);
+            fclose(fp);
+            debug_outf("%u samples written to %s\n", count, iptr);
+        }
+        else
+            debug_outf("unable to open %s for writing: %s\n", iptr, strerror(errno));
+    }
+    else {
+        unsigned interval = 2000;
+        if (*iptr) {
+            char *end;
+            interval = strtoul(iptr, &end, 0);
+            if (end == iptr || !interval) {
+                debug_outf("unrecognised sub-command: stop, reset, print, file or a number of cycles available\n");
+                return;
+            }
+        }
+        if (sampler_start(cpu, interval))
+            debug_outf("sampling cpu %s every %u cycles\n", cpu->cpu_name, interval);
+        else
+            debug_outf("out of memory enabling sampling\n");
+    }
+}
+
 static void debugger_ruler(const char *iptr)
 {
     unsigned start = 0;
@@ -1239,6 +1413,15 @@ static void debugger_writemem(cpu_debug_t *cpu, const char *iptr)
         debug_out(err_noaddr, sizeof(err_noaddr)-1);
 }
 
+static void trace_default_range(cpu_debug_t *cpu)
+{
+    for (breakpoint *bp = cpu->breakpoints; bp; bp = bp->next)
+        if (bp->type == TRACE_EXEC)
+            return;
+    log_debug("debug: setting default trace range bp");
+    set_point(cpu, TRACE_EXEC, "execution trace", 0, UINT32_MAX);
+}
+
 static void debug_tracecmd(cpu_debug_t *cpu, const char *iptr)
 {
     close_trace("command");
@@ -1246,22 +1429,12 @@ static void debug_tracecmd(cpu_debug_t *cpu, const char *iptr)
         if ((trace_fn = strdup(iptr))) {
             FILE *fp = fopen(iptr, "a");
             if (fp) {
-                breakpoint *found = NULL;
                 char when[20];
                 time_t now;
                 time(&now);
                 strftime(when, sizeof(when), "%d/%m/%Y %H:%M:%S", localtime(&now));
                 fprintf(fp, "trace file %s opened at %s\n", iptr, when);
-                for (breakpoint *bp = cpu->breakpoints; bp; bp = bp->next) {
-                    if (bp->type == TRACE_EXEC) {
-                        found = bp;
-                        break;
-                    }
-                }
-                if (!found) {
-                    log_debug("debug: setting default trace range bp");
-                    set_point(cpu, TRACE_EXEC, "execution trace", 0, UINT32_MAX);
-                }
+                trace_default_range(cpu);
                 debug_outf("Tracing to %s\n", iptr);
                 trace_fp = fp;
             }
@@ -1277,6 +1450,22 @@ static void debug_tracecmd(cpu_debug_t *cpu, const char *iptr)
         debug_outf("Trace file closed");
 }
 
+static void debug_btracecmd(cpu_debug_t *cpu, const char *iptr)
+{
+    if (*iptr) {
+        if (bintrace_open(cpu, iptr)) {
+            trace_default_range(cpu);
+            debug_outf("Binary tracing %s to %s\n", cpu->cpu_name, iptr);
+        }
+        else
+            debug_outf("Unable to open binary trace file '%s'\n", iptr);
+    }
+    else {
+        bintrace_close();
+        debug_outf("Binary trace file closed\n");
+    }
+}
+
 static void debug_trange(cpu_debug_t *cpu, char *iptr)
 {
     if (iptr) {
@@ -1297,6 +1486,7 @@ static void debug_trange(cpu_debug_t *cpu, char *iptr)
             else
                 cpu->breakpoints = found->next;
             free(found);
+            map_points(cpu);
         }
         parse_setpnt(cpu, TRACE_EXEC, iptr, "execution trace");
     }
@@ -1403,6 +1593,8 @@ void debugger_do(cpu_debug_t *cpu, uint32_t addr)
                     parse_clrpnt(cpu, BREAK_READ, iptr, "Read breakpoint");
                 else if (!strncmp(cmd, "bclearw", cmdlen))
                     parse_clrpnt(cpu, BREAK_WRITE, iptr, "Write breakpoint");
+                else if (!strncmp(cmd, "btrace", cmdlen))
+                    debug_btracecmd(cpu, iptr);
                 else
                     badcmd = true;
                 break;
@@ -1482,6 +1674,22 @@ void debugger_do(cpu_debug_t *cpu, uint32_t addr)
                     main_reset();
                     debug_outf("Emulator reset\n");
                 }
+                else if (cmdlen >= 3 && !strncmp(cmd, "rewind", cmdlen)) {
+                    int count = 1;
+                    if (*iptr)
+                        sscanf(iptr, "%i", &count);
+                    if (!rewind_available())
+                        debug_outf("No rewind snapshots available\n");
+                    else {
+                        if (count < 1)
+                            count = 1;
+                        debug_outf("Rewinding to snapshot %d of %d\n", count, rewind_available());
+                        rewind_wanted = count;
+                        indebug = 0;
+                        main_resume();
+                        return;
+                    }
+                }
                 else if (cmdlen >= 2 && !strncmp(cmd, "rset", cmdlen))
                     debugger_rset(cpu, iptr);
                 else if (cmdlen >= 2 && !strncmp(cmd, "ruler", cmdlen))
@@ -1489,6 +1697,7 @@ void debugger_do(cpu_debug_t *cpu, uint32_t addr)
                 else if (*iptr) {
                     size_t arglen = strcspn(iptr, " \t\n");
                     iptr[arglen] = 0;
+                    sched_sync();
                     if (!strncasecmp(iptr, "sysvia", arglen)) {
                         debug_outf("    System VIA registers :\n");
                         debug_outf("    ORA  %02X ORB  %02X IRA %02X IRB %02X\n", sysvia.ora, sysvia.orb, sysvia.ira, sysvia.irb);
@@ -1573,6 +1782,8 @@ void debugger_do(cpu_debug_t *cpu, uint32_t addr)
                     }
                     else if (!strncmp(cmd, "swatch", cmdlen))
                         debugger_stopwatch(cpu, iptr);
+                    else if (!strncmp(cmd, "sample", cmdlen))
+                        debugger_sample(cpu, iptr);
                     else
                         badcmd = true;
                     break;
@@ -1672,8 +1883,13 @@ static void check_points(cpu_debug_t *cpu, uint32_t addr, uint32_t value, uint8_
 {
     bool found = false;
     const char *enter = "";
+    const breakpoint_map *map = cpu->point_map;
+    access_type access = break_access[btype];
 
-    for (breakpoint *bp = cpu->breakpoints; bp; bp = bp->next) {
+    if (!map_maybe(map, access, addr))
+        return;
+    for (int i = map->first[access]; i < map->first[access + 1]; i++) {
+        breakpoint *bp = map->points[i];
         if (addr >= bp->start && addr <= bp->end) {
             if (bp->type == btype) {
                 found = true;
@@ -1699,8 +1915,12 @@ void debug_memwrite(cpu_debug_t *cpu, uint32_t addr, uint32_t value, uint8_t siz
     bool found = false;
     const char *desc = "write to";
     const char *enter = "";
+    const breakpoint_map *map = cpu->point_map;
 
-    for (breakpoint *bp = cpu->breakpoints; bp; bp = bp->next) {
+    if (!map_maybe(map, ACCESS_WRITE, addr))
+        return;
+    for (int i = map->first[ACCESS_WRITE]; i < map->first[ACCESS_WRITE + 1]; i++) {
+        breakpoint *bp = map->points[i];
         if (addr >= bp->start && addr <= bp->end) {
             if (bp->type == BREAK_WRITE) {
                 found = true;
@@ -1786,6 +2006,8 @@ void debug_preexec(cpu_debug_t *cpu, uint32_t addr)
 
     if (cpu->prof_counts && addr >= cpu->prof_start && addr < cpu->prof_end)
         cpu->prof_counts[addr - cpu->prof_start]++;
+    if (cpu->sampler)
+        sampler_exec(cpu, addr);
 
     if (addr == cpu->tbreak) {
         log_debug("debugger; enter for CPU %s on tbreak at %04X", cpu->cpu_name, addr);
@@ -1799,27 +2021,34 @@ void debug_preexec(cpu_debug_t *cpu, uint32_t addr)
         enter = true;
     }
 
-    for (breakpoint *bp = cpu->breakpoints; bp; bp = bp->next) {
-        if (addr >= bp->start && addr <= bp->end) {
-            if (bp->type == BREAK_EXEC) {
-                char addr_str[16+SYM_MAX];
-                cpu->print_addr(cpu, addr, addr_str, sizeof(addr_str), true);
-                debug_outf("cpu %s: Break at %s\n", cpu->cpu_name, addr_str);
-                if (contcount) {
-                    contcount--;
-                    return;
+    const breakpoint_map *map = cpu->point_map;
+    if (map_maybe(map, ACCESS_EXEC, addr)) {
+        for (int i = map->first[ACCESS_EXEC]; i < map->first[ACCESS_EXEC + 1]; i++) {
+            breakpoint *bp = map->points[i];
+            if (addr >= bp->start && addr <= bp->end) {
+                if (bp->type == BREAK_EXEC) {
+                    char addr_str[16+SYM_MAX];
+                    cpu->print_addr(cpu, addr, addr_str, sizeof(addr_str), true);
+                    debug_outf("cpu %s: Break at %s\n", cpu->cpu_name, addr_str);
+                    if (contcount) {
+                        contcount--;
+                        return;
+                    }
+                    log_debug("debugger; enter for CPU %s on breakpoint at %s", cpu->cpu_name, addr_str);
+                    enter = 1;
+                }
+                else if (bp->type == WATCH_EXEC) {
+                    char addr_str[16+SYM_MAX];
+                    cpu->print_addr(cpu, addr, addr_str, sizeof(addr_str), true);
+                    debug_outf("cpu %s: execute %s\n", cpu->cpu_name, addr_str);
+                }
+                else if (bp->type == TRACE_EXEC && (trace_fp || bintrace_active(cpu))) {
+                    if (trace_fp)
+                        debug_trace_write(cpu, addr, trace_fp);
+                    if (bintrace_active(cpu))
+                        bintrace_write(cpu, addr);
+                    break; /* in case of more than one match, only trace once */
                 }
-                log_debug("debugger; enter for CPU %s on breakpoint at %s", cpu->cpu_name, addr_str);
-                enter = 1;
-            }
-            else if (bp->type == WATCH_EXEC) {
-                char addr_str[16+SYM_MAX];
-                cpu->print_addr(cpu, addr, addr_str, sizeof(addr_str), true);
-                debug_outf("cpu %s: execute %s\n", cpu->cpu_name, addr_str);
-            }
-            else if (bp->type == TRACE_EXEC && trace_fp) {
-                debug_trace_write(cpu, addr, trace_fp);
-                break; /* in case of more than one match, only trace once */
             }
         }
     }
@@ -0,0 +1,100 @@
+/*
+ * B-em delta snapshot test.
+ *
+ * Boots a BBC B with sideways RAM, saves a base snapshot, loads a file
+ * into sideways RAM with the VDFS *SRLOAD command and saves a delta.
+ * Restoring the base and then the delta must give back the loaded bank,
+ * which checks that memory the filing system copies in directly, rather
+ * than through the 6502, is carried by deltas.
+ *
+ * Usage: deltatest [scratch-dir]
+ */
+
+#include "b-em.h"
+#include <errno.h>
+
+#include "bem.h"
+#include "mem.h"
+#include "savestate.h"
+#include "vdfs.h"
+
+#define DT_MODEL   4        // BBC B w/8271+SWRAM, whose MOS has no *SRLOAD.
+#define DT_SIZE    0x1000
+#define DT_CYCLES  4000000  // enough to boot or run a command.
+
+static uint8_t dt_data[DT_SIZE];
+static int dt_bank;
+
+static bool dt_write_data(const char *dir)
+{
+    char path[PATH_MAX];
+    FILE *fp;
+
+    for (int i = 0; i < DT_SIZE; i++)
+        dt_data[i] = i * 7 + (i >> 8) + 1;
+    snprintf(path, sizeof(path), "%s/SRDATA", dir);
+    if (!(fp = fopen(path, "wb"))) {
+        fprintf(stderr, "deltatest: unable to create %s: %s\n", path, strerror(errno));
+        return false;
+    }
+    fwrite(dt_data, DT_SIZE, 1, fp);
+    fclose(fp);
+    return true;
+}
+
+static bool dt_bank_matches(void)
+{
+    return !memcmp(rom + dt_bank * ROM_SIZE, dt_data, DT_SIZE);
+}
+
+int main(int argc, char **argv)
+{
+    const char *dir = argc > 1 ? argv[1] : ".";
+    FILE *base, *delta;
+    int status = 1;
+
+    if (!dt_write_data(dir) || !bem_init(dir, NULL))
+        return 1;
+    vdfs_enabled = true;
+    bem_machine *m = bem_create(DT_MODEL, -1);
+    if (!m)
+        return 1;
+    bem_paste(m, "*VDFS\r", false);
+    bem_run(m, DT_CYCLES, -1);
+
+    if (!(base = tmpfile()) || !(delta = tmpfile()))
+        fputs("deltatest: unable to create temporary files\n", stderr);
+    else if (!savestate_save_base(base))
+        fputs("deltatest: unable to save base snapshot\n", stderr);
+    else if ((dt_bank = mem_findswram(0)) < 0)
+        fputs("deltatest: no sideways RAM\n", stderr);
+    else {
+        char cmd[32];
+        snprintf(cmd, sizeof(cmd), "*SRLOAD SRDATA 8000 %X\r", dt_bank);
+        bem_paste(m, cmd, false);
+        bem_run(m, DT_CYCLES, -1);
+        if (!dt_bank_matches())
+            fputs("deltatest: *SRLOAD did not load the bank\n", stderr);
+        else if (!savestate_save_delta(delta))
+            fputs("deltatest: unable to save delta snapshot\n", stderr);
+        else {
+            rewind(base);
+            rewind(delta);
+            if (!savestate_load_file(base))
+                fputs("deltatest: unable to load base snapshot\n", stderr);
+            else if (dt_bank_matches())
+                fputs("deltatest: base snapshot already holds the loaded bank\n", stderr);
+            else if (!savestate_load_file(delta))
+                fputs("deltatest: unable to load delta snapshot\n", stderr);
+            else if (!dt_bank_matches())
+                fputs("deltatest: delta snapshot did not restore the loaded bank\n", stderr);
+            else {
+                puts("deltatest: OK");
+                status = 0;
+            }
+        }
+    }
+    bem_destroy(m);
+    bem_close();
+    return status;
+}
@@ -8,6 +8,7 @@
 #include "disc.h"
 #include "sdf.h"
 #include "imd.h"
+#include "metrics.h"
 
 #include "ddnoise.h"
 
@@ -16,6 +17,7 @@ DRIVE drives[NUM_DRIVES];
 int curdrive = 0;
 
 bool defaultwriteprot = false;
+bool disc_fast = false;
 
 int fdc_time;
 int disc_time;
@@ -32,6 +34,8 @@ void (*fdc_datacrcerror)(bool deleted);
 void (*fdc_headercrcerror)();
 void (*fdc_writeprotect)();
 int  (*fdc_getdata)(int last);
+bool (*fdc_drq)(void);
+bool (*fdc_busy)(void);
 
 int disc_load(int drive, ALLEGRO_PATH *fn)
 {
@@ -119,6 +123,30 @@ void disc_poll()
         }
 }
 
+/*
+ * Called by the sector-level disc formats from their poll functions to
+ * pace the data transfer.  Normally a byte is due every 17 polls.  In
+ * fast mode the next byte is due a few polls after the CPU has serviced
+ * the data request for the previous one.  The gap stops the FDC
+ * interrupting the NMI handler before it returns.
+ */
+
+bool disc_byte_due(int *timer)
+{
+    if (disc_fast) {
+        if (fdc_drq && fdc_drq()) {
+            *timer = 0;
+            return false;
+        }
+        if (++*timer <= 4)
+            return false;
+    }
+    else if (++*timer <= 16)
+        return false;
+    *timer = 0;
+    return true;
+}
+
 void disc_seek0(int drive, uint32_t step_time, uint32_t settle_time)
 {
     DRIVE *dp = &drives[drive];
@@ -126,7 +154,7 @@ void disc_seek0(int drive, uint32_t step_time, uint32_t settle_time)
         if (dp->seek)
             dp->seek(drive, 0);
         ddnoise_seek(-dp->curtrack);
-        fdc_time = dp->curtrack * step_time + settle_time;
+        fdc_time = disc_fast ? 200 : dp->curtrack * step_time + settle_time;
         log_debug("disc: drive %d: seek track zero, steps=%d, step_time=%'u, settle_time=%'u, fdc_time=%'d", drive, dp->curtrack, step_time, settle_time, fdc_time);
         dp->curtrack = 0;
     }
@@ -154,7 +182,7 @@ void disc_seekrelative(int drive, int tracks, uint32_t step_time, uint32_t settl
         }
         ddnoise_seek(tracks);
         dp->curtrack = newtrack;
-        fdc_time = ((tracks < 0) ? -tracks : tracks) * step_time + settle_time;
+        fdc_time = disc_fast ? 200 : ((tracks < 0) ? -tracks : tracks) * step_time + settle_time;
         log_debug("disc: drive %d: seek of %+d tracks, step_time=%'u, settle_time=%'u, fdc_time=%'d", drive, tracks, step_time, settle_time, fdc_time);
         if (dp->seek)
             dp->seek(drive, newtrack);
@@ -169,6 +197,7 @@ void disc_readsector(int drive, int sector, int track, int side, int density)
 {
         if (drives[drive].readsector) {
             autoboot = 0;
+            metrics.disc_reads++;
             drives[drive].readsector(drive, sector, track, side, density);
         }
         else
@@ -177,8 +206,10 @@ void disc_readsector(int drive, int sector, int track, int side, int density)
 
 void disc_writesector(int drive, int sector, int track, int side, int density)
 {
-        if (drives[drive].writesector)
+        if (drives[drive].writesector) {
+           metrics.disc_writes++;
            drives[drive].writesector(drive, sector, track, side, density);
+        }
         else
            disc_notfound = 10000;
 }
@@ -193,24 +224,30 @@ void disc_readaddress(int drive, int track, int side, int density)
 
 void disc_format(int drive, int track, int side, int density)
 {
-        if (drives[drive].format)
+        if (drives[drive].format) {
+           metrics.disc_writes++;
            drives[drive].format(drive, track, side, density);
+        }
         else
            disc_notfound = 10000;
 }
 
 void disc_writetrack(int drive, int track, int side, int density)
 {
-    if (drives[drive].writetrack)
+    if (drives[drive].writetrack) {
+        metrics.disc_writes++;
         drives[drive].writetrack(drive, track, side, density);
+    }
     else
         disc_format(drive, track, side, density);
 }
 
 void disc_readtrack(int drive, int track, int side, int density)
 {
-    if (drives[drive].readtrack)
+    if (drives[drive].readtrack) {
+        metrics.disc_reads++;
         drives[drive].readtrack(drive, track, side, density);
+    }
     else
        disc_notfound = 10000;
 }
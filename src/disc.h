@@ -54,6 +54,7 @@ void disc_writetrack(int drive, int track, int side, int density);
 void disc_readtrack(int drive, int track, int side, int density);
 void disc_abort(int drive);
 int disc_verify(int drive, int track, int density);
+bool disc_byte_due(int *timer);
 
 extern int disc_time;
 
@@ -72,11 +73,14 @@ extern void (*fdc_datacrcerror)(bool deleted);
 extern void (*fdc_headercrcerror)(void);
 extern void (*fdc_writeprotect)(void);
 extern int  (*fdc_getdata)(int last);
+extern bool (*fdc_drq)(void);
+extern bool (*fdc_busy)(void);
 extern int fdc_time;
 
 extern int motorspin;
 extern int motoron;
 
 extern bool defaultwriteprot;
+extern bool disc_fast;
 
 #endif
@@ -20,6 +20,7 @@
 #include "music5000.h"
 #include "mmccard.h"
 #include "paula.h"
+#include "rewind.h"
 #include "savestate.h"
 #include "sid_b-em.h"
 #include "scsi.h"
@@ -121,6 +122,8 @@ static ALLEGRO_MENU *create_file_menu(void)
     al_append_menu_item(menu, "Hard Reset", IDM_FILE_RESET, 0, NULL, NULL);
     al_append_menu_item(menu, "Load state...", IDM_FILE_LOAD_STATE, 0, NULL, NULL);
     al_append_menu_item(menu, "Save State...", IDM_FILE_SAVE_STATE, 0, NULL, NULL);
+    add_checkbox_item(menu, "Keep rewind history", IDM_FILE_REWIND, rewind_enabled);
+    al_append_menu_item(menu, "Rewind", IDM_FILE_REWIND_BACK, 0, NULL, NULL);
     al_append_menu_item(menu, "Save Screenshot...", IDM_FILE_SCREEN_SHOT, 0, NULL, NULL);
     al_append_menu_item(menu, "Save Screen as Text...", IDM_FILE_SCREEN_TEXT, 0, NULL, NULL);
     add_checkbox_item(menu, "Print to file", IDM_FILE_PRINT, print_dest == PDEST_FILE);
@@ -180,6 +183,7 @@ static ALLEGRO_MENU *create_disc_menu(void)
     add_checkbox_item(menu, "Write protect disc :0/2", menu_id_num(IDM_DISC_WPROT, 0), drives[0].writeprot);
     add_checkbox_item(menu, "Write protect disc :1/3", menu_id_num(IDM_DISC_WPROT, 1), drives[1].writeprot);
     add_checkbox_item(menu, "Default write protect", IDM_DISC_WPROT_D, defaultwriteprot);
+    add_checkbox_item(menu, "Fast disc access", IDM_DISC_FAST, disc_fast);
     add_checkbox_item(menu, "IDE hard disc", IDM_DISC_HARD_IDE, ide_enable);
     add_checkbox_item(menu, "SCSI hard disc", IDM_DISC_HARD_SCSI, scsi_enabled);
     add_checkbox_item(menu, "VDFS Enabled", IDM_DISC_VDFS_ENABLE, vdfs_enabled);
@@ -191,6 +195,8 @@ static ALLEGRO_MENU *create_disc_menu(void)
 void gui_allegro_set_eject_text(int drive, ALLEGRO_PATH *path)
 {
     char temp[256];
+    if (!disc_menu)
+        return;
     if (path)
         snprintf(temp, sizeof temp, "Eject drive %s: %s", drive ? "1/3" : "0/2", al_get_path_filename(path));
     else
@@ -217,6 +223,7 @@ static ALLEGRO_MENU *create_tape_menu(void)
     al_append_menu_item(speed, "Normal", IDM_TAPE_SPEED_NORMAL, nflags, NULL, NULL);
     al_append_menu_item(speed, "Fast", IDM_TAPE_SPEED_FAST, fflags, NULL, NULL);
     al_append_menu_item(menu, "Tape speed", 0, 0, NULL, speed);
+    add_checkbox_item(menu, "Fast load", IDM_TAPE_FASTLOAD, tape_fastload);
     return menu;
 }
 
@@ -605,6 +612,7 @@ static ALLEGRO_MENU *create_speed_menu(void)
         add_radio_item(menu, emu_speeds[i].name, IDM_SPEED, i, emuspeed);
     add_radio_item(menu, "Full-speed", IDM_SPEED, EMU_SPEED_FULL, emuspeed);
     add_checkbox_item(menu, "Auto Frameskip", IDM_AUTOSKIP, autoskip);
+    add_checkbox_item(menu, "Turbo (no video/sound)", IDM_TURBO, turbo);
     return menu;
 }
 
@@ -1222,6 +1230,12 @@ void gui_allegro_event(ALLEGRO_EVENT *event)
         case IDM_FILE_SAVE_STATE:
             file_chooser_generic(event, savestate_name, "Save state to file", "*.snp", ALLEGRO_FILECHOOSER_SAVE, savestate_save);
             break;
+        case IDM_FILE_REWIND:
+            rewind_enabled = !rewind_enabled;
+            break;
+        case IDM_FILE_REWIND_BACK:
+            rewind_step_back();
+            break;
         case IDM_FILE_SCREEN_SHOT:
             file_chooser_generic(event, vid_scrshotname, "Save screenshot to file", "*.bmp;*.pcx;*.tga;*.png;*.jpg", ALLEGRO_FILECHOOSER_SAVE, file_save_scrshot);
             break;
@@ -1312,6 +1326,9 @@ void gui_allegro_event(ALLEGRO_EVENT *event)
         case IDM_DISC_WPROT_D:
             defaultwriteprot = !defaultwriteprot;
             break;
+        case IDM_DISC_FAST:
+            disc_fast = !disc_fast;
+            break;
         case IDM_DISC_HARD_IDE:
             disc_toggle_ide(event);
             break;
@@ -1339,6 +1356,9 @@ void gui_allegro_event(ALLEGRO_EVENT *event)
         case IDM_TAPE_SPEED_FAST:
             tape_fast(event);
             break;
+        case IDM_TAPE_FASTLOAD:
+            tape_fastload = !tape_fastload;
+            break;
         case IDM_TAPE_CAT:
             gui_tapecat_start();
             break;
@@ -1478,6 +1498,12 @@ void gui_allegro_event(ALLEGRO_EVENT *event)
         case IDM_AUTOSKIP:
             autoskip = !autoskip;
             break;
+        case IDM_TURBO:
+            if (turbo)
+                main_stop_turbo();
+            else
+                main_start_turbo();
+            break;
         case IDM_DEBUGGER:
             debug_toggle_core();
             break;
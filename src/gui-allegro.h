@@ -6,6 +6,8 @@ typedef enum {
     IDM_FILE_RESET,
     IDM_FILE_LOAD_STATE,
     IDM_FILE_SAVE_STATE,
+    IDM_FILE_REWIND,
+    IDM_FILE_REWIND_BACK,
     IDM_FILE_SCREEN_SHOT,
     IDM_FILE_SCREEN_TEXT,
     IDM_FILE_PRINT,
@@ -40,6 +42,7 @@ typedef enum {
     IDM_DISC_NEW_DFS_18S_INT_80T,
     IDM_DISC_WPROT,
     IDM_DISC_WPROT_D,
+    IDM_DISC_FAST,
     IDM_DISC_HARD_IDE,
     IDM_DISC_HARD_SCSI,
     IDM_DISC_VDFS_ENABLE,
@@ -50,6 +53,7 @@ typedef enum {
     IDM_TAPE_CAT,
     IDM_TAPE_SPEED_NORMAL,
     IDM_TAPE_SPEED_FAST,
+    IDM_TAPE_FASTLOAD,
     IDM_ROMS_LOAD,
     IDM_ROMS_CLEAR,
     IDM_ROMS_RAM,
@@ -111,6 +115,7 @@ typedef enum {
     IDM_JOYSTICK2,
     IDM_SPEED,
     IDM_AUTOSKIP,
+    IDM_TURBO,
     IDM_DEBUGGER,
     IDM_DEBUG_TUBE,
     IDM_DEBUG_BREAK
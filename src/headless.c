@@ -0,0 +1,278 @@
+/*
+ * B-em headless batch runner.
+ *
+ * Boots a chosen model without creating a display, audio or any
+ * Allegro event sources and runs it unthrottled for a number of cycles
+ * or until the host 6502 reaches a given address or a memory location
+ * takes a given value.  RAM and the final frame can be dumped for
+ * comparison so large numbers of test programs can be run from scripts
+ * on machines with no display server.
+ */
+
+#include "b-em.h"
+#include <errno.h>
+#include <inttypes.h>
+
+#include "bem.h"
+#include "disc.h"
+#include "main.h"
+#include "mem.h"
+#include "metrics.h"
+#include "tape.h"
+
+#define HEADLESS_SLICE      40000
+#define HEADLESS_MAX_CYCLES 100000000
+
+enum {
+    EXIT_STOPPED = 0,   // cycle limit reached or stop condition met.
+    EXIT_FAILED  = 1,   // bad arguments or unable to start.
+    EXIT_TIMEOUT = 2    // cycle limit reached before the stop condition.
+};
+
+static const char helptext[] =
+    VERSION_STR " headless command line options:\n\n"
+    "-mx                 - start as model x (see readme.txt for models)\n"
+    "-tx                 - start with tube x (see readme.txt for tubes)\n"
+    "-disc disc.ssd      - load disc.ssd into drives :0/:2\n"
+    "-disc1 disc.ssd     - load disc.ssd into drives :1/:3\n"
+    "-autoboot           - boot disc in drive :0\n"
+    "-tape tape.uef      - load tape.uef\n"
+    "-fasttape           - set tape speed to fast\n"
+    "-fastload           - load tapes without the normal byte timing\n"
+    "-fastdisc           - transfer disc sectors without the normal byte timing\n"
+    "-turbo              - do not draw the screen until a screen dump\n"
+    "-paste string       - paste string in as if typed (via OS)\n"
+    "-pastek string      - paste string in as if typed (via KB)\n"
+    "-vroot host-dir     - set the VDFS root\n"
+    "-vdir guest-dir     - set the initial (boot) dir in VDFS\n"
+    "-cycles n           - stop after n 2MHz cycles (default 100000000)\n"
+    "-until-pc addr      - stop when the 6502 reaches hex address addr\n"
+    "-until-mem addr=val - stop when memory at hex addr holds hex val\n"
+    "                      (checked every 20ms of emulated time)\n"
+    "-dump-ram file      - write the 64K the host 6502 sees to file\n"
+    "-dump-screen file   - save the next complete frame as an image\n"
+    "-metrics dest       - report performance counters as JSON to stdout or unix:path\n\n"
+    "Exit status is 0 when stopped by the cycle limit or a condition, 2 if\n"
+    "a condition was given but the cycle limit was reached first.\n\n";
+
+static bool parse_hex(const char *str, unsigned max, unsigned *value)
+{
+    char *end;
+    unsigned long v = strtoul(str, &end, 16);
+
+    if (end == str || v > max)
+        return false;
+    *value = v;
+    return *end == 0 || *end == '=';
+}
+
+static bool dump_ram(bem_machine *m, const char *fn)
+{
+    FILE *fp = fopen(fn, "wb");
+
+    if (!fp) {
+        log_error("headless: unable to open RAM dump file '%s': %s", fn, strerror(errno));
+        return false;
+    }
+    for (unsigned addr = 0; addr < RAM_SIZE; addr++)
+        putc(bem_read(m, addr), fp);
+    fclose(fp);
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    int tapenext = 0, discnext = 0, vdfsnext = 0, pastenext = 0, argnext = 0;
+    int model = BEM_DEFAULT, tube = BEM_DEFAULT;
+    const char *vroot = NULL, *vdir = NULL;
+    const char *disc_fn[2] = { NULL, NULL }, *tape = NULL, *snap_fn = NULL;
+    const char *paste[16];
+    bool paste_kb[16];
+    int npaste = 0;
+    const char *ram_fn = NULL, *screen_fn = NULL, *metrics_fn = NULL;
+    uint64_t max_cycles = HEADLESS_MAX_CYCLES, ran = 0;
+    unsigned stop_pc = 0, stop_addr = 0, stop_val = 0;
+    bool want_pc = false, want_mem = false, boot = false;
+    const char *reason = "cycles";
+    int status = EXIT_STOPPED;
+
+    for (int c = 1; c < argc; c++) {
+        if (!strcasecmp(argv[c], "--help") || !strcmp(argv[c], "-?") || !strcasecmp(argv[c], "-h")) {
+            fwrite(helptext, sizeof helptext-1, 1, stdout);
+            return EXIT_STOPPED;
+        }
+        else if (!strcasecmp(argv[c], "-tape"))
+            tapenext = 2;
+        else if (!strcasecmp(argv[c], "-disc") || !strcasecmp(argv[c], "-disk"))
+            discnext = 1;
+        else if (!strcasecmp(argv[c], "-disc1"))
+            discnext = 2;
+        else if (!strcasecmp(argv[c], "-fasttape"))
+            fasttape = true;
+        else if (!strcasecmp(argv[c], "-fastload"))
+            tape_fastload = true;
+        else if (!strcasecmp(argv[c], "-fastdisc"))
+            disc_fast = true;
+        else if (!strcasecmp(argv[c], "-turbo"))
+            turbo = true;
+        else if (!strcasecmp(argv[c], "-autoboot"))
+            boot = true;
+        else if (!strcasecmp(argv[c], "-vroot"))
+            vdfsnext = 1;
+        else if (!strcasecmp(argv[c], "-vdir"))
+            vdfsnext = 2;
+        else if (!strcasecmp(argv[c], "-paste"))
+            pastenext = 1;
+        else if (!strcasecmp(argv[c], "-pastek"))
+            pastenext = 2;
+        else if (!strcasecmp(argv[c], "-cycles"))
+            argnext = 1;
+        else if (!strcasecmp(argv[c], "-until-pc"))
+            argnext = 2;
+        else if (!strcasecmp(argv[c], "-until-mem"))
+            argnext = 3;
+        else if (!strcasecmp(argv[c], "-dump-ram"))
+            argnext = 4;
+        else if (!strcasecmp(argv[c], "-dump-screen"))
+            argnext = 5;
+        else if (!strcasecmp(argv[c], "-metrics"))
+            argnext = 6;
+        else if (argv[c][0] == '-' && (argv[c][1] == 'm' || argv[c][1] == 'M'))
+            sscanf(&argv[c][2], "%i", &model);
+        else if (argv[c][0] == '-' && (argv[c][1] == 't' || argv[c][1] == 'T'))
+            sscanf(&argv[c][2], "%i", &tube);
+        else if (tapenext)
+            tape = argv[c];
+        else if (discnext) {
+            disc_fn[discnext-1] = argv[c];
+            discnext = 0;
+        }
+        else if (vdfsnext) {
+            if (vdfsnext == 2)
+                vdir = argv[c];
+            else
+                vroot = argv[c];
+            vdfsnext = 0;
+        }
+        else if (pastenext) {
+            if (npaste < sizeof(paste) / sizeof(paste[0])) {
+                paste_kb[npaste] = (pastenext == 2);
+                paste[npaste++] = argv[c];
+            }
+            pastenext = 0;
+        }
+        else if (argnext) {
+            switch(argnext) {
+                case 1:
+                    max_cycles = strtoull(argv[c], NULL, 0);
+                    break;
+                case 2:
+                    if (!parse_hex(argv[c], 0xffff, &stop_pc)) {
+                        fprintf(stderr, "invalid address '%s'\n", argv[c]);
+                        return EXIT_FAILED;
+                    }
+                    want_pc = true;
+                    break;
+                case 3: {
+                    const char *eq = strchr(argv[c], '=');
+                    if (!eq || !parse_hex(argv[c], 0xffff, &stop_addr) || !parse_hex(eq + 1, 0xff, &stop_val)) {
+                        fprintf(stderr, "invalid memory condition '%s'\n", argv[c]);
+                        return EXIT_FAILED;
+                    }
+                    want_mem = true;
+                    break;
+                }
+                case 4:
+                    ram_fn = argv[c];
+                    break;
+                case 5:
+                    screen_fn = argv[c];
+                    break;
+                case 6:
+                    metrics_fn = argv[c];
+            }
+            argnext = 0;
+        }
+        else {
+            const char *ext = strrchr(argv[c], '.');
+            if (ext && !strcasecmp(ext, ".snp"))
+                snap_fn = argv[c];
+            else if (ext && (!strcasecmp(ext, ".uef") || !strcasecmp(ext, ".csw"))) {
+                tape = argv[c];
+                tapenext = 0;
+            }
+            else {
+                disc_fn[0] = argv[c];
+                discnext = 0;
+                boot = true;
+            }
+        }
+        if (tapenext) tapenext--;
+    }
+
+    if (!bem_init(vroot, vdir))
+        return EXIT_FAILED;
+
+    bem_machine *m = bem_create(model, tube);
+    if (!m)
+        return EXIT_FAILED;
+    for (int d = 0; d < 2; d++) {
+        if (disc_fn[d] && !bem_load_disc(m, d, disc_fn[d], boot && d == 0))
+            status = EXIT_FAILED;
+    }
+    if (tape && !bem_load_tape(m, tape))
+        status = EXIT_FAILED;
+    if (snap_fn && !bem_load_snapshot(m, snap_fn))
+        status = EXIT_FAILED;
+    if (status != EXIT_STOPPED) {
+        bem_destroy(m);
+        return status;
+    }
+    for (int i = 0; i < npaste; i++)
+        bem_paste(m, paste[i], paste_kb[i]);
+
+    if (want_pc || want_mem)
+        reason = NULL;
+
+    if (metrics_fn) {
+        free(metrics_dest);
+        metrics_dest = strdup(metrics_fn);
+    }
+    metrics_open();
+
+    double start_time = al_get_time();
+    while (ran < max_cycles && !bem_quit_requested(m)) {
+        ran += bem_run(m, HEADLESS_SLICE, want_pc ? (int)stop_pc : -1);
+        metrics_poll();
+        if (want_pc && bem_get_pc(m) == stop_pc) {
+            reason = "pc";
+            break;
+        }
+        if (want_mem && bem_read(m, stop_addr) == stop_val) {
+            reason = "mem";
+            break;
+        }
+    }
+    double elapsed = al_get_time() - start_time;
+    metrics_close();
+
+    if (!reason) {
+        if (bem_quit_requested(m))
+            reason = "quit";
+        else {
+            reason = "timeout";
+            status = EXIT_TIMEOUT;
+        }
+    }
+    printf("headless: stopped=%s cycles=%" PRIu64 " pc=%04X time=%.3fs MHz=%.2f\n",
+           reason, ran, bem_get_pc(m), elapsed, elapsed > 0 ? ran / elapsed / 1000000 : 0.0);
+
+    if (ram_fn && !dump_ram(m, ram_fn))
+        status = EXIT_FAILED;
+    if (screen_fn && !bem_dump_screen(m, screen_fn))
+        status = EXIT_FAILED;
+
+    bem_destroy(m);
+    bem_close();
+    return status;
+}
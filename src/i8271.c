@@ -527,6 +527,16 @@ int i8271_getdata(int last)
         return i8271.data;
 }
 
+static bool i8271_drq(void)
+{
+    return i8271.status & 0x04;
+}
+
+static bool i8271_busy(void)
+{
+    return i8271.status & 0x80;
+}
+
 void i8271_reset()
 {
     if (fdc_type == FDC_I8271) {
@@ -539,6 +549,8 @@ void i8271_reset()
         fdc_headercrcerror = i8271_headercrcerror;
         fdc_writeprotect   = i8271_writeprotect;
         fdc_getdata        = i8271_getdata;
+        fdc_drq            = i8271_drq;
+        fdc_busy           = i8271_busy;
         motorspin = 45000;
         i8271.paramnum = i8271.paramreq = 0;
         i8271.status = 0;
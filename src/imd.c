@@ -1053,9 +1053,8 @@ static void imd_poll_wrtrack_datacrc(void)
 
 static void imd_poll(void)
 {
-    if (++imd_time <= 16)
+    if (!disc_byte_due(&imd_time))
         return;
-    imd_time = 0;
 
     switch(state) {
         case ST_IDLE:
@@ -6,6 +6,7 @@
 #include "model.h"
 #include "6502.h"
 #include "fullscreen.h"
+#include "rewind.h"
 #include <ctype.h>
 #include <allegro5/keyboard.h>
 
@@ -678,6 +679,12 @@ static void stop_full_speed(void)
     main_stop_fullspeed(hostshift);
 }
 
+static void stop_turbo(void)
+{
+    if (!hostshift)
+        main_stop_turbo();
+}
+
 static void do_nothing(void) {}
 
 const struct key_act_const keyact_const[KEY_ACTION_MAX] = {
@@ -686,7 +693,9 @@ const struct key_act_const keyact_const[KEY_ACTION_MAX] = {
     { "pause",        ALLEGRO_KEY_PGDN,  false, main_key_pause,          do_nothing      },
     { "full-screen1", ALLEGRO_KEY_F11,   false, toggle_fullscreen_menu, do_nothing      },
     { "debug-break",  ALLEGRO_KEY_F10,   false, debug_break,             do_nothing      },
-    { "full-screen2", ALLEGRO_KEY_ENTER, true,  toggle_fullscreen_menu, do_nothing      }
+    { "full-screen2", ALLEGRO_KEY_ENTER, true,  toggle_fullscreen_menu, do_nothing      },
+    { "turbo",        ALLEGRO_KEY_PGUP,  true,  main_start_turbo,        stop_turbo      },
+    { "rewind",       ALLEGRO_KEY_PGDN,  true,  rewind_step_back,        do_nothing      }
 };
 
 uint8_t keylookup[ALLEGRO_KEY_MAX];
@@ -940,6 +949,15 @@ static void key_paste_stop(void)
     key_paste_str = NULL;
 }
 
+void key_paste_cancel(void)
+{
+    key_paste_stop();
+    key_paste_buf_size = 0;
+    key_paste_ptr = 0;
+    kp_state = KP_IDLE;
+    key_reset();
+}
+
 static void key_paste_nextseg(void)
 {
     size_t len = key_paste_tail_size;
@@ -1189,6 +1207,67 @@ void key_up_event(const ALLEGRO_EVENT *event)
 
 static int key_paste_count;
 
+/*
+ * Save and restore a paste in progress, along with the keys it has
+ * down, so it can be put aside and carried on with later in the same
+ * process.
+ */
+
+void key_paste_save(FILE *f)
+{
+    size_t left = key_paste_ptr ? key_paste_buf_size - (key_paste_ptr - key_paste_buf) : 0;
+    size_t tail = key_paste_str ? key_paste_tail_size : 0;
+
+    putc(kp_state, f);
+    putc(key_paste_vkey_down, f);
+    putc(key_paste_shift, f);
+    putc(key_paste_ctrl, f);
+    putc(key_paste_count & 1, f);
+    fwrite(bbcmatrix, sizeof(bbcmatrix), 1, f);
+    fwrite(&left, sizeof(left), 1, f);
+    fwrite(key_paste_ptr, left, 1, f);
+    fwrite(&tail, sizeof(tail), 1, f);
+    fwrite(key_paste_tail, tail, 1, f);
+}
+
+void key_paste_load(FILE *f)
+{
+    size_t left, tail;
+
+    key_paste_cancel();
+    kp_state = getc(f);
+    key_paste_vkey_down = getc(f);
+    key_paste_shift = getc(f);
+    key_paste_ctrl = getc(f);
+    key_paste_count = getc(f);
+    if (fread(bbcmatrix, sizeof(bbcmatrix), 1, f) != 1
+        || fread(&left, sizeof(left), 1, f) != 1 || left > KEY_PASTE_BUF_CAPACITY
+        || fread(key_paste_buf, left, 1, f) != (left ? 1 : 0)
+        || fread(&tail, sizeof(tail), 1, f) != 1) {
+        log_warn("keyboard: paste state not restored");
+        key_paste_cancel();
+        return;
+    }
+    key_paste_buf_size = left;
+    key_paste_ptr = kp_state == KP_IDLE ? NULL : key_paste_buf;
+    if (tail) {
+        if ((key_paste_str = al_malloc(tail + 1))) {
+            if (fread(key_paste_str, tail, 1, f) == 1) {
+                key_paste_str[tail] = '\0';
+                key_paste_tail = key_paste_str;
+                key_paste_tail_size = tail;
+            }
+            else
+                key_paste_stop();
+        }
+        else {
+            log_warn("keyboard: out of memory restoring paste");
+            fseek(f, tail, SEEK_CUR);
+        }
+    }
+    key_update();
+}
+
 void key_paste_poll(void)
 {
     if (OS01 && key_paste_count++ & 1)
@@ -3,7 +3,7 @@
 
 extern int kbdips;
 
-#define KEY_ACTION_MAX 6
+#define KEY_ACTION_MAX 8
 
 struct key_act_const {
     const char *name;
@@ -41,6 +41,9 @@ extern void key_char_event(const ALLEGRO_EVENT *event);
 extern void key_up_event(const ALLEGRO_EVENT *event);
 extern void key_lost_focus(void);
 extern void key_paste_start(char *str);
+extern void key_paste_cancel(void);
+extern void key_paste_save(FILE *f);
+extern void key_paste_load(FILE *f);
 
 extern void key_down(uint8_t code);
 extern void key_up(uint8_t code);
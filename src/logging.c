@@ -342,6 +342,23 @@ void log_open(void)
     log_debug("log_open: log options=%x", log_options);
 }
 
+/*
+ * With no display there is nobody to dismiss a message box so send
+ * anything that would have gone to one to stderr instead.
+ */
+
+void log_no_msgbox(void)
+{
+    const log_level_t **llp, *ll;
+
+    for (llp = log_levels; (ll = *llp++); ) {
+        if (log_options & (LOG_DEST_MSGBOX << ll->shift)) {
+            log_options &= ~(LOG_DEST_MSGBOX << ll->shift);
+            log_options |= (LOG_DEST_STDERR << ll->shift);
+        }
+    }
+}
+
 void log_close(void)
 {
     if (log_fp)
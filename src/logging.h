@@ -8,6 +8,7 @@
 #endif
 
 extern void log_open(void);
+extern void log_no_msgbox(void);
 extern void log_close(void);
 extern void log_fatal(const char *fmt, ...) printflike;
 extern void log_error(const char *fmt, ...) printflike;
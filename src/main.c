@@ -27,6 +27,7 @@
 #include "keydef-allegro.h"
 #include "led.h"
 #include "main.h"
+#include "metrics.h"
 #include "6809tube.h"
 #include "mem.h"
 #include "mmb.h"
@@ -37,6 +38,7 @@
 #include "mmccard.h"
 #include "paula.h"
 #include "pal.h"
+#include "rewind.h"
 #include "savestate.h"
 #include "scsi.h"
 #include "sdf.h"
@@ -77,6 +79,7 @@ int autoboot=0;
 int joybutton[4];
 float joyaxes[4];
 int emuspeed = 4;
+bool turbo = false;
 bool tricky_sega_adapter = false;
 
 static ALLEGRO_TIMER *timer;
@@ -118,6 +121,7 @@ static int emu_speed_normal = 4;
 
 void main_reset()
 {
+    tube_thread_stop();
     m6502_reset();
     crtc_reset();
     video_reset();
@@ -147,6 +151,8 @@ static const char helptext[] =
     "-autoboot       - boot disc in drive :0\n"
     "-tape tape.uef  - load tape.uef\n"
     "-fasttape       - set tape speed to fast\n"
+    "-fastload       - load tapes without the normal byte timing\n"
+    "-fastdisc       - transfer disc sectors without the normal byte timing\n"
     "-Fx             - set maximum video frames skipped\n"
     "-s              - scanlines display mode\n"
     "-i              - interlace display mode\n"
@@ -160,7 +166,8 @@ static const char helptext[] =
     "-paste string   - paste string in as if typed (via OS)\n"
     "-pastek string  - paste string in as if typed (via KB)\n"
     "-vroot host-dir - set the VDFS root\n"
-    "-vdir guest-dir - set the initial (boot) dir in VDFS\n\n";
+    "-vdir guest-dir - set the initial (boot) dir in VDFS\n"
+    "-metrics dest   - report performance counters as JSON to stdout or unix:path\n\n";
 
 static double main_calc_timer(int speed)
 {
@@ -227,7 +234,7 @@ static void main_load_speeds(void)
 
 void main_init(int argc, char *argv[])
 {
-    int tapenext = 0, discnext = 0, execnext = 0, vdfsnext = 0, pastenext = 0;
+    int tapenext = 0, discnext = 0, execnext = 0, vdfsnext = 0, pastenext = 0, metricsnext = 0;
     ALLEGRO_DISPLAY *display;
     ALLEGRO_PATH *path;
     const char *ext, *exec_fn = NULL;
@@ -273,12 +280,18 @@ void main_init(int argc, char *argv[])
             discnext = 1;
         else if (!strcasecmp(argv[c], "-disc1"))
             discnext = 2;
+        else if (!strcasecmp(argv[c], "-metrics"))
+            metricsnext = 1;
         else if (argv[c][0] == '-' && (argv[c][1] == 'm' || argv[c][1] == 'M'))
             sscanf(&argv[c][2], "%i", &curmodel);
         else if (argv[c][0] == '-' && (argv[c][1] == 't' || argv[c][1] == 'T'))
             sscanf(&argv[c][2], "%i", &curtube);
         else if (!strcasecmp(argv[c], "-fasttape"))
             fasttape = true;
+        else if (!strcasecmp(argv[c], "-fastload"))
+            tape_fastload = true;
+        else if (!strcasecmp(argv[c], "-fastdisc"))
+            disc_fast = true;
         else if (!strcasecmp(argv[c], "-autoboot"))
             autoboot = 150;
         else if (argv[c][0] == '-' && (argv[c][1] == 'f' || argv[c][1]=='F')) {
@@ -330,6 +343,11 @@ void main_init(int argc, char *argv[])
                 vroot = argv[c];
             vdfsnext = 0;
         }
+        else if (metricsnext) {
+            free(metrics_dest);
+            metrics_dest = strdup(argv[c]);
+            metricsnext = 0;
+        }
         else if (pastenext)
             debug_paste(argv[c], pastenext == 2 ? key_paste_start : os_paste_start);
         else {
@@ -440,6 +458,7 @@ void main_init(int argc, char *argv[])
         gui_set_disc_wprot(1, drives[1].writeprot);
     main_setspeed(emuspeed);
     debug_start(exec_fn);
+    metrics_open();
     // lovebug
     if (fullscreen)
         video_enterfullscreen();
@@ -501,14 +520,42 @@ void main_stop_fullspeed(bool hostshift)
                 al_start_timer(timer);
             }
             fullspeed = FSPEED_NONE;
+            turbo = false;
         }
         else
             fullspeed = FSPEED_SELECTED;
     }
 }
 
+/*
+ * Turbo is full-speed with nothing drawn and no sound generated.  The
+ * CRTC still counts so interrupts and timing are as they would be
+ * otherwise and the screen catches up when it ends.  The SN76489 and
+ * Music 5000 are not advanced at all: their samples are dropped and
+ * their own counters left where they were.
+ */
+
+void main_start_turbo(void)
+{
+    if (!turbo) {
+        log_debug("main: starting turbo");
+        turbo = true;
+        main_start_fullspeed();
+    }
+}
+
+void main_stop_turbo(void)
+{
+    if (turbo) {
+        log_debug("main: stopping turbo");
+        turbo = false;
+        main_stop_fullspeed(false);
+    }
+}
+
 void main_key_break(void)
 {
+    tube_thread_stop();
     m6502_reset();
     video_reset();
     i8271_reset();
@@ -575,6 +622,8 @@ static void main_timer(ALLEGRO_EVENT *event)
             savestate_doload();
         if (savestate_wantsave)
             savestate_dosave();
+        rewind_poll(slice);
+        metrics_poll();
 
         if (now - prev_time > 0.1) {
             double speed = execs * slice / (now - prev_time);
@@ -704,11 +753,14 @@ void main_close()
     gui_keydefine_close();
 
     debug_kill();
+    tube_thread_stop();
 
     config_save();
     cmos_save(&models[curmodel]);
 
     midi_close();
+    rewind_reset();
+    metrics_close();
     mem_close();
     uef_close();
     csw_close();
@@ -741,6 +793,7 @@ void main_setspeed(int speed)
     else {
         al_stop_timer(timer);
         fullspeed = FSPEED_NONE;
+        turbo = false;
         if (speed != EMU_SPEED_PAUSED) {
             if (speed >= num_emu_speeds) {
                 log_warn("main: speed #%d out of range, defaulting to 100%%", speed);
@@ -757,14 +810,17 @@ void main_setspeed(int speed)
 void main_pause(const char *why)
 {
     char buf[120];
-    snprintf(buf, sizeof(buf), "%s (%s)", VERSION_STR, why);
-    al_set_window_title(tmp_display, buf);
-    al_stop_timer(timer);
+    if (tmp_display) {
+        snprintf(buf, sizeof(buf), "%s (%s)", VERSION_STR, why);
+        al_set_window_title(tmp_display, buf);
+    }
+    if (timer)
+        al_stop_timer(timer);
 }
 
 void main_resume(void)
 {
-    if (emuspeed != EMU_SPEED_PAUSED && emuspeed != EMU_SPEED_FULL)
+    if (timer && emuspeed != EMU_SPEED_PAUSED && emuspeed != EMU_SPEED_FULL)
         al_start_timer(timer);
 }
 
@@ -773,6 +829,7 @@ void main_setquit(void)
     quitting = true;
 }
 
+#ifndef HEADLESS
 int main(int argc, char **argv)
 {
     main_init(argc, argv);
@@ -780,3 +837,4 @@ int main(int argc, char **argv)
     main_close();
     return 0;
 }
+#endif
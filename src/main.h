@@ -14,6 +14,7 @@ extern const emu_speed_t *emu_speeds;
 extern int num_emu_speeds;
 extern int emuspeed;
 extern int framesrun;
+extern bool turbo;  // full-speed without drawing or sound generation.
 
 extern bool quitting;
 extern bool keydefining;
@@ -33,6 +34,8 @@ void main_setspeed(int speed);
 void main_setquit(void);
 void main_start_fullspeed(void);
 void main_stop_fullspeed(bool hostshift);
+void main_start_turbo(void);
+void main_stop_turbo(void);
 
 void main_key_break(void);
 void main_key_pause(void);
@@ -11,11 +11,55 @@ static uint8_t *mc68000_ram, *mc68000_rom;
 static bool mc68000_debug_enabled = false;
 static bool rom_low;
 
+/*
+ * Memory that can be accessed directly is found through a table of
+ * pointers to the host memory for each page, one for reads and one for
+ * writes.  A NULL entry, as for the I/O page, the ROM when writing and,
+ * while the ROM is paged in low, anywhere that would page it out, sends
+ * the access to readmem or writemem to be decoded.
+ */
+
+#define MC68000_PAGE_SHIFT 15
+#define MC68000_PAGE_SIZE  (1 << MC68000_PAGE_SHIFT)
+#define MC68000_PAGE_MASK  (MC68000_PAGE_SIZE - 1)
+#define MC68000_PAGES      (1 << (32 - MC68000_PAGE_SHIFT))
+
+static uint8_t *read_pages[MC68000_PAGES];
+static uint8_t *write_pages[MC68000_PAGES];
+
+static void map_pages(void)
+{
+    for (uint32_t page = 0; page < MC68000_PAGES; page++) {
+        uint32_t addr = page << MC68000_PAGE_SHIFT;
+        uint32_t top = addr & 0xFFFF0000;
+        uint8_t *ram = NULL;
+        if (top != 0xFFFE0000 && top != 0xFFFF0000) {
+            // RAM repeats through memory, pages that straddle the end are decoded.
+            uint32_t offset = addr % mc68000_ram_size;
+            if (offset + MC68000_PAGE_SIZE <= mc68000_ram_size)
+                ram = mc68000_ram + offset;
+        }
+        write_pages[page] = ram;
+        if (rom_low && (addr & 0x40000))
+            read_pages[page] = NULL;
+        else if (top == 0xFFFF0000)
+            read_pages[page] = mc68000_rom;
+        else if (rom_low && addr < MC68000_ROM_SIZE)
+            read_pages[page] = mc68000_rom;
+        else
+            read_pages[page] = ram;
+    }
+}
+
 static uint8_t readmem(uint32_t addr)
 {
+    const uint8_t *page = read_pages[addr >> MC68000_PAGE_SHIFT];
+    if (page)
+        return page[addr & MC68000_PAGE_MASK];
     if (rom_low) {
         if (addr & 0x40000) {
             rom_low = false;
+            map_pages();
             log_debug("mc68000: readmem paging out ROM");
         }
         else if (addr < MC68000_ROM_SIZE) {
@@ -36,13 +80,37 @@ static uint8_t readmem(uint32_t addr)
         return data;
     }
     else
-    {
-        uint8_t data = mc68000_ram[addr % mc68000_ram_size];
-        log_debug("mc68000: read %08X as RAM -> %02X", addr, data);
-        return data;
-    }
-    log_debug("mc68000: read %08X unmapped", addr);
-    return 0xff;
+        return mc68000_ram[addr % mc68000_ram_size];
+}
+
+/*
+ * Words and longs within one page are read or written in one go in the
+ * 68000's big-endian order, others byte by byte through the decode.
+ */
+
+static inline uint8_t *page_ptr(uint8_t *const *pages, uint32_t addr, unsigned size)
+{
+    uint8_t *page = pages[addr >> MC68000_PAGE_SHIFT];
+    uint32_t offset = addr & MC68000_PAGE_MASK;
+    if (page && offset <= MC68000_PAGE_SIZE - size)
+        return page + offset;
+    return NULL;
+}
+
+static inline uint32_t read_16(uint32_t addr)
+{
+    const uint8_t *ptr = page_ptr(read_pages, addr, 2);
+    if (ptr)
+        return (ptr[0] << 8) | ptr[1];
+    return (readmem(addr) << 8) | readmem(addr+1);
+}
+
+static inline uint32_t read_32(uint32_t addr)
+{
+    const uint8_t *ptr = page_ptr(read_pages, addr, 4);
+    if (ptr)
+        return ((uint32_t)ptr[0] << 24) | (ptr[1] << 16) | (ptr[2] << 8) | ptr[3];
+    return ((uint32_t)readmem(addr) << 24) | (readmem(addr+1) << 16) | (readmem(addr+2) << 8) | readmem(addr+3);
 }
 
 unsigned int m68k_read_memory_8(unsigned int address)
@@ -60,7 +128,7 @@ unsigned int m68k_read_disassembler_8(unsigned int address)
 
 unsigned int m68k_read_memory_16(unsigned int address)
 {
-    uint32_t data = (readmem(address) << 8) | readmem(address+1);
+    uint32_t data = read_16(address);
     if (mc68000_debug_enabled)
         debug_memread(&mc68000_cpu_debug, address, data, 2);
     return data;
@@ -68,12 +136,12 @@ unsigned int m68k_read_memory_16(unsigned int address)
 
 unsigned int m68k_read_disassembler_16(unsigned int address)
 {
-    return (readmem(address) << 8) | readmem(address+1);
+    return read_16(address);
 }
 
 unsigned int  m68k_read_memory_32(unsigned int address)
 {
-    uint32_t data = (readmem(address) << 24) | (readmem(address+1) << 16) | (readmem(address+2) << 8) | readmem(address+3);
+    uint32_t data = read_32(address);
     if (mc68000_debug_enabled)
         debug_memread(&mc68000_cpu_debug, address, data, 4);
     return data;
@@ -81,13 +149,46 @@ unsigned int  m68k_read_memory_32(unsigned int address)
 
 unsigned int m68k_read_disassembler_32 (unsigned int address)
 {
-    return (readmem(address) << 24) | (readmem(address+1) << 16) | (readmem(address+2) << 8) | readmem(address+3);
+    return read_32(address);
+}
+
+/*
+ * Instruction words and their extensions.  These are not passed to the
+ * debugger as data reads, PC-relative operands are.
+ */
+
+unsigned int m68k_read_immediate_16(unsigned int address)
+{
+    return read_16(address);
+}
+
+unsigned int m68k_read_immediate_32(unsigned int address)
+{
+    return read_32(address);
+}
+
+unsigned int m68k_read_pcrelative_8(unsigned int address)
+{
+    return m68k_read_memory_8(address);
+}
+
+unsigned int m68k_read_pcrelative_16(unsigned int address)
+{
+    return m68k_read_memory_16(address);
+}
+
+unsigned int m68k_read_pcrelative_32(unsigned int address)
+{
+    return m68k_read_memory_32(address);
 }
 
 static void writemem(uint32_t addr, uint8_t data)
 {
+  uint8_t *page = write_pages[addr >> MC68000_PAGE_SHIFT];
   uint32_t top = addr & 0xFFFF0000;
-  if (top == 0xFFFE0000) {
+  if (page)
+      page[addr & MC68000_PAGE_MASK] = data;
+  else if (top == 0xFFFE0000) {
       //log_debug("mc68000: write %09X as I/O <- %02X", addr, data);
       tube_parasite_write(addr, data);
   }
@@ -96,10 +197,7 @@ static void writemem(uint32_t addr, uint8_t data)
       log_debug("mc68000: write %08X as ROM (ignored) <- %02X", addr, data);
   }
   else
-  {
-    log_debug("mc68000: write %08X as RAM <- %02X", addr, data);
     mc68000_ram[addr % mc68000_ram_size] = data;
-  }
 }
 
 void m68k_write_memory_8(unsigned int address, unsigned int value)
@@ -113,18 +211,34 @@ void m68k_write_memory_16(unsigned int address, unsigned int value)
 {
     if (mc68000_debug_enabled)
         debug_memwrite(&mc68000_cpu_debug, address, value, 2);
-    writemem(address, value >> 8);
-    writemem(address+1, value);
+    uint8_t *ptr = page_ptr(write_pages, address, 2);
+    if (ptr) {
+        ptr[0] = value >> 8;
+        ptr[1] = value;
+    }
+    else {
+        writemem(address, value >> 8);
+        writemem(address+1, value);
+    }
 }
 
 void m68k_write_memory_32(unsigned int address, unsigned int value)
 {
     if (mc68000_debug_enabled)
         debug_memwrite(&mc68000_cpu_debug, address, value, 4);
-    writemem(address, value >> 24);
-    writemem(address+1, value >> 16);
-    writemem(address+2, value >> 8);
-    writemem(address+3, value);
+    uint8_t *ptr = page_ptr(write_pages, address, 4);
+    if (ptr) {
+        ptr[0] = value >> 24;
+        ptr[1] = value >> 16;
+        ptr[2] = value >> 8;
+        ptr[3] = value;
+    }
+    else {
+        writemem(address, value >> 24);
+        writemem(address+1, value >> 16);
+        writemem(address+2, value >> 8);
+        writemem(address+3, value);
+    }
 }
 
 static void mc6809nc_exec(void)
@@ -136,6 +250,7 @@ static void mc6809nc_exec(void)
 void tube_68000_rst(void)
 {
     rom_low = true;
+    map_pages();
     m68k_pulse_reset();
 }
 
@@ -191,6 +306,7 @@ bool tube_68000_init(void *rom)
     tube_proc_savestate = mc68000_savestate;
     tube_proc_loadstate = mc68000_loadstate;
     rom_low = true;
+    map_pages();
     m68k_pulse_reset();
     return true;
 }
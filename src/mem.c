@@ -133,6 +133,7 @@ void mem_loadrom(int slot, const char *name, const char *path, uint8_t use_name)
     if ((f = fopen(path, "rb"))) {
         if (fread(rom + (slot * ROM_SIZE), ROM_SIZE, 1, f) == 1 || feof(f)) {
             fclose(f);
+            m6502_flush_blocks();
             log_debug("mem: ROM slot %02d loaded with %s from %s", slot, name, path);
             rom_slots[slot].use_name = use_name;
             rom_slots[slot].alloc = 1;
@@ -376,12 +377,14 @@ void mem_clearrom(int slot) {
 
     memset(base, 0xff, ROM_SIZE);
     rom_clearmeta(slot);
+    m6502_flush_blocks();
 }
 
 void mem_clearroms(void) {
     int slot;
 
     memset(rom, 0xff, ROM_NSLOT * ROM_SIZE);
+    m6502_flush_blocks();
     for (slot = 0; slot < ROM_NSLOT; slot++) {
         rom_clearmeta(slot);
         rom_slots[slot].swram = 0;
@@ -400,15 +403,25 @@ void mem_savezlib(ZFILE *zfp)
     savestate_zwrite(zfp, rom, ROM_SIZE*ROM_NSLOT);
 }
 
+/*
+ * Restore the paging latches.  On models without ACCCON &FE34 is another
+ * copy of ROMSEL so it is written first to leave ROMSEL as saved.
+ */
+static void mem_load_latches(const unsigned char *latches)
+{
+    writemem(0xFE34, latches[1]);
+    writemem(0xFE30, latches[0]);
+}
+
 void mem_loadzlib(ZFILE *zfp)
 {
     unsigned char latches[2];
 
     savestate_zread(zfp, latches, 2);
-    writemem(0xFE30, latches[0]);
-    writemem(0xFE34, latches[1]);
+    mem_load_latches(latches);
     savestate_zread(zfp, ram, RAM_SIZE);
     savestate_zread(zfp, rom, ROM_SIZE*ROM_NSLOT);
+    m6502_flush_blocks();
 }
 
 void mem_loadstate(FILE *f) {
@@ -416,6 +429,7 @@ void mem_loadstate(FILE *f) {
     writemem(0xFE34, getc(f));
     fread(ram, RAM_SIZE, 1, f);
     fread(rom, ROM_SIZE*ROM_NSLOT, 1, f);
+    m6502_flush_blocks();
 }
 
 void mem_save_romcfg(const char *sect) {
@@ -440,6 +454,7 @@ void mem_save_romcfg(const char *sect) {
 enum mem_jim_sz mem_jim_size = JIM_NONE;
 static uint32_t mem_jim_max = 0;
 static uint8_t *mem_jim_data = NULL;
+static uint8_t *mem_jim_dirty = NULL;
 static uint32_t mem_jim_page;
 
 static const uint32_t mem_jim_sizes[6] = {
@@ -451,6 +466,19 @@ static const uint32_t mem_jim_sizes[6] = {
     0x3e000000
 };
 
+/*
+ * Start a new dirty page map for JIM memory with every page marked, as
+ * the contents are not known to match any base snapshot.  If there is
+ * no memory for the map all pages are treated as dirty.
+ */
+static void mem_jim_dirty_alloc(void)
+{
+    free(mem_jim_dirty);
+    mem_jim_dirty = NULL;
+    if (mem_jim_max > 0 && (mem_jim_dirty = malloc(mem_jim_max >> 11)))
+        memset(mem_jim_dirty, 0xff, mem_jim_max >> 11);
+}
+
 void mem_jim_setsize(enum mem_jim_sz size)
 {
     if (size != mem_jim_size) {
@@ -461,6 +489,7 @@ void mem_jim_setsize(enum mem_jim_sz size)
             mem_jim_size = size;
             mem_jim_max = nmax;
             mem_jim_data = NULL;
+            mem_jim_dirty_alloc();
         }
         else {
             uint8_t *njim = realloc(mem_jim_data, nmax);
@@ -468,6 +497,7 @@ void mem_jim_setsize(enum mem_jim_sz size)
                 mem_jim_size = size;
                 mem_jim_max = nmax;
                 mem_jim_data = njim;
+                mem_jim_dirty_alloc();
             }
             else
                 log_error("mem: out of memory allocating JIM expansion RAM");
@@ -494,8 +524,11 @@ void mem_jim_write(uint16_t addr, uint8_t value)
 {
     if (addr >= 0xfd00) {
         uint32_t full_addr = mem_jim_page | (addr & 0xff);
-        if (full_addr < mem_jim_max)
+        if (full_addr < mem_jim_max) {
             mem_jim_data[full_addr] = value;
+            if (mem_jim_dirty)
+                mem_jim_dirty[full_addr >> 11] |= 1 << ((full_addr >> 8) & 7);
+        }
     }
     else if (addr == 0xfcff)
         mem_jim_page = (mem_jim_page & 0xffff0000) | (value << 8);
@@ -530,6 +563,7 @@ extern void mem_jim_loadz(ZFILE *zfp)
     mem_jim_data = NULL;
     mem_jim_max = 0;
     mem_jim_size = JIM_NONE;
+    mem_jim_dirty_alloc();
     if (nsize > 0) {
         uint8_t *njim = malloc(nsize);
         if (njim) {
@@ -538,9 +572,155 @@ extern void mem_jim_loadz(ZFILE *zfp)
             while (mem_jim_size < JIM_INVALID && nsize != mem_jim_sizes[mem_jim_size])
                 ++mem_jim_size;
             mem_jim_page = (buf[4] << 8) | (buf[5] << 16) | (buf[6] << 24);
+            mem_jim_dirty_alloc();
             savestate_zread(zfp, njim, nsize);
         }
         else
             log_warn("mem: out of memory restoring JIM from savefile");
     }
 }
+
+/*
+ * Delta snapshots.  Pages written since the base snapshot are marked in
+ * mem_dirty for host memory and mem_jim_dirty for JIM expansion RAM so
+ * a delta need only carry those pages.  Each set of pages is saved as a
+ * count followed by the page number and contents of each page.
+ */
+
+uint8_t mem_dirty[MEM_DIRTY_PAGES >> 3];
+
+void mem_dirty_all(void)
+{
+    memset(mem_dirty, 0xff, sizeof(mem_dirty));
+}
+
+void mem_clear_dirty(void)
+{
+    memset(mem_dirty, 0, sizeof(mem_dirty));
+    if (mem_jim_dirty)
+        memset(mem_jim_dirty, 0, mem_jim_max >> 11);
+}
+
+static bool map_is_clean(const uint8_t *map, uint32_t npages)
+{
+    if (!map)
+        return npages == 0;
+    for (uint32_t i = 0; i < (npages >> 3); i++)
+        if (map[i])
+            return false;
+    return true;
+}
+
+bool mem_is_clean(void)
+{
+    return map_is_clean(mem_dirty, MEM_DIRTY_PAGES) && map_is_clean(mem_jim_dirty, mem_jim_max >> 8);
+}
+
+static uint8_t *host_page(uint32_t page)
+{
+    if (page < (RAM_SIZE >> 8))
+        return ram + (page << 8);
+    return rom + ((page << 8) - RAM_SIZE);
+}
+
+static uint8_t *jim_page(uint32_t page)
+{
+    return mem_jim_data + (page << 8);
+}
+
+static void put_le32(unsigned char *buf, uint32_t value)
+{
+    buf[0] = value;
+    buf[1] = value >> 8;
+    buf[2] = value >> 16;
+    buf[3] = value >> 24;
+}
+
+static uint32_t get_le32(const unsigned char *buf)
+{
+    return buf[0] | (buf[1] << 8) | (buf[2] << 16) | ((uint32_t)buf[3] << 24);
+}
+
+static void save_pages(ZFILE *zfp, const uint8_t *map, uint32_t npages, uint8_t *(*page_addr)(uint32_t page))
+{
+    unsigned char buf[4];
+    uint32_t count = 0;
+
+    for (uint32_t i = 0; i < (npages >> 3); i++)
+        for (unsigned bits = map ? map[i] : 0xff; bits; bits &= bits - 1)
+            count++;
+    put_le32(buf, count);
+    savestate_zwrite(zfp, buf, 4);
+    for (uint32_t i = 0; i < (npages >> 3); i++) {
+        unsigned bits = map ? map[i] : 0xff;
+        for (uint32_t page = i << 3; bits; bits >>= 1, page++) {
+            if (bits & 1) {
+                put_le32(buf, page);
+                savestate_zwrite(zfp, buf, 4);
+                savestate_zwrite(zfp, page_addr(page), 256);
+            }
+        }
+    }
+}
+
+static void load_pages(ZFILE *zfp, uint8_t *map, uint32_t npages, uint8_t *(*page_addr)(uint32_t page))
+{
+    unsigned char buf[4];
+
+    savestate_zread(zfp, buf, 4);
+    uint32_t count = get_le32(buf);
+    while (count--) {
+        savestate_zread(zfp, buf, 4);
+        uint32_t page = get_le32(buf);
+        if (page >= npages) {
+            log_error("mem: page %u out of range in delta snapshot", page);
+            return;
+        }
+        savestate_zread(zfp, page_addr(page), 256);
+        if (map)
+            map[page >> 3] |= 1 << (page & 7);
+    }
+}
+
+void mem_savedelta(ZFILE *zfp)
+{
+    unsigned char buf[7];
+
+    buf[0] = ram_fe30;
+    buf[1] = ram_fe34;
+    savestate_zwrite(zfp, buf, 2);
+    save_pages(zfp, mem_dirty, MEM_DIRTY_PAGES, host_page);
+    put_le32(buf, mem_jim_max);
+    buf[4] = (mem_jim_page >> 8) & 0xff;
+    buf[5] = (mem_jim_page >> 16) & 0xff;
+    buf[6] = (mem_jim_page >> 24) & 0xff;
+    savestate_zwrite(zfp, buf, sizeof(buf));
+    if (mem_jim_max > 0)
+        save_pages(zfp, mem_jim_dirty, mem_jim_max >> 8, jim_page);
+}
+
+/*
+ * Apply a delta to memory which matches its base snapshot.  Afterwards
+ * the pages it carried are the ones that differ from the base.
+ */
+void mem_loaddelta(ZFILE *zfp)
+{
+    unsigned char buf[7];
+
+    savestate_zread(zfp, buf, 2);
+    mem_load_latches(buf);
+    m6502_flush_blocks();
+    memset(mem_dirty, 0, sizeof(mem_dirty));
+    load_pages(zfp, mem_dirty, MEM_DIRTY_PAGES, host_page);
+    savestate_zread(zfp, buf, sizeof(buf));
+    if (get_le32(buf) != mem_jim_max) {
+        log_error("mem: JIM size in delta snapshot does not match the base");
+        return;
+    }
+    mem_jim_page = (buf[4] << 8) | (buf[5] << 16) | (buf[6] << 24);
+    if (mem_jim_max > 0) {
+        if (mem_jim_dirty)
+            memset(mem_jim_dirty, 0, mem_jim_max >> 11);
+        load_pages(zfp, mem_jim_dirty, mem_jim_max >> 8, jim_page);
+    }
+}
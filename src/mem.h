@@ -42,6 +42,21 @@ void mem_savezlib(ZFILE *zfp);
 void mem_loadzlib(ZFILE *zfp);
 void mem_loadstate(FILE *f);
 
+/*
+ * Dirty page map for delta snapshots, one bit per 256 byte page of host
+ * RAM followed by the sideways ROM/RAM banks, i.e. numbered as for the
+ * 6502 block cache.  Set by writemem, by m6502_mem_written for copies
+ * made behind its back and, for the whole map, by m6502_flush_blocks.
+ */
+#define MEM_DIRTY_PAGES ((RAM_SIZE + ROM_NSLOT * ROM_SIZE) >> 8)
+extern uint8_t mem_dirty[MEM_DIRTY_PAGES >> 3];
+
+void mem_dirty_all(void);
+void mem_clear_dirty(void);
+bool mem_is_clean(void);
+void mem_savedelta(ZFILE *zfp);
+void mem_loaddelta(ZFILE *zfp);
+
 void mem_dump(void);
 
 extern uint8_t ram_fe30, ram_fe34;
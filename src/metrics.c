@@ -0,0 +1,265 @@
+/*
+ * Performance counters.
+ *
+ * The counters are bumped where things happen and are always kept as
+ * that is cheaper than testing whether anyone wants them.  While a
+ * destination is set they are reported every metrics_interval
+ * milliseconds of host time as a JSON object on one line, the counts
+ * being totals since the stream was opened so a lost line loses
+ * nothing.  The host time taken by each scheduler client is only
+ * measured while reporting, and then from a sample of its runs.
+ *
+ * A Unix socket destination accepts any number of clients, each of
+ * which gets the lines from when it connected.  A client which is not
+ * keeping up misses lines rather than holding up the emulator, but
+ * always whole lines: the rest of a line only partly sent is kept and
+ * sent before anything else.
+ */
+
+#include "b-em.h"
+#include <errno.h>
+#ifndef WIN32
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include "6502.h"
+#include "main.h"
+#include "metrics.h"
+#include "sched.h"
+#include "video_render.h"
+
+#define METRICS_MAX_CLIENTS 8
+#define METRICS_MAX_SCHED   8
+#define METRICS_MAX_LINE    1024
+
+metrics_t metrics;
+char *metrics_dest;
+int metrics_interval = 1000;
+
+static FILE *out_fp;
+static double open_time, last_time;
+static uint64_t last_stopwatch, total_cycles;
+static metrics_t base;
+static int base_frames;
+static const char *sched_names[METRICS_MAX_SCHED];
+static double sched_base[METRICS_MAX_SCHED];
+
+#ifndef WIN32
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0  // SO_NOSIGPIPE is set on each client instead.
+#endif
+
+typedef struct {
+    int    fd;
+    size_t pending;                 // bytes of a part-sent line in buf.
+    char   buf[METRICS_MAX_LINE];
+} metrics_client;
+
+static int listen_fd = -1;
+static metrics_client clients[METRICS_MAX_CLIENTS];
+static int num_clients;
+static char *socket_path;
+
+static bool open_socket(const char *path)
+{
+    struct sockaddr_un addr;
+
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        log_error("metrics: socket path '%s' is too long", path);
+        return false;
+    }
+    if ((listen_fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0) {
+        log_error("metrics: unable to create socket: %s", strerror(errno));
+        return false;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+    unlink(path);
+    if (bind(listen_fd, (struct sockaddr *)&addr, sizeof(addr)) || listen(listen_fd, METRICS_MAX_CLIENTS)) {
+        log_error("metrics: unable to listen on socket '%s': %s", path, strerror(errno));
+        close(listen_fd);
+        listen_fd = -1;
+        return false;
+    }
+    fcntl(listen_fd, F_SETFL, fcntl(listen_fd, F_GETFL) | O_NONBLOCK);
+    socket_path = strdup(path);
+    return true;
+}
+
+static void accept_clients(void)
+{
+    int fd;
+
+    while ((fd = accept(listen_fd, NULL, NULL)) >= 0) {
+        if (num_clients < METRICS_MAX_CLIENTS) {
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+#ifdef SO_NOSIGPIPE
+            int on = 1;
+            setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+            clients[num_clients].fd = fd;
+            clients[num_clients++].pending = 0;
+            log_debug("metrics: client connected");
+        }
+        else {
+            log_warn("metrics: too many clients, connection refused");
+            close(fd);
+        }
+    }
+}
+
+/*
+ * Send as much as the socket will take, keeping the rest.  Returns
+ * false if the client has gone.
+ */
+static bool client_send(metrics_client *c, const char *data, size_t len)
+{
+    ssize_t sent = send(c->fd, data, len, MSG_NOSIGNAL);
+    if (sent < 0)
+        return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+    c->pending = len - sent;
+    memmove(c->buf, data + sent, c->pending);
+    return true;
+}
+
+static void send_clients(const char *line, size_t len)
+{
+    for (int i = 0; i < num_clients; ) {
+        metrics_client *c = &clients[i];
+        bool ok = true;
+        if (c->pending)
+            ok = client_send(c, c->buf, c->pending);
+        if (ok && !c->pending)
+            ok = client_send(c, line, len);
+        if (!ok) {
+            log_debug("metrics: client disconnected");
+            close(c->fd);
+            *c = clients[--num_clients];
+        }
+        else
+            i++;
+    }
+}
+
+static void close_socket(void)
+{
+    for (int i = 0; i < num_clients; i++)
+        close(clients[i].fd);
+    num_clients = 0;
+    if (listen_fd >= 0) {
+        close(listen_fd);
+        listen_fd = -1;
+    }
+    if (socket_path) {
+        unlink(socket_path);
+        free(socket_path);
+        socket_path = NULL;
+    }
+}
+#endif
+
+void metrics_open(void)
+{
+    if (!metrics_dest || !*metrics_dest)
+        return;
+    if (!strcasecmp(metrics_dest, "stdout"))
+        out_fp = stdout;
+#ifndef WIN32
+    else if (!strncasecmp(metrics_dest, "unix:", 5)) {
+        if (!open_socket(metrics_dest + 5))
+            return;
+    }
+#endif
+    else {
+        log_error("metrics: unknown destination '%s', expected stdout or unix:path", metrics_dest);
+        return;
+    }
+    if (metrics_interval < 10)
+        metrics_interval = 10;
+    base = metrics;
+    last_stopwatch = stopwatch;
+    total_cycles = 0;
+    base_frames = framesrun;
+    double secs[METRICS_MAX_SCHED];
+    int count = sched_times(sched_names, secs, METRICS_MAX_SCHED);
+    for (int i = 0; i < count; i++)
+        sched_base[i] = secs[i];
+    open_time = last_time = al_get_time();
+    sched_timing = true;
+    log_info("metrics: reporting to %s every %dms", metrics_dest, metrics_interval);
+}
+
+static bool metrics_active(void)
+{
+#ifndef WIN32
+    if (listen_fd >= 0)
+        return true;
+#endif
+    return out_fp;
+}
+
+#define COUNT(name) (unsigned long long)(metrics.name - base.name)
+
+void metrics_poll(void)
+{
+    if (!metrics_active())
+        return;
+    double now = al_get_time();
+    if ((now - last_time) * 1000 < metrics_interval)
+        return;
+
+    char line[METRICS_MAX_LINE];
+    // the stopwatch starts over when the machine is reset.
+    uint64_t cycles = stopwatch >= last_stopwatch ? stopwatch - last_stopwatch : stopwatch;
+    double mhz = cycles / (now - last_time) / 1000000;
+    uint64_t frames = framesrun - base_frames;
+    total_cycles += cycles;
+    size_t len = snprintf(line, sizeof(line),
+        "{\"time\":%.3f,\"mhz\":%.3f,\"cycles\":%llu,\"instructions\":%llu,"
+        "\"polls\":%llu,\"frames\":%llu,\"frames_skipped\":%llu,\"fskipmax\":%d,"
+        "\"sound_overruns\":%llu,\"tube_cycles\":%llu,\"disc_reads\":%llu,"
+        "\"disc_writes\":%llu,\"tape_bytes\":%llu,\"poll_secs\":{",
+        now - open_time, mhz, (unsigned long long)total_cycles, COUNT(instructions),
+        COUNT(polls), (unsigned long long)frames, (unsigned long long)(frames - COUNT(frames_drawn)),
+        vid_fskipmax, COUNT(sound_overruns), COUNT(tube_cycles), COUNT(disc_reads),
+        COUNT(disc_writes), COUNT(tape_bytes));
+    double secs[METRICS_MAX_SCHED];
+    int count = sched_times(sched_names, secs, METRICS_MAX_SCHED);
+    for (int i = 0; i < count && len < sizeof(line); i++)
+        len += snprintf(line + len, sizeof(line) - len, "%s\"%s\":%.6f", i ? "," : "", sched_names[i], secs[i] - sched_base[i]);
+    if (len < sizeof(line))
+        len += snprintf(line + len, sizeof(line) - len, "}}\n");
+    if (len >= sizeof(line)) {
+        // a cut-down line would not be valid JSON so skip it altogether.
+        log_warn("metrics: report too long for buffer, dropped");
+        last_time = now;
+        last_stopwatch = stopwatch;
+        return;
+    }
+
+    if (out_fp) {
+        fputs(line, out_fp);
+        fflush(out_fp);
+    }
+#ifndef WIN32
+    if (listen_fd >= 0) {
+        accept_clients();
+        send_clients(line, len);
+    }
+#endif
+    last_time = now;
+    last_stopwatch = stopwatch;
+}
+
+void metrics_close(void)
+{
+    sched_timing = false;
+    out_fp = NULL;
+#ifndef WIN32
+    close_socket();
+#endif
+}
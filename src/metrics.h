@@ -0,0 +1,28 @@
+#ifndef __INC_METRICS_H
+#define __INC_METRICS_H
+
+/*
+ * Performance counters, written as a stream of JSON objects, one per
+ * line, to stdout or to clients of a Unix socket every so often.
+ */
+
+typedef struct {
+    uint64_t instructions;    // host 6502 instructions executed.
+    uint64_t polls;           // calls to polltime.
+    uint64_t frames_drawn;    // frames drawn, others being skipped.
+    uint64_t sound_overruns;  // sound buffers dropped as the stream was full.
+    uint64_t tube_cycles;     // cycles given to the parasite.
+    uint64_t disc_reads;      // sectors and tracks read.
+    uint64_t disc_writes;     // sectors and tracks written or formatted.
+    uint64_t tape_bytes;      // bytes received from tape.
+} metrics_t;
+
+extern metrics_t metrics;
+extern char *metrics_dest;      // "stdout" or "unix:path", NULL if off.
+extern int metrics_interval;    // milliseconds between reports.
+
+void metrics_open(void);
+void metrics_poll(void);
+void metrics_close(void);
+
+#endif
@@ -351,6 +351,7 @@ static void tube_init(void)
 
 void model_init()
 {
+    tube_thread_stop();
     model_check();
 
     if (curtube == -1)
@@ -32,7 +32,9 @@
 #include "main.h"
 #include <allegro5/allegro_audio.h>
 #include "sound.h"
+#include "music5000.h"
 #include "savestate.h"
+#include "sched.h"
 
 #define I_WAVEFORM(n) ((n)*128)
 #define I_WFTOP (14*128)
@@ -120,8 +122,16 @@ void music5000_savestate(FILE *f) {
         putc_unlocked('m', f);
 }
 
+static int music5000_next(void)
+{
+    return SCHED_MAX_DELAY;
+}
+
+static const sched_client_t music5000_client = { "music5000", music5000_poll, music5000_next };
+
 void music5000_init(int speed)
 {
+    sched_register(&music5000_client);
     if (sound_music5000) {
         unsigned new_freq = FREQ_M5;
         if (speed < num_emu_speeds)
@@ -500,28 +510,43 @@ static void music5000_get_sample(const m5000_fcoeff *fcp)
     music5000_buf[music5000_bufpos++] = sr;
 }
 
+/*
+ * Three samples are due every 128 cycles.  Work out how many are owed
+ * and generate them in runs that stop only at the end of a fragment.
+ */
+
 void music5000_poll(int cycles)
 {
     if (sound_music5000) {
+        int samples = 0;
+
         music5000_time -= cycles;
-        if (music5000_time < 0) {
+        while (music5000_time < 0) {
+            samples += 3;
+            music5000_time += 128;
+        }
+        if (turbo)
+            samples = 0;
+        while (samples > 0) {
             if (!music5000_buf) {
                 music5000_buf = al_get_audio_stream_fragment(music5000_stream);
                 log_debug("music5000: late buffer allocation %s", music5000_buf ? "worked" : "failed");
+                if (!music5000_buf)
+                    break;
             }
-            if (music5000_buf) {
-                const m5000_fcoeff *fcp = music5000_fno < 0 ? NULL : &m500_filters[music5000_fno];
-                music5000_get_sample(fcp);
-                music5000_get_sample(fcp);
+            const m5000_fcoeff *fcp = music5000_fno < 0 ? NULL : &m500_filters[music5000_fno];
+            int len = buflen_m5 - music5000_bufpos / 2;
+            if (len > samples)
+                len = samples;
+            samples -= len;
+            while (len--)
                 music5000_get_sample(fcp);
-                if (music5000_bufpos >= (buflen_m5*2)) {
-                    al_set_audio_stream_fragment(music5000_stream, music5000_buf);
-                    al_set_audio_stream_playing(music5000_stream, true);
-                    music5000_buf = al_get_audio_stream_fragment(music5000_stream);
-                    music5000_bufpos = 0;
-                }
+            if (music5000_bufpos >= (buflen_m5*2)) {
+                al_set_audio_stream_fragment(music5000_stream, music5000_buf);
+                al_set_audio_stream_playing(music5000_stream, true);
+                music5000_buf = al_get_audio_stream_fragment(music5000_stream);
+                music5000_bufpos = 0;
             }
-            music5000_time += 128;
         }
     }
 }
@@ -152,7 +152,7 @@ static void fillbuf2(int& count, int16_t *buf, int len)
 }
 void sid_fillbuf(int16_t *buf, int len)
 {
-        int x=64;
+        int x = len * (1000000 / FREQ_SID);
         
         fillbuf2(x,buf,len);
 }
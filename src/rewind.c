@@ -0,0 +1,259 @@
+/*
+ * Rewind: a ring of snapshots held in memory from which the machine
+ * can be stepped backwards.
+ *
+ * Every rewind_interval frames a snapshot is taken through the
+ * savestate code, mostly as a delta against the last base snapshot so
+ * only the pages of memory that changed are kept, with a fresh base
+ * every REWIND_BASE_EVERY snapshots.  The oldest snapshots are dropped
+ * to stay within rewind_budget megabytes, a base taking its deltas with
+ * it.  Stepping back loads the base and then the wanted delta.
+ *
+ * The savestate code works on stdio files so each snapshot is written
+ * to a memory stream, whose buffer is then kept as is, and read back
+ * through a stream opened on that buffer.  Windows has no memory
+ * streams so there one temporary file, made once, is used both ways.
+ */
+
+#include "b-em.h"
+#include <errno.h>
+#ifdef WIN32
+#include <io.h>
+#endif
+
+#include "debugger.h"
+#include "main.h"
+#include "model.h"
+#include "rewind.h"
+#include "savestate.h"
+#include "tube.h"
+
+#define REWIND_MAX_SNAPS   1024
+#define REWIND_BASE_EVERY  16
+#define REWIND_FRAME_CYCLES 40000
+
+bool rewind_enabled;
+int rewind_interval = 25;
+int rewind_budget = 64;
+int rewind_wanted;
+
+struct rewind_snap {
+    unsigned char *data;
+    size_t size;
+    bool base;
+};
+
+static struct rewind_snap snaps[REWIND_MAX_SNAPS];
+static int snap_count;
+static size_t snap_bytes;
+static int since_base = -1;  // deltas since the last base, -1 for none.
+static int frame_cycles;
+static FILE *scratch;
+
+static void rewind_drop(int first, int count)
+{
+    for (int i = first; i < first + count; i++) {
+        snap_bytes -= snaps[i].size;
+        free(snaps[i].data);
+    }
+    memmove(snaps + first, snaps + first + count, (snap_count - first - count) * sizeof(struct rewind_snap));
+    snap_count -= count;
+}
+
+void rewind_reset(void)
+{
+    rewind_drop(0, snap_count);
+    since_base = -1;
+    frame_cycles = 0;
+    if (scratch) {
+        fclose(scratch);
+        scratch = NULL;
+    }
+}
+
+int rewind_available(void)
+{
+    return snap_count;
+}
+
+/*
+ * Drop the oldest base and its deltas until the ring is back within
+ * its limits.  If that would drop the base the newest snapshots depend
+ * on the ring starts over.
+ */
+static void rewind_evict(void)
+{
+    size_t budget = (size_t)rewind_budget << 20;
+
+    while (snap_count > 0 && (snap_bytes > budget || snap_count >= REWIND_MAX_SNAPS)) {
+        int next = 1;
+        while (next < snap_count && !snaps[next].base)
+            next++;
+        if (next == snap_count) {
+            log_debug("rewind: budget too small for one base and its deltas, starting over");
+            rewind_drop(0, snap_count);
+            since_base = -1;
+            return;
+        }
+        rewind_drop(0, next);
+    }
+}
+
+#ifndef WIN32
+
+static unsigned char *rewind_save(bool base, size_t *sizep)
+{
+    char *data = NULL;
+    size_t size = 0;
+    FILE *fp = open_memstream(&data, &size);
+
+    if (!fp) {
+        log_error("rewind: unable to open memory stream: %s", strerror(errno));
+        return NULL;
+    }
+    bool worked = base ? savestate_save_base(fp) : savestate_save_delta(fp);
+    fclose(fp);
+    if (!worked || !size) {
+        free(data);
+        return NULL;
+    }
+    *sizep = size;
+    return (unsigned char *)data;
+}
+
+static bool rewind_load(const struct rewind_snap *snap)
+{
+    FILE *fp = fmemopen(snap->data, snap->size, "rb");
+
+    if (!fp) {
+        log_error("rewind: unable to open memory stream: %s", strerror(errno));
+        return false;
+    }
+    bool worked = savestate_load_file(fp);
+    fclose(fp);
+    return worked;
+}
+
+#else
+
+static bool rewind_scratch(void)
+{
+    if (!scratch && !(scratch = tmpfile())) {
+        log_error("rewind: unable to create temporary file: %s", strerror(errno));
+        return false;
+    }
+    fseek(scratch, 0, SEEK_SET);
+    return true;
+}
+
+static unsigned char *rewind_save(bool base, size_t *sizep)
+{
+    if (!rewind_scratch())
+        return NULL;
+    bool worked = base ? savestate_save_base(scratch) : savestate_save_delta(scratch);
+    long size = ftell(scratch);
+    if (!worked || size <= 0)
+        return NULL;
+    unsigned char *data = malloc(size);
+    if (!data) {
+        log_error("rewind: out of memory for snapshot");
+        return NULL;
+    }
+    fseek(scratch, 0, SEEK_SET);
+    if (fread(data, size, 1, scratch) != 1) {
+        log_error("rewind: unable to read back snapshot: %s", strerror(errno));
+        free(data);
+        return NULL;
+    }
+    *sizep = size;
+    return data;
+}
+
+/* The file is cut to the snapshot so nothing left from a longer one is read. */
+static bool rewind_load(const struct rewind_snap *snap)
+{
+    if (!rewind_scratch())
+        return false;
+    if (fwrite(snap->data, snap->size, 1, scratch) != 1 || fflush(scratch) || _chsize(_fileno(scratch), snap->size)) {
+        log_error("rewind: unable to write snapshot to temporary file: %s", strerror(errno));
+        return false;
+    }
+    fseek(scratch, 0, SEEK_SET);
+    return savestate_load_file(scratch);
+}
+
+#endif
+
+static void rewind_take(void)
+{
+    bool base = since_base < 0 || since_base >= REWIND_BASE_EVERY - 1;
+    size_t size;
+    unsigned char *data = rewind_save(base, &size);
+
+    if (!data) {
+        rewind_reset();
+        return;
+    }
+    if (base)
+        since_base = 0;
+    else
+        since_base++;
+    snaps[snap_count].data = data;
+    snaps[snap_count].size = size;
+    snaps[snap_count].base = base;
+    snap_count++;
+    snap_bytes += size;
+    rewind_evict();
+}
+
+/*
+ * Go back to the nth newest snapshot.  It and those newer are dropped
+ * so stepping back again goes further back.
+ */
+static void rewind_restore(int n)
+{
+    if (!snap_count) {
+        log_info("rewind: no snapshots to rewind to");
+        return;
+    }
+    if (n > snap_count)
+        n = snap_count;
+    int target = snap_count - n;
+    int base = target;
+    while (!snaps[base].base)
+        base--;
+    if (!rewind_load(&snaps[base]) || (target != base && !rewind_load(&snaps[target]))) {
+        log_error("rewind: unable to restore snapshot, discarding rewind history");
+        rewind_reset();
+        return;
+    }
+    log_debug("rewind: restored snapshot %d of %d", target, snap_count);
+    rewind_drop(target, snap_count - target);
+    since_base = (target == base) ? -1 : target - base - 1;
+    frame_cycles = 0;
+    if (debug_core || debug_tube)
+        debug_step = 1;
+}
+
+void rewind_step_back(void)
+{
+    rewind_wanted++;
+}
+
+void rewind_poll(int cycles)
+{
+    if (rewind_wanted) {
+        rewind_restore(rewind_wanted);
+        rewind_wanted = 0;
+    }
+    else if (rewind_enabled) {
+        frame_cycles += cycles;
+        if (frame_cycles >= rewind_interval * REWIND_FRAME_CYCLES) {
+            frame_cycles = 0;
+            if (curtube == -1 || tube_proc_savestate)
+                rewind_take();
+        }
+    }
+    else if (snap_count)
+        rewind_reset();
+}
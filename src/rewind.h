@@ -0,0 +1,19 @@
+#ifndef __INC_REWIND_H
+#define __INC_REWIND_H
+
+/*
+ * Rewind: a ring of snapshots held in memory, taken every few frames
+ * while enabled, from which the machine can be stepped backwards.
+ */
+
+extern bool rewind_enabled;
+extern int rewind_interval;  // frames between snapshots.
+extern int rewind_budget;    // megabytes of memory for the ring.
+extern int rewind_wanted;    // snapshots to step back at the next poll.
+
+void rewind_poll(int cycles);
+void rewind_step_back(void);
+int rewind_available(void);
+void rewind_reset(void);
+
+#endif
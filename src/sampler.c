@@ -0,0 +1,326 @@
+/*
+ * Sampling profiler.
+ *
+ * The call stack of each CPU is followed by watching for calls and the
+ * returns that match them.  An instruction is taken to be a call when
+ * its mnemonic says so, as found from the CPU's disassembler, and
+ * control does not pass to the next instruction.  The return address
+ * is then pushed on a shadow stack and when control later passes to a
+ * return address on that stack without passing to the next
+ * instruction the frames down to it are popped.  That copes with code
+ * that discards return addresses to return further up the stack.
+ *
+ * What each instruction is, its length and whether it is a call, is
+ * kept in a cache indexed by the low bits of the PC so the
+ * disassembler is only used the first time an instruction is seen.
+ */
+
+#include "b-em.h"
+#include <ctype.h>
+#include <strings.h>
+
+#include "6502.h"
+#include "sampler.h"
+
+#define SAMPLER_MAX_DEPTH  64
+#define SAMPLER_CACHE      4096
+#define SAMPLER_BUCKETS    4096
+#define SAMPLER_MAX_STACKS 65536
+
+struct frame {
+    uint32_t ret;     // where the call returns to.
+    uint32_t target;  // the subroutine called.
+};
+
+struct code_entry {
+    uint32_t pc;
+    uint32_t next;
+    uint32_t opcode;  // first unit at the PC, to see if the code changed.
+    bool     valid;
+    bool     call;
+};
+
+struct stack_entry {
+    struct stack_entry *next;
+    uint32_t hash;
+    unsigned count;
+    int      depth;
+    uint32_t addrs[];  // the subroutines called then the PC.
+};
+
+struct sampler {
+    unsigned interval;
+    uint64_t next_sample;
+    uint32_t prev_next;
+    bool     prev_call;
+    int      depth;
+    unsigned stacks;
+    unsigned lost;
+    struct frame frames[SAMPLER_MAX_DEPTH];
+    struct stack_entry *buckets[SAMPLER_BUCKETS];
+    struct code_entry code[SAMPLER_CACHE];
+};
+
+static const char *const call_mnemonics[] = {
+    "BL", "BLX", "BSR", "CALL", "CALLF", "CXP", "CXPD", "JSL", "JSR",
+    "LBSR", "LCALL", "RST", NULL
+};
+
+static const char *const arm_conditions[] = {
+    "EQ", "NE", "CS", "CC", "HS", "LO", "MI", "PL", "VS", "VC", "HI",
+    "LS", "GE", "LT", "GT", "LE", "AL", NULL
+};
+
+static bool in_list(const char *const *list, const char *word)
+{
+    for (; *list; list++)
+        if (!strcasecmp(*list, word))
+            return true;
+    return false;
+}
+
+/*
+ * Find the mnemonic in a line of disassembly by skipping the address,
+ * which is followed by a colon, and the instruction bytes, which are
+ * all hex digits, and see if it is one of a call.
+ */
+static bool is_call(const char *text)
+{
+    const char *ptr = text;
+    char word[16];
+
+    while (*ptr && *ptr != '\\') {
+        if (!isalnum((unsigned char)*ptr) && *ptr != '_') {
+            ptr++;
+            continue;
+        }
+        const char *start = ptr;
+        bool hex = true;
+        while (isalnum((unsigned char)*ptr) || *ptr == '_' || *ptr == '.') {
+            if (!isxdigit((unsigned char)*ptr))
+                hex = false;
+            ptr++;
+        }
+        if (*ptr == ':' || hex)
+            continue;
+        size_t len = ptr - start;
+        const char *dot = memchr(start, '.', len);
+        if (dot)
+            len = dot - start;
+        if (len >= sizeof(word))
+            return false;
+        memcpy(word, start, len);
+        word[len] = '\0';
+        if (in_list(call_mnemonics, word))
+            return true;
+        return len == 4 && !strncasecmp(word, "BL", 2) && in_list(arm_conditions, word + 2);
+    }
+    return false;
+}
+
+static const struct code_entry *classify(cpu_debug_t *cpu, struct sampler *smp, uint32_t addr)
+{
+    struct code_entry *ce = smp->code + (addr % SAMPLER_CACHE);
+    uint32_t opcode = cpu->memread(addr);
+
+    if (!ce->valid || ce->pc != addr || ce->opcode != opcode) {
+        char buf[256];
+        ce->pc = addr;
+        ce->next = cpu->disassemble(cpu, addr, buf, sizeof(buf));
+        ce->opcode = opcode;
+        ce->call = is_call(buf);
+        ce->valid = true;
+    }
+    return ce;
+}
+
+static uint32_t hash_stack(const uint32_t *addrs, int depth)
+{
+    uint32_t hash = 2166136261u;
+    for (int i = 0; i < depth; i++)
+        hash = (hash ^ addrs[i]) * 16777619u;
+    return hash;
+}
+
+static void take_sample(struct sampler *smp, uint32_t addr)
+{
+    uint32_t addrs[SAMPLER_MAX_DEPTH + 1];
+    int depth = smp->depth;
+
+    for (int i = 0; i < depth; i++)
+        addrs[i] = smp->frames[i].target;
+    addrs[depth++] = addr;
+
+    uint32_t hash = hash_stack(addrs, depth);
+    struct stack_entry **bucket = smp->buckets + (hash % SAMPLER_BUCKETS);
+    for (struct stack_entry *se = *bucket; se; se = se->next) {
+        if (se->hash == hash && se->depth == depth && !memcmp(se->addrs, addrs, depth * sizeof(uint32_t))) {
+            se->count++;
+            return;
+        }
+    }
+    struct stack_entry *se = NULL;
+    if (smp->stacks < SAMPLER_MAX_STACKS)
+        se = malloc(sizeof(struct stack_entry) + depth * sizeof(uint32_t));
+    if (!se) {
+        smp->lost++;
+        return;
+    }
+    se->hash = hash;
+    se->count = 1;
+    se->depth = depth;
+    memcpy(se->addrs, addrs, depth * sizeof(uint32_t));
+    se->next = *bucket;
+    *bucket = se;
+    smp->stacks++;
+}
+
+void sampler_exec(cpu_debug_t *cpu, uint32_t addr)
+{
+    struct sampler *smp = cpu->sampler;
+
+    if (addr != smp->prev_next) {
+        if (smp->prev_call) {
+            if (smp->depth == SAMPLER_MAX_DEPTH) {
+                memmove(smp->frames, smp->frames + 1, (SAMPLER_MAX_DEPTH - 1) * sizeof(struct frame));
+                smp->depth--;
+            }
+            smp->frames[smp->depth].ret = smp->prev_next;
+            smp->frames[smp->depth].target = addr;
+            smp->depth++;
+        }
+        else {
+            for (int d = smp->depth - 1; d >= 0; d--) {
+                if (smp->frames[d].ret == addr) {
+                    smp->depth = d;
+                    break;
+                }
+            }
+        }
+    }
+    const struct code_entry *ce = classify(cpu, smp, addr);
+    smp->prev_next = ce->next;
+    smp->prev_call = ce->call;
+
+    if (stopwatch >= smp->next_sample) {
+        take_sample(smp, addr);
+        smp->next_sample = stopwatch + smp->interval;
+    }
+    else if (smp->next_sample - stopwatch > smp->interval)
+        smp->next_sample = stopwatch + smp->interval;  // the clock was reset.
+}
+
+static void free_stacks(struct sampler *smp)
+{
+    for (int b = 0; b < SAMPLER_BUCKETS; b++) {
+        struct stack_entry *se = smp->buckets[b];
+        while (se) {
+            struct stack_entry *next = se->next;
+            free(se);
+            se = next;
+        }
+        smp->buckets[b] = NULL;
+    }
+    smp->stacks = 0;
+    smp->lost = 0;
+}
+
+void sampler_reset(cpu_debug_t *cpu)
+{
+    if (cpu->sampler)
+        free_stacks(cpu->sampler);
+}
+
+void sampler_stop(cpu_debug_t *cpu)
+{
+    struct sampler *smp = cpu->sampler;
+    if (smp) {
+        cpu->sampler = NULL;
+        free_stacks(smp);
+        free(smp);
+    }
+}
+
+bool sampler_start(cpu_debug_t *cpu, unsigned interval)
+{
+    struct sampler *smp = cpu->sampler;
+
+    if (!smp) {
+        if (!(smp = calloc(1, sizeof(struct sampler)))) {
+            log_error("sampler: out of memory");
+            return false;
+        }
+        smp->prev_next = cpu->get_instr_addr();
+        cpu->sampler = smp;
+    }
+    smp->interval = interval ? interval : 1;
+    smp->next_sample = stopwatch + smp->interval;
+    return true;
+}
+
+static int stack_cmp(const void *a, const void *b)
+{
+    const struct stack_entry *sa = *(const struct stack_entry *const *)a;
+    const struct stack_entry *sb = *(const struct stack_entry *const *)b;
+    if (sa->count != sb->count)
+        return sa->count < sb->count ? 1 : -1;
+    return 0;
+}
+
+static size_t frame_name(cpu_debug_t *cpu, uint32_t addr, char *buf, size_t bufsize)
+{
+    const char *sym;
+    size_t len;
+
+    if (symbol_find_by_addr(cpu->symbols, addr, &sym))
+        len = snprintf(buf, bufsize, "%s", sym);
+    else
+        len = cpu->print_addr(cpu, addr, buf, bufsize, false);
+    return len < bufsize ? len : bufsize - 1;
+}
+
+/*
+ * Write the stacks sampled, the most often first, to a file or if none
+ * is given to the debugger.  Returns the number of samples written.
+ */
+unsigned sampler_write(cpu_debug_t *cpu, FILE *fp, debug_outf_t outf, unsigned limit)
+{
+    struct sampler *smp = cpu->sampler;
+    unsigned total = 0;
+
+    if (!smp || !smp->stacks)
+        return 0;
+    struct stack_entry **list = malloc(smp->stacks * sizeof(struct stack_entry *));
+    if (!list) {
+        log_error("sampler: out of memory");
+        return 0;
+    }
+    unsigned count = 0;
+    for (int b = 0; b < SAMPLER_BUCKETS; b++)
+        for (struct stack_entry *se = smp->buckets[b]; se; se = se->next)
+            list[count++] = se;
+    qsort(list, count, sizeof(struct stack_entry *), stack_cmp);
+    if (limit && count > limit)
+        count = limit;
+
+    for (unsigned i = 0; i < count; i++) {
+        const struct stack_entry *se = list[i];
+        char line[(SAMPLER_MAX_DEPTH + 1) * (SYM_MAX + 2) + 32];
+        size_t len = 0;
+        for (int d = 0; d < se->depth && len < sizeof(line) - (SYM_MAX + 32); d++) {
+            if (d)
+                line[len++] = ';';
+            len += frame_name(cpu, se->addrs[d], line + len, sizeof(line) - len - 16);
+        }
+        snprintf(line + len, sizeof(line) - len, " %u", se->count);
+        if (fp)
+            fprintf(fp, "%s\n", line);
+        else
+            outf("%s\n", line);
+        total += se->count;
+    }
+    free(list);
+    if (smp->lost)
+        log_warn("sampler: %u samples lost, too many different stacks", smp->lost);
+    return total;
+}
@@ -0,0 +1,25 @@
+#ifndef __INC_SAMPLER_H
+#define __INC_SAMPLER_H
+
+#include <stdbool.h>
+#include <stdio.h>
+#include "cpu_debug.h"
+
+/*
+ * Sampling profiler.
+ *
+ * While running, every interval cycles of the 2MHz system clock the
+ * PC of a CPU is recorded with its call stack, which is followed from
+ * the calls and returns seen as it executes.  The samples are written
+ * in the collapsed stack format taken by flame graph tools, one line
+ * per stack of the frames from outermost to innermost separated by
+ * semicolons then a space and the count.
+ */
+
+extern bool sampler_start(cpu_debug_t *cpu, unsigned interval);
+extern void sampler_stop(cpu_debug_t *cpu);
+extern void sampler_reset(cpu_debug_t *cpu);
+extern void sampler_exec(cpu_debug_t *cpu, uint32_t addr);
+extern unsigned sampler_write(cpu_debug_t *cpu, FILE *fp, debug_outf_t outf, unsigned limit);
+
+#endif
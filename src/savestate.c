@@ -1,6 +1,7 @@
 /*B-em v2.2 by Tom Walker
   Savestate handling*/
 #include "b-em.h"
+#include <time.h>
 #include <zlib.h>
 
 #include "6502.h"
@@ -31,6 +32,17 @@ int savestate_wantsave, savestate_wantload;
 char *savestate_name;
 FILE *savestate_fp;
 
+/*
+ * Base and delta snapshots.  A base snapshot is a full snapshot which
+ * also records an identifier, after which memory writes are tracked so
+ * a delta snapshot need only carry the pages that have changed since.
+ * A delta has no model section, so loading it does not restart the
+ * machine, and it only applies to its own base, loaded immediately
+ * before it.  That needs both loaded in one go by savestate_load_file,
+ * so the deferred load behind the GUI and command line refuses deltas.
+ */
+static uint32_t savestate_base_id;
+
 void savestate_save(const char *name)
 {
     log_debug("savestate: save, name=%s", name);
@@ -75,7 +87,13 @@ void savestate_load(const char *name)
             unsigned char magic[8];
             if (fread(magic, 8, 1, fp) == 1 && memcmp(magic, "BEMSNAP", 7) == 0) {
                 int vers = magic[7];
-                if (vers >= '1' && vers <= '3') {
+                if (vers == '4') {
+                    /* The machine runs on after loading a base so a delta
+                     * could never apply by the time it was picked. */
+                    log_error("savestate: %s is a delta snapshot, which can only be loaded together with its base, not on its own", name);
+                    fclose(fp);
+                }
+                else if (vers >= '1' && vers <= '3') {
                     char *name_copy = strdup(name);
                     if (name_copy) {
                         if (savestate_name)
@@ -190,13 +208,33 @@ void savestate_zwrite(ZFILE *zfp, void *src, size_t size)
     log_warn("savestate: compression error %d (%s)", res, zfp->zs.msg);
 }
 
-void savestate_dosave(void)
+static void put_base_id(FILE *fp)
+{
+    unsigned char buf[4];
+    buf[0] = savestate_base_id;
+    buf[1] = savestate_base_id >> 8;
+    buf[2] = savestate_base_id >> 16;
+    buf[3] = savestate_base_id >> 24;
+    fwrite(buf, sizeof(buf), 1, fp);
+}
+
+static uint32_t get_base_id(FILE *fp)
+{
+    unsigned char buf[4];
+    if (fread(buf, sizeof(buf), 1, fp) != 1)
+        return 0;
+    return buf[0] | (buf[1] << 8) | (buf[2] << 16) | ((uint32_t)buf[3] << 24);
+}
+
+static void save_delta_hdr(FILE *fp)
+{
+    put_base_id(fp);
+    savestate_save_var(curmodel, fp);
+    savestate_save_var(curtube + 1, fp);
+}
+
+static void save_devices(FILE *fp)
 {
-    FILE *fp = savestate_fp;
-    fwrite("BEMSNAP3", 8,1, fp);
-    save_sect(fp, 'm', model_savestate);
-    save_sect(fp, '6', m6502_savestate);
-    save_zlib(fp, 'M', mem_savezlib);
     save_sect(fp, 'S', sysvia_savestate);
     save_sect(fp, 'U', uservia_savestate);
     save_sect(fp, 'V', videoula_savestate);
@@ -209,12 +247,43 @@ void savestate_dosave(void)
     save_sect(fp, 'F', vdfs_savestate);
     save_sect(fp, '5', music5000_savestate);
     save_sect(fp, 'p', paula_savestate);
-    save_zlib(fp, 'J', mem_jim_savez);
+}
+
+static void save_tube(FILE *fp)
+{
     if (curtube != -1) {
         save_sect(fp, 'T', tube_ula_savestate);
         save_zlib(fp, 'P', tube_proc_savestate);
     }
-    fclose(fp);
+}
+
+static void save_state(FILE *fp)
+{
+    tube_thread_sync();
+    fwrite("BEMSNAP3", 8,1, fp);
+    save_sect(fp, 'm', model_savestate);
+    save_sect(fp, '6', m6502_savestate);
+    save_zlib(fp, 'M', mem_savezlib);
+    save_devices(fp);
+    save_zlib(fp, 'J', mem_jim_savez);
+    save_tube(fp);
+}
+
+static void save_delta_state(FILE *fp)
+{
+    tube_thread_sync();
+    fwrite("BEMSNAP4", 8,1, fp);
+    save_sect(fp, 'b', save_delta_hdr);
+    save_sect(fp, '6', m6502_savestate);
+    save_zlib(fp, 'D', mem_savedelta);
+    save_devices(fp);
+    save_tube(fp);
+}
+
+void savestate_dosave(void)
+{
+    save_state(savestate_fp);
+    fclose(savestate_fp);
     savestate_wantsave = 0;
     savestate_fp = NULL;
 }
@@ -349,6 +418,13 @@ static void load_section(FILE *fp, int key, long size)
             break;
         case 'J':
             load_zlib(size, mem_jim_loadz);
+            break;
+        case 'D':
+            load_zlib(size, mem_loaddelta);
+            break;
+        case 'B':
+            savestate_base_id = get_base_id(fp);
+            mem_clear_dirty();
     }
     long end = ftell(fp);
     if (end == start) {
@@ -390,9 +466,37 @@ static void load_state_three(FILE *fp)
     }
 }
 
-void savestate_doload(void)
+/*
+ * Check the header section of a delta snapshot against the base that
+ * was loaded last and that memory has not changed since.
+ */
+static bool delta_applies(FILE *fp)
+{
+    unsigned char hdr[3];
+
+    if (fread(hdr, sizeof hdr, 1, fp) != 1 || hdr[0] != 'b') {
+        log_error("savestate: delta snapshot has no base identifier");
+        return false;
+    }
+    long start = ftell(fp);
+    uint32_t id = get_base_id(fp);
+    unsigned model = savestate_load_var(fp);
+    int tube = (int)savestate_load_var(fp) - 1;
+    fseek(fp, start + (hdr[1] | (hdr[2] << 8)), SEEK_SET);
+    if (!id || id != savestate_base_id || (int)model != curmodel || tube != curtube) {
+        log_error("savestate: delta snapshot does not belong to the base snapshot last loaded");
+        return false;
+    }
+    if (!mem_is_clean()) {
+        log_error("savestate: memory has changed since the base snapshot was loaded, reload it before the delta");
+        return false;
+    }
+    return true;
+}
+
+static bool load_state(FILE *fp)
 {
-    FILE *fp = savestate_fp;
+    tube_thread_stop();
     switch(savestate_wantload) {
         case '1':
             load_state_one(fp);
@@ -403,14 +507,112 @@ void savestate_doload(void)
         case '3':
             load_state_three(fp);
             break;
+        case '4':
+            if (!delta_applies(fp))
+                return false;
+            load_state_three(fp);
+            break;
     }
-    if (ferror(fp))
+    if (ferror(fp)) {
         log_error("savestate: state not fully restored from V%c file '%s': %s", savestate_wantload, savestate_name, strerror(errno));
-    else
-        log_debug("savestate: loaded V%c snapshot file", savestate_wantload);
-    fclose(fp);
+        return false;
+    }
+    log_debug("savestate: loaded V%c snapshot file", savestate_wantload);
+    return true;
+}
+
+void savestate_doload(void)
+{
+    load_state(savestate_fp);
+    fclose(savestate_fp);
+    savestate_wantload = 0;
+    savestate_fp = NULL;
+}
+
+/*
+ * Save and restore state to a file the caller has already opened and
+ * which is left open, e.g. a temporary file used to park the state of
+ * one machine while another runs.  These happen immediately and so must
+ * only be called between calls to the 6502 exec functions.
+ *
+ * savestate_save_base writes a full snapshot and starts tracking
+ * changes against it, savestate_save_delta the changes since then.
+ * savestate_load_file loads either, a delta only straight after its
+ * base.
+ */
+
+static bool save_file_check(void)
+{
+    if (savestate_fp) {
+        log_error("savestate: an operation is already in progress");
+        return false;
+    }
+    if (curtube != -1 && !tube_proc_savestate) {
+        log_error("savestate: current tube processor does not support saving state");
+        return false;
+    }
+    return true;
+}
+
+bool savestate_save_file(FILE *fp)
+{
+    if (!save_file_check())
+        return false;
+    savestate_fp = fp;
+    save_state(fp);
+    savestate_fp = NULL;
+    return !ferror(fp);
+}
+
+bool savestate_save_base(FILE *fp)
+{
+    static uint32_t base_count;
+
+    if (!save_file_check())
+        return false;
+    do
+        savestate_base_id = (uint32_t)time(NULL) * 2654435761u + ++base_count;
+    while (!savestate_base_id);
+    savestate_fp = fp;
+    save_state(fp);
+    save_sect(fp, 'B', put_base_id);
+    mem_clear_dirty();
+    savestate_fp = NULL;
+    return !ferror(fp);
+}
+
+bool savestate_save_delta(FILE *fp)
+{
+    if (!save_file_check())
+        return false;
+    if (!savestate_base_id) {
+        log_error("savestate: no base snapshot for a delta");
+        return false;
+    }
+    savestate_fp = fp;
+    save_delta_state(fp);
+    savestate_fp = NULL;
+    return !ferror(fp);
+}
+
+bool savestate_load_file(FILE *fp)
+{
+    unsigned char magic[8];
+
+    if (savestate_fp) {
+        log_error("savestate: an operation is already in progress");
+        return false;
+    }
+    if (fread(magic, 8, 1, fp) != 1 || memcmp(magic, "BEMSNAP", 7) || magic[7] < '1' || magic[7] > '4') {
+        log_error("savestate: not a B-Em snapshot");
+        return false;
+    }
+    savestate_fp = fp;
+    savestate_wantload = magic[7];
+    bool worked = load_state(fp);
     savestate_wantload = 0;
     savestate_fp = NULL;
+    return worked;
 }
 
 void savestate_save_var(unsigned var, FILE *f) {
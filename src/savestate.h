@@ -1,6 +1,7 @@
 #ifndef __INC_SAVESTATE_H
 #define __INC_SAVESTATE_H
 
+#include <stdbool.h>
 #include <stdio.h>
 
 typedef struct _sszfile ZFILE;
@@ -12,6 +13,10 @@ void savestate_save(const char *name);
 void savestate_load(const char *name);
 void savestate_dosave(void);
 void savestate_doload(void);
+bool savestate_save_file(FILE *);
+bool savestate_save_base(FILE *);
+bool savestate_save_delta(FILE *);
+bool savestate_load_file(FILE *);
 
 void savestate_zread(ZFILE *zfp, void *dest, size_t size);
 void savestate_zwrite(ZFILE *zfp, void *src, size_t size);
@@ -0,0 +1,77 @@
+#include "b-em.h"
+#include "sched.h"
+
+#define MAX_CLIENTS 8
+#define TIME_SAMPLE 64  // while timing, time one run in this many.
+
+static const sched_client_t *clients[MAX_CLIENTS];
+static double client_secs[MAX_CLIENTS];
+static int num_clients;
+static unsigned time_count;
+
+int sched_elapsed;
+int sched_due;
+bool sched_timing;
+
+void sched_register(const sched_client_t *client)
+{
+    for (int i = 0; i < num_clients; i++)
+        if (clients[i] == client)
+            return;
+    if (num_clients >= MAX_CLIENTS) {
+        log_fatal("sched: too many clients registering %s", client->name);
+        exit(1);
+    }
+    log_debug("sched: registered client %s", client->name);
+    clients[num_clients++] = client;
+    sched_resched();
+}
+
+void sched_sync(void)
+{
+    int elapsed = sched_elapsed;
+    int due = SCHED_MAX_DELAY;
+    bool reached = elapsed >= sched_due;
+
+    sched_elapsed = 0;
+    if (elapsed > 0) {
+        if (sched_timing && !(++time_count & (TIME_SAMPLE - 1))) {
+            for (int i = 0; i < num_clients; i++) {
+                double start = al_get_time();
+                clients[i]->run(elapsed);
+                client_secs[i] += (al_get_time() - start) * TIME_SAMPLE;
+            }
+        }
+        else
+            for (int i = 0; i < num_clients; i++)
+                clients[i]->run(elapsed);
+    }
+    if (!reached) {
+        // no client was due, so each is that much nearer its deadline.
+        sched_due -= elapsed;
+        return;
+    }
+    for (int i = 0; i < num_clients; i++) {
+        int next = clients[i]->next();
+        if (next < due)
+            due = next;
+    }
+    sched_due = due > 0 ? due : 1;
+}
+
+/*
+ * Fetch the names of the clients and the host time in seconds each has
+ * taken while sched_timing was set, returning how many there are.  As
+ * reading the clock costs about as much as a short run only one run in
+ * TIME_SAMPLE is timed and the times are estimates scaled up from that.
+ */
+
+int sched_times(const char **names, double *secs, int max)
+{
+    int count = num_clients < max ? num_clients : max;
+    for (int i = 0; i < count; i++) {
+        names[i] = clients[i]->name;
+        secs[i] = client_secs[i];
+    }
+    return count;
+}
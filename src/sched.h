@@ -0,0 +1,59 @@
+#ifndef __INC_SCHED_H
+#define __INC_SCHED_H
+
+/*
+ * Cycle-stamped event scheduler for the host 6502.
+ *
+ * Peripherals whose state only changes in an interesting way when a
+ * counter runs out (VIA timers, the sound generators) register a
+ * client here rather than being polled on every CPU cycle.  The CPU
+ * loop then only has to compare one running total against the next
+ * deadline and the clients are brought up to date in one go when it
+ * is reached.
+ *
+ * Not everything is a client.  Video and the CRTC are still polled on
+ * every cycle as they draw as they go, the disc is ticked from the CPU
+ * loop as the disc formats pace transfers by counting polls, and the
+ * ACIA, tape, ADC, IDE and mouse are still polled together every 128
+ * cycles between instructions.
+ *
+ * Anything that may observe the state of a client, such as an I/O
+ * access, must call sched_sync() first so the clients are current.
+ * That only works out the deadlines again if one was reached, so
+ * anything that may alter a deadline must also call sched_resched().
+ */
+
+#define SCHED_MAX_DELAY 2048  // longest a client may go without being run.
+
+typedef struct {
+    const char *name;
+    void (*run)(int cycles);  // advance the client by a number of cycles.
+    int  (*next)(void);       // cycles until the client is next due.
+} sched_client_t;
+
+extern int sched_elapsed;  // cycles since the clients were last run.
+extern int sched_due;      // value of sched_elapsed at which to run them.
+extern bool sched_timing;  // keep the host time each client takes.
+
+void sched_register(const sched_client_t *client);
+void sched_sync(void);
+int sched_times(const char **names, double *secs, int max);
+
+static inline void sched_poll(int cycles)
+{
+    if ((sched_elapsed += cycles) >= sched_due)
+        sched_sync();
+}
+
+/*
+ * Called after something may have changed the deadline of a client
+ * without running it, e.g. an I/O write, so that the deadlines are
+ * worked out again at the next poll.
+ */
+
+static inline void sched_resched(void)
+{
+    sched_due = sched_elapsed;
+}
+
+#endif
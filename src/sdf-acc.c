@@ -23,6 +23,33 @@ FILE *sdf_fp[NUM_DRIVES], *mmb_fp;
 off_t mmb_offset[NUM_DRIVES][2];
 static const struct sdf_geometry *geometry[NUM_DRIVES];
 
+/*
+ * While a drive is spun up the part of the image file it can reach is
+ * held in memory so the FDC data path does not need to go through
+ * stdio.  The cache is loaded on first access after the file has been
+ * locked at spinup and modified pages are written back, and the cache
+ * discarded, at spindown or when the disc is closed.  For an ordinary
+ * image file this is the whole file; for a disc within an MMB file
+ * each side is cached separately.  The size of an ordinary image file
+ * is found when it is first cached and again only after it has been
+ * written to.
+ */
+
+#define SDF_PAGE_SIZE 256
+
+typedef struct {
+    uint8_t  *data;
+    uint8_t  *dirty;    // bitmap, one bit per page.
+    off_t     base;     // file offset of data[0].
+    uint32_t  size;
+    bool      anydirty;
+} sdf_cache_t;
+
+static sdf_cache_t sdf_cache[NUM_DRIVES][2];
+static sdf_cache_t *sdf_cur;  // cache for the current transfer.
+static uint32_t     sdf_pos;  // position within it.
+static long         sdf_size[NUM_DRIVES]; // image file size, -1 if not known.
+
 typedef enum {
     ST_IDLE,
     ST_NOTFOUND,
@@ -59,9 +86,145 @@ static uint8_t sdf_side;
 static uint8_t sdf_track;
 static uint8_t sdf_sector;
 
+static void sdf_cache_flush(int drive, sdf_cache_t *cache)
+{
+    FILE *fp = sdf_fp[drive];
+    uint32_t page, npages, start, end;
+
+    if (!cache->anydirty)
+        return;
+    npages = (cache->size + SDF_PAGE_SIZE - 1) / SDF_PAGE_SIZE;
+    for (page = 0; page < npages; ) {
+        if (!(cache->dirty[page >> 3] & (1 << (page & 7)))) {
+            page++;
+            continue;
+        }
+        start = page;
+        while (page < npages && (cache->dirty[page >> 3] & (1 << (page & 7))))
+            page++;
+        start *= SDF_PAGE_SIZE;
+        end = page * SDF_PAGE_SIZE;
+        if (end > cache->size)
+            end = cache->size;
+        log_debug("sdf: drive %d: writing back %u bytes at offset %lu", drive, end - start, (unsigned long)(cache->base + start));
+        if (fseek(fp, cache->base + start, SEEK_SET) || fwrite(cache->data + start, end - start, 1, fp) != 1)
+            log_error("sdf: drive %d: error writing disc image: %s", drive, strerror(errno));
+    }
+    sdf_size[drive] = -1;
+    memset(cache->dirty, 0, (npages + 7) / 8);
+    cache->anydirty = false;
+}
+
+static void sdf_cache_drop(int drive)
+{
+    for (int side = 0; side < 2; side++) {
+        sdf_cache_t *cache = &sdf_cache[drive][side];
+        if (cache->data) {
+            sdf_cache_flush(drive, cache);
+            /* Keep the cache for a transfer still in progress. */
+            if (cache != sdf_cur || state == ST_IDLE) {
+                free(cache->data);
+                free(cache->dirty);
+                cache->data = NULL;
+                cache->dirty = NULL;
+                if (cache == sdf_cur)
+                    sdf_cur = NULL;
+            }
+        }
+    }
+}
+
+static long sdf_file_size(int drive)
+{
+    FILE *fp = sdf_fp[drive];
+
+    if (sdf_size[drive] < 0 && !fseek(fp, 0, SEEK_END))
+        sdf_size[drive] = ftell(fp);
+    return sdf_size[drive];
+}
+
+/*
+ * Return the cache holding the given side of the disc in a drive,
+ * loading it if need be.
+ */
+
+static sdf_cache_t *sdf_cache_get(const struct sdf_geometry *geo, int drive, int side)
+{
+    FILE *fp = sdf_fp[drive];
+    sdf_cache_t *cache;
+    off_t base;
+    uint32_t size, track_bytes = geo->sectors_per_track * geo->sector_size;
+    size_t got;
+
+    if (fp == mmb_fp) {
+        base = mmb_offset[drive][side];
+        if (side)
+            base += geo->tracks * track_bytes;
+        size = geo->tracks * track_bytes;
+    }
+    else {
+        side = 0;
+        base = 0;
+        size = geo->tracks * track_bytes;
+        if (geo->sides != SDF_SIDES_SINGLE)
+            size *= 2;
+        /* Larger than its geometry suggests, e.g. an ADFS image. */
+        long fsize = sdf_file_size(drive);
+        if (fsize > 0 && (unsigned long)fsize > size)
+            size = fsize;
+    }
+    cache = &sdf_cache[drive][side];
+    if (cache->data) {
+        if (cache->base == base && cache->size == size)
+            return cache;
+        sdf_cache_drop(drive);
+    }
+    uint32_t npages = (size + SDF_PAGE_SIZE - 1) / SDF_PAGE_SIZE;
+    if (!(cache->data = malloc(size)) || !(cache->dirty = calloc((npages + 7) / 8, 1))) {
+        log_error("sdf: drive %d: out of memory caching disc image", drive);
+        free(cache->data);
+        cache->data = NULL;
+        return NULL;
+    }
+    cache->base = base;
+    cache->size = size;
+    cache->anydirty = false;
+    got = 0;
+    if (!fseek(fp, base, SEEK_SET))
+        got = fread(cache->data, 1, size, fp);
+    /* Beyond the end of the file reads as formatted but empty. */
+    memset(cache->data + got, 0xe5, size - got);
+    log_debug("sdf: drive %d: cached %u bytes at offset %lu (%lu from file)", drive, size, (unsigned long)base, (unsigned long)got);
+    return cache;
+}
+
+static inline int sdf_getbyte(void)
+{
+    if (sdf_cur && sdf_pos < sdf_cur->size)
+        return sdf_cur->data[sdf_pos++];
+    sdf_pos++;
+    return 0xe5;
+}
+
+static inline void sdf_putbyte(uint8_t b)
+{
+    if (sdf_cur && sdf_pos < sdf_cur->size) {
+        uint32_t page = sdf_pos / SDF_PAGE_SIZE;
+        sdf_cur->data[sdf_pos] = b;
+        sdf_cur->dirty[page >> 3] |= 1 << (page & 7);
+        sdf_cur->anydirty = true;
+    }
+    sdf_pos++;
+}
+
 static void sdf_close(int drive)
 {
     if (drive < NUM_DRIVES) {
+        if (sdf_fp[drive]) {
+            if (sdf_cur == &sdf_cache[drive][0] || sdf_cur == &sdf_cache[drive][1])
+                state = ST_IDLE; // abandon any transfer in progress.
+            sdf_cache_drop(drive);
+        }
         geometry[drive] = NULL;
         if (sdf_fp[drive]) {
             if (sdf_fp[drive] != mmb_fp)
@@ -83,7 +246,7 @@ static int sdf_verify(int drive, int track, int density)
     return 0;
 }
 
-static bool io_seek(const struct sdf_geometry *geo, uint8_t drive, uint8_t sector, uint8_t track, uint8_t side)
+static bool io_offset(const struct sdf_geometry *geo, uint8_t drive, uint8_t sector, uint8_t track, uint8_t side, off_t *offp)
 {
     uint32_t track_bytes, offset;
 
@@ -112,7 +275,7 @@ static bool io_seek(const struct sdf_geometry *geo, uint8_t drive, uint8_t secto
             }
             offset += sector * geo->sector_size + mmb_offset[drive][side];
             log_debug("sdf: drive %u: seeking for side=%u, track=%u, sector=%u to %d bytes\n", drive, side, track, sector, offset);
-            fseek(sdf_fp[drive], offset, SEEK_SET);
+            *offp = offset;
             return true;
         }
         else
@@ -123,15 +286,38 @@ static bool io_seek(const struct sdf_geometry *geo, uint8_t drive, uint8_t secto
     return false;
 }
 
+/*
+ * Point the transfer at a sector within the cached image.
+ */
+
+static bool io_seek(const struct sdf_geometry *geo, uint8_t drive, uint8_t sector, uint8_t track, uint8_t side)
+{
+    off_t offset;
+
+    if (io_offset(geo, drive, sector, track, side, &offset)) {
+        if ((sdf_cur = sdf_cache_get(geo, drive, side))) {
+            sdf_pos = offset - sdf_cur->base;
+            return true;
+        }
+    }
+    return false;
+}
+
 FILE *sdf_owseek(uint8_t drive, uint8_t sector, uint8_t track, uint8_t side, uint16_t ssize)
 {
     const struct sdf_geometry *geo;
+    off_t offset;
 
     if (drive < NUM_DRIVES) {
         if ((geo = geometry[drive])) {
             if (ssize == geo->sector_size) {
-                if (io_seek(geo, drive, sector, track, side))
+                if (io_offset(geo, drive, sector, track, side, &offset)) {
+                    /* The caller uses the file directly. */
+                    sdf_cache_drop(drive);
+                    sdf_size[drive] = -1;
+                    fseek(sdf_fp[drive], offset, SEEK_SET);
                     return sdf_fp[drive];
+                }
             }
             else
                 log_debug("sdf: osword seek, sector size %u does not match disk (%u)", ssize, geo->sector_size);
@@ -351,7 +537,7 @@ static void sdf_poll_wrtrack_data(void)
     int b = fdc_getdata(0);
     log_debug("sdf: sdf_poll_wrtrack_data0 byte=%02X, count=%d", b, count);
     if (b != -1) {
-        putc(b, sdf_fp[sdf_drive]);
+        sdf_putbyte(b);
         if (!--count)
             state = ST_WRTRACK_DATACRC;
     }
@@ -378,9 +564,8 @@ static void sdf_poll()
     int c;
     uint16_t sect_size;
 
-    if (++sdf_time <= 16)
+    if (!disc_byte_due(&sdf_time))
         return;
-    sdf_time = 0;
 
     switch(state) {
         case ST_IDLE:
@@ -394,9 +579,7 @@ static void sdf_poll()
             break;
 
         case ST_READSECTOR:
-            if ((c = getc(sdf_fp[sdf_drive])) == EOF)
-                c = 0xe5;
-            fdc_data(c);
+            fdc_data(sdf_getbyte());
             if (--count == 0) {
                 fdc_finishread(false);
                 state = ST_IDLE;
@@ -415,7 +598,7 @@ static void sdf_poll()
                 log_warn("sdf: data underrun on write");
                 count++;
             } else {
-                putc(c, sdf_fp[sdf_drive]);
+                sdf_putbyte(c);
                 if (count == 0) {
                     fdc_finishread(false);
                     state = ST_IDLE;
@@ -490,9 +673,9 @@ static void sdf_poll()
             fdc_getdata(--count == 0);  // discard sector size.
             log_debug("sdf: poll format secsz, count=%d, sector=%d", count, sdf_sector);
             if (sdf_sector < geometry[sdf_drive]->sectors_per_track) {
-                log_debug("sdf: poll format secsz, filling at offset %lu", ftell(sdf_fp[sdf_drive]));
+                log_debug("sdf: poll format secsz, filling at offset %lu", (unsigned long)(sdf_cur->base + sdf_pos));
                 for (unsigned i = 0; i < geometry[sdf_drive]->sector_size; i++)
-                    putc(0xe5, sdf_fp[sdf_drive]);
+                    sdf_putbyte(0xe5);
                 sdf_sector++;
             }
             if (count == 0) {
@@ -577,6 +760,7 @@ static void sdf_spindown(int drive)
     FILE *fp = sdf_fp[drive];
     log_debug("sdf: spindown drive %d", drive);
     if (fp) {
+        sdf_cache_drop(drive);
         fflush(fp);
 #ifndef WIN32
         sdf_lock(drive, fp, F_UNLCK);
@@ -587,6 +771,7 @@ static void sdf_spindown(int drive)
 void sdf_mount(int drive, const char *fn, FILE *fp, const struct sdf_geometry *geo)
 {
     sdf_fp[drive] = fp;
+    sdf_size[drive] = -1;
     log_info("Loaded drive %d with %s, format %s, %s, %d tracks, %s, %d %d byte sectors/track",
              drive, fn, geo->name, sdf_desc_sides(geo), geo->tracks,
              sdf_desc_dens(geo), geo->sectors_per_track, geo->sector_size);
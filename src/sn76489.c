@@ -65,80 +65,138 @@ static void sn_updaterectwave(int d)
 
 
 
-void sn_fillbuf(int16_t *buffer, int len)
+/*
+ * Generate a block of samples.  The tone channels are done one at a
+ * time: each stays at the same point in its waveform until its counter
+ * runs out so it is added in runs of equal samples and the counter is
+ * stepped by however many periods have passed rather than one at a
+ * time.  The noise channel is done the same way but last as its output
+ * is added in floating point and so depends on the total so far.
+ * Blocks are split where the rectangle wave changes.
+ */
+
+static void sn_tone(int16_t *buffer, int len, int c)
 {
-        int c, d;
-        static int sidcount = 0;
-        uint8_t sdb_data;
+    int16_t amp[32];
+    uint32_t latch = sn_latch[c];
+    int count = sn_count[c];
+    int stat = sn_stat[c];
+    int d = 0;
 
-        if (sysvia_get_sn_data(&sdb_data))
-                sn_write(sdb_data);
+    if (latch > 256) {
+        for (int i = 0; i < 32; i++)
+            amp[i] = (int16_t) (snwaves[curwave][i] * volslog[sn_vol[c]]);
+    }
+    else {
+        int16_t flat = (int16_t) (volslog[sn_vol[c]] * 127);
+        for (int i = 0; i < 32; i++)
+            amp[i] = flat;
+    }
 
-        for (d = 0; d < len; d++)
-        {
-                for (c = 0; c < 3; c++)
-                {
-                        c++;
-                        if (sn_latch[c] > 256) buffer[d] += (int16_t) (snwaves[curwave][sn_stat[c]] * volslog[sn_vol[c]]);
-                        else                   buffer[d] += (int16_t) (volslog[sn_vol[c]] * 127);
-
-                        sn_count[c] -= 2048;
-                        while ((int)sn_count[c] < 0  && sn_latch[c])
-                        {
-                                sn_count[c] += sn_latch[c];
-                                sn_stat[c]++;
-                                sn_stat[c] &= 31;
-                        }
-                        c--;
-                }
-                if (!(sn_noise & 4))
-                {
-                        if (curwave == 4) buffer[d] += (snwaves[4][sn_stat[0] & 31] * volslog[sn_vol[0]]);
-                        else              buffer[d] += (((sn_shift & 1) ^ 1) * 127 * volslog[sn_vol[0]] * 2);
-                }
-                else    buffer[d] += (((sn_shift & 1) ^ 1) * 127 * volslog[sn_vol[0]] * 2);
+    while (d < len) {
+        int run = len - d;
+        if (latch) {
+            int due = (count >= 0) ? count / 2048 + 1 : 1;
+            if (due < run)
+                run = due;
+        }
+        int16_t a = amp[stat];
+        for (int i = 0; i < run; i++)
+            buffer[d + i] += a;
+        d += run;
+        count = (int)((unsigned)count - 2048u * run);
+        if (count < 0 && latch) {
+            unsigned steps = ((unsigned)-count + latch - 1) / latch;
+            count += steps * latch;
+            stat = (stat + steps) & 31;
+        }
+    }
+    sn_count[c] = count;
+    sn_stat[c] = stat;
+}
 
-                sn_count[0] -= 128;
-                while ((int)sn_count[0] < 0 && sn_latch[0])
-                {
-                        sn_count[0] += (sn_latch[0] * 2);
-                        if (!(sn_noise & 4))
-                        {
-                                if (sn_shift & 1) sn_shift |= 0x8000;
-                                sn_shift >>= 1;
-                        }
-                        else
-                        {
-                                if ((sn_shift & 1) ^ ((sn_shift >> 1) & 1)) sn_shift |= 0x8000;
-                                sn_shift >>= 1;
-                        }
-                        sn_stat[0]++;
-                }
-                if (!(sn_noise & 4))
-                {
-                        while (sn_stat[0] >= 30) sn_stat[0] -= 30;
-                }
-                else
-                   sn_stat[0] &= 32767;
-//                buffer[d] += (lpt_dac * 32);
+static void sn_noise_block(int16_t *buffer, int len)
+{
+    float vol = volslog[sn_vol[0]];
+    float noise_amp = 127 * vol * 2;
+    bool rect = !(sn_noise & 4) && curwave == 4;
+    int d = 0;
 
-                sidcount++;
-                if (sidcount == 2496)
-                {
-                        sidcount = 0;
-                        if (!sn_rect_dir)
-                        {
-                                sn_rect_pos++;
-                                if (sn_rect_pos == 30) sn_rect_dir = 1;
-                        }
-                        else
-                        {
-                                sn_rect_pos--;
-                                if (sn_rect_pos == 1) sn_rect_dir = 0;
-                        }
-                        sn_updaterectwave(sn_rect_pos);
-                }
+    while (d < len) {
+        int run = len - d;
+        if (sn_stat[0] >= ((sn_noise & 4) ? 32768 : 30))
+            run = 1; // left over from the other mode, wrapped below.
+        else if (sn_latch[0]) {
+            int due = (sn_count[0] >= 0) ? sn_count[0] / 128 + 1 : 1;
+            if (due < run)
+                run = due;
+        }
+        float amp;
+        if (rect)
+            amp = snwaves[4][sn_stat[0] & 31] * vol;
+        else
+            amp = ((sn_shift & 1) ^ 1) * noise_amp;
+        for (int i = 0; i < run; i++)
+            buffer[d + i] += amp;
+        d += run;
+
+        sn_count[0] = (int)((unsigned)sn_count[0] - 128u * run);
+        while ((int)sn_count[0] < 0 && sn_latch[0]) {
+            sn_count[0] += (sn_latch[0] * 2);
+            if (!(sn_noise & 4)) {
+                if (sn_shift & 1)
+                    sn_shift |= 0x8000;
+                sn_shift >>= 1;
+            }
+            else {
+                if ((sn_shift & 1) ^ ((sn_shift >> 1) & 1))
+                    sn_shift |= 0x8000;
+                sn_shift >>= 1;
+            }
+            sn_stat[0]++;
+        }
+        if (!(sn_noise & 4)) {
+            while (sn_stat[0] >= 30)
+                sn_stat[0] -= 30;
+        }
+        else
+            sn_stat[0] &= 32767;
+    }
+}
+
+void sn_fillbuf(int16_t *buffer, int len)
+{
+    static int sidcount = 0;
+    uint8_t sdb_data;
+
+    if (sysvia_get_sn_data(&sdb_data))
+        sn_write(sdb_data);
+
+    while (len > 0) {
+        int seg = 2496 - sidcount;
+        if (seg > len)
+            seg = len;
+        for (int c = 1; c < 4; c++)
+            sn_tone(buffer, seg, c);
+        sn_noise_block(buffer, seg);
+        buffer += seg;
+        len -= seg;
+        sidcount += seg;
+        if (sidcount == 2496) {
+            sidcount = 0;
+            if (!sn_rect_dir) {
+                sn_rect_pos++;
+                if (sn_rect_pos == 30)
+                    sn_rect_dir = 1;
+            }
+            else {
+                sn_rect_pos--;
+                if (sn_rect_pos == 1)
+                    sn_rect_dir = 0;
+            }
+            sn_updaterectwave(sn_rect_pos);
         }
+    }
 }
 
 void sn_init()
@@ -0,0 +1,197 @@
+/*
+ * B-em SN76489 sound chip test.
+ *
+ * Drives sn_fillbuf through fixed sequences of register writes covering
+ * tones, periodic and white noise and volume changes, in blocks of odd
+ * sizes, for each of the wave shapes.  A hash of the samples from each
+ * sequence is compared with a reference file so changes to how samples
+ * are generated can be checked to give the same output.
+ *
+ * Usage: sntest [-w] <ref-file>
+ *
+ * With -w the reference file is written rather than checked.
+ */
+
+#include "b-em.h"
+#include <errno.h>
+
+#include "sn76489.h"
+#include "via.h"
+#include "sysvia.h"
+
+#define SN_MAX_RUN 8192
+
+static int16_t sn_buf[SN_MAX_RUN];
+static uint32_t sn_hash;
+static unsigned long sn_samples;
+
+/* The test writes to the chip directly rather than via the system VIA. */
+int sysvia_get_sn_data(uint8_t *data)
+{
+    return 0;
+}
+
+static void sn_run(int len)
+{
+    memset(sn_buf, 0, len * sizeof(int16_t));
+    sn_fillbuf(sn_buf, len);
+    for (int i = 0; i < len; i++) {
+        uint16_t s = sn_buf[i];
+        sn_hash = (sn_hash ^ (s & 0xff)) * 16777619u;
+        sn_hash = (sn_hash ^ (s >> 8)) * 16777619u;
+    }
+    sn_samples += len;
+}
+
+static void sn_writes(const uint8_t *data, size_t len)
+{
+    while (len--)
+        sn_write(*data++);
+}
+
+#define SN_WRITES(...) do { static const uint8_t d[] = { __VA_ARGS__ }; sn_writes(d, sizeof(d)); } while (0)
+
+/* Put the chip into a known state, all channels silent. */
+static bool sn_start(void)
+{
+    uint32_t words[12];
+    unsigned char bytes[7] = { 0, 0, 0, 0, 3, 0x00, 0x40 };
+    FILE *fp;
+
+    for (int c = 0; c < 4; c++) {
+        words[c] = 0x3FF << 6;  // latch
+        words[c + 4] = 0;       // count
+        words[c + 8] = 0;       // stat
+    }
+    if (!(fp = tmpfile())) {
+        fprintf(stderr, "sntest: unable to create temporary file: %s\n", strerror(errno));
+        return false;
+    }
+    fwrite(words, sizeof(words), 1, fp);
+    fwrite(bytes, sizeof(bytes), 1, fp);
+    rewind(fp);
+    sn_loadstate(fp);
+    fclose(fp);
+    return true;
+}
+
+static void sn_seq_tone(void)
+{
+    SN_WRITES(0x8E, 0x0F, 0x90,         // channel 3 low pitch, full volume.
+              0xA5, 0x01, 0xB4,         // channel 2 high pitch.
+              0xC1, 0x00, 0xD8);        // channel 1 above hearing, flat.
+    sn_run(3000);
+    sn_run(1);
+    sn_run(2496);
+    sn_run(700);
+    SN_WRITES(0x83, 0x20, 0xA0, 0x3F);  // new pitches part way through.
+    sn_run(5000);
+    sn_run(17);
+    SN_WRITES(0xC7, 0x08, 0xD0);
+    sn_run(8000);
+}
+
+static void sn_seq_periodic(void)
+{
+    SN_WRITES(0x9F, 0xBF, 0xDF, 0xE0, 0xF0);
+    sn_run(4000);
+    SN_WRITES(0xE1);
+    sn_run(3000);
+    SN_WRITES(0xE2);
+    sn_run(2000);
+    SN_WRITES(0xC6, 0x04, 0xE3);        // clocked by channel 1.
+    sn_run(6000);
+    SN_WRITES(0xCA, 0x11);              // channel 1 pitch change moves the noise.
+    sn_run(2500);
+}
+
+static void sn_seq_white(void)
+{
+    SN_WRITES(0x9F, 0xBF, 0xDF, 0xE4, 0xF2);
+    sn_run(4000);
+    SN_WRITES(0xE5);
+    sn_run(1234);
+    SN_WRITES(0xE6);
+    sn_run(2496);
+    SN_WRITES(0xC3, 0x02, 0xE7);
+    sn_run(5000);
+    SN_WRITES(0xE0, 0x04);              // data byte selects white noise.
+    sn_run(100);
+    sn_run(3333);
+}
+
+static void sn_seq_volume(void)
+{
+    SN_WRITES(0x8C, 0x06, 0xA2, 0x0B, 0xC9, 0x03, 0xE5);
+    for (int v = 0; v < 16; v++) {
+        sn_write(0x90 | v);
+        sn_write(0xB0 | (15 - v));
+        sn_write(0xD0 | ((v * 5) & 15));
+        sn_write(0xF0 | ((v * 3) & 15));
+        sn_run(333 + v * 61);
+    }
+}
+
+static const struct {
+    const char *name;
+    void (*seq)(void);
+} sn_seqs[] = {
+    { "tone",     sn_seq_tone     },
+    { "periodic", sn_seq_periodic },
+    { "white",    sn_seq_white    },
+    { "volume",   sn_seq_volume   }
+};
+
+int main(int argc, char **argv)
+{
+    bool write = false;
+    const char *fn;
+    FILE *fp;
+    int status = 0;
+
+    if (argc == 3 && !strcmp(argv[1], "-w"))
+        write = true;
+    else if (argc != 2) {
+        fputs("Usage: sntest [-w] <ref-file>\n", stderr);
+        return 1;
+    }
+    fn = argv[argc - 1];
+    if (!(fp = fopen(fn, write ? "w" : "r"))) {
+        fprintf(stderr, "sntest: unable to open %s: %s\n", fn, strerror(errno));
+        return 1;
+    }
+
+    sn_init();
+    for (curwave = 0; curwave < 5; curwave++) {
+        for (int i = 0; i < sizeof(sn_seqs) / sizeof(sn_seqs[0]); i++) {
+            if (!sn_start()) {
+                status = 1;
+                break;
+            }
+            sn_hash = 2166136261u;
+            sn_samples = 0;
+            sn_seqs[i].seq();
+            if (write)
+                fprintf(fp, "%s %d %lu %08X\n", sn_seqs[i].name, curwave, sn_samples, sn_hash);
+            else {
+                char name[16];
+                int wave;
+                unsigned long samples;
+                unsigned hash;
+                if (fscanf(fp, "%15s %d %lu %X", name, &wave, &samples, &hash) != 4) {
+                    fprintf(stderr, "sntest: %s: missing reference for %s, wave %d\n", fn, sn_seqs[i].name, curwave);
+                    status = 1;
+                }
+                else if (strcmp(name, sn_seqs[i].name) || wave != curwave || samples != sn_samples || hash != sn_hash) {
+                    fprintf(stderr, "sntest: %s, wave %d: got %lu samples hash %08X, expected %lu samples hash %08X\n",
+                            sn_seqs[i].name, curwave, sn_samples, sn_hash, samples, hash);
+                    status = 1;
+                }
+            }
+        }
+    }
+    fclose(fp);
+    if (!write && !status)
+        puts("sntest: OK");
+    return status;
+}
@@ -2,6 +2,8 @@
   Internal SN sound chip emulation*/
 
 #include "b-em.h"
+#include "main.h"
+#include "metrics.h"
 #include <allegro5/allegro_audio.h>
 #include "sid_b-em.h"
 #include "sn76489.h"
@@ -10,6 +12,7 @@
 #include "uservia.h"
 #include "music5000.h"
 #include "paula.h"
+#include "sched.h"
 
 bool sound_internal = false, sound_beebsid = false, sound_dac = false;
 bool sound_ddnoise = false, sound_tape = false;
@@ -25,7 +28,7 @@ static int sound_sn_pos = 0;
 
 static short sound_buffer[BUFLEN_SO];
 
-static int sound_sn76489_cycles = 0, sound_poll_cycles = 0;
+static int sound_sn76489_cycles = 0;
 
 #define NCoef 2
 static float iir(float NewSample) {
@@ -108,72 +111,121 @@ static void sound_rec_int(short *buf)
     }
 }
 
-static void sound_poll_all(void)
+/*
+ * Hand a complete fragment to the audio stream, converting to float
+ * in one pass over the buffer.
+ */
+
+static void sound_flush(void)
 {
     float *buf;
     int c;
 
-    if ((sound_internal || sound_beebsid) && stream) {
-        int16_t temp_buffer[2] = {0};
-
-        if (sound_beebsid)
-            sid_fillbuf(temp_buffer, 2);
-        if (sound_paula)
-            paula_fillbuf(temp_buffer, 2);
-        if (sound_dac) {
-            temp_buffer[0] += (((int)lpt_dac - 0x80) * 32);
-            temp_buffer[1] += (((int)lpt_dac - 0x80) * 32);
+    if ((buf = al_get_audio_stream_fragment(stream))) {
+        if (sound_filter) {
+            for (c = 0; c < BUFLEN_SO; c++)
+                buf[c] = iir((float)sound_buffer[c] / 32767.0);
+            sound_rec_float(buf);
+        } else {
+            const float scale = 1.0f / 32767.0f;
+            for (c = 0; c < BUFLEN_SO; c++)
+                buf[c] = sound_buffer[c] * scale;
+            sound_rec_int(sound_buffer);
         }
+        al_set_audio_stream_fragment(stream, buf);
+        al_set_audio_stream_playing(stream, true);
+    } else {
+        log_debug("sound: overrun");
+        metrics.sound_overruns++;
+    }
+    sound_pos = 0;
+    sound_sn_pos = 0;
+    memset(sound_buffer, 0, sizeof(sound_buffer));
+}
 
-        for (c = 0; c < 8/2; c++) {
-            sound_buffer[sound_pos + c] += temp_buffer[0];
-            sound_buffer[sound_pos + c + 4] += temp_buffer[1];
-        }
-        // skip forward 8 mono samples
-        sound_pos += 8;
-        if (sound_pos == BUFLEN_SO) {
-            if ((buf = al_get_audio_stream_fragment(stream))) {
-                if (sound_filter) {
-                    for (c = 0; c < BUFLEN_SO; c++)
-                        buf[c] = iir((float)sound_buffer[c] / 32767.0);
-                    sound_rec_float(buf);
-                } else {
-                    for (c = 0; c < BUFLEN_SO; c++)
-                        buf[c] = (float)sound_buffer[c] / 32767.0;
-                    sound_rec_int(sound_buffer);
+/*
+ * BeebSID, Paula and the printer port DAC run at a quarter of the
+ * SN76489 rate, two samples for each group of eight SN76489 samples,
+ * each spread over four positions.  Catch them up to the SN76489 a
+ * whole run of groups at a time.
+ */
+
+static void sound_mix_slow(void)
+{
+    static int16_t temp_buffer[BUFLEN_SO / 4];
+    int groups = ((sound_sn_pos + 7) >> 3) - (sound_pos >> 3);
+
+    if (groups > 0) {
+        if (sound_beebsid || sound_paula || sound_dac) {
+            int len = groups * 2;
+            int c, d;
+            short *dest;
+
+            memset(temp_buffer, 0, len * sizeof(int16_t));
+            if (sound_beebsid)
+                sid_fillbuf(temp_buffer, len);
+            if (sound_paula)
+                paula_fillbuf(temp_buffer, len);
+            if (sound_dac) {
+                int16_t dac = ((int)lpt_dac - 0x80) * 32;
+                for (c = 0; c < len; c++)
+                    temp_buffer[c] += dac;
+            }
+            dest = &sound_buffer[sound_pos];
+            for (c = 0; c < len; c += 2) {
+                for (d = 0; d < 4; d++) {
+                    dest[d] += temp_buffer[c];
+                    dest[d + 4] += temp_buffer[c + 1];
                 }
-                al_set_audio_stream_fragment(stream, buf);
-                al_set_audio_stream_playing(stream, true);
-            } else
-                log_debug("sound: overrun");
-            sound_pos = 0;
-            sound_sn_pos = 0;
-            memset(sound_buffer, 0, sizeof(sound_buffer));
+                dest += 8;
+            }
         }
+        sound_pos += groups * 8;
     }
 }
 
+/*
+ * Generate everything owed since the last call in one run per source,
+ * stopping only at the end of a fragment.
+ */
+
 void sound_poll(int cycles)
 {
-    sound_sn76489_cycles -= cycles;
-    if (sound_sn76489_cycles < 0)
-    {
-        sound_sn76489_cycles += 16;
-
-        if (sound_internal)
-            sn_fillbuf(&sound_buffer[sound_sn_pos], 1);
-
-        sound_sn_pos++;
-
-        sound_poll_cycles -= 16;
-        if (sound_poll_cycles < 0)
-        {
-            sound_poll_cycles += 128;
-            sound_poll_all();
+    int samples;
+
+    sound_sn76489_cycles += cycles;
+    samples = sound_sn76489_cycles >> 4;
+    sound_sn76489_cycles &= 15;
+
+    if ((sound_internal || sound_beebsid) && stream && !turbo) {
+        while (samples > 0) {
+            int len = BUFLEN_SO - sound_sn_pos;
+            if (len > samples)
+                len = samples;
+            if (sound_internal)
+                sn_fillbuf(&sound_buffer[sound_sn_pos], len);
+            sound_sn_pos += len;
+            samples -= len;
+            sound_mix_slow();
+            if (sound_pos == BUFLEN_SO)
+                sound_flush();
         }
     }
 }
 
+/*
+ * Nothing the sound chip does is visible to the CPU so it is left to
+ * catch up in batches, with the scheduler bringing it up to date
+ * before any I/O access that could change a register.
+ */
+
+static int sound_next(void)
+{
+    return SCHED_MAX_DELAY;
+}
+
+static const sched_client_t sound_client = { "sound", sound_poll, sound_next };
+
 static ALLEGRO_VOICE *sound_create_voice(void)
 {
     ALLEGRO_VOICE *voice;
@@ -207,6 +259,7 @@ static ALLEGRO_VOICE *sound_create_voice(void)
 
 void sound_init(void)
 {
+    sched_register(&sound_client);
     if ((voice = sound_create_voice())) {
         if ((mixer = al_create_mixer(FREQ_SO, ALLEGRO_AUDIO_DEPTH_FLOAT32, ALLEGRO_CHANNEL_CONF_1))) {
             if (al_attach_mixer_to_voice(mixer, voice)) {
@@ -9,6 +9,7 @@
 #include "led.h"
 #include "via.h"
 #include "sysvia.h"
+#include "sched.h"
 #include "sn76489.h"
 #include "video.h"
 
@@ -177,9 +178,22 @@ uint8_t sysvia_read(uint16_t addr)
         return temp;
 }
 
+static void sysvia_run(int cycles)
+{
+        via_poll(&sysvia, cycles);
+}
+
+static int sysvia_next(void)
+{
+        return via_next_event(&sysvia);
+}
+
+static const sched_client_t sysvia_client = { "sysvia", sysvia_run, sysvia_next };
+
 void sysvia_reset()
 {
         via_reset(&sysvia);
+        sched_register(&sysvia_client);
 
         sysvia.read_portA = sysvia_read_portA;
         sysvia.read_portB = sysvia_read_portB;
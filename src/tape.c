@@ -1,15 +1,18 @@
 #include "b-em.h"
 #include "led.h"
+#include "metrics.h"
 #include "tape.h"
 #include "serial.h"
 #include "tapenoise.h"
 #include "uef.h"
 #include "csw.h"
+#include "sysacia.h"
 
 int tapelcount,tapellatch,tapeledcount;
 
 bool tape_loaded = false;
 bool fasttape = false;
+bool tape_fastload = false;
 ALLEGRO_PATH *tape_fn = NULL;
 
 static struct
@@ -27,6 +30,58 @@ loaders[]=
 
 static int tape_loader;
 
+/* Acorn cassette filing system blocks.  Each block follows a carrier
+ * tone and starts with a '*' sync byte, the filename, a header and the
+ * header CRC, then the data and its CRC.  tape_blk_byte follows that
+ * structure through a stream of bytes; it is used both to build the
+ * catalogue and, when fast loading, to find the data part of the block
+ * currently being read. */
+
+typedef struct {
+    enum { BLK_SYNC, BLK_NAME, BLK_HEADER, BLK_SKIP } state;
+    int     pos, skip, blklen;
+    char    name[11];
+    uint8_t hdr[13];
+} tape_blk_t;
+
+static bool tape_blk_byte(tape_blk_t *blk, uint8_t val, bool after_tone)
+{
+    switch(blk->state) {
+        case BLK_SYNC:
+            if (val == 0x2A && after_tone) {
+                blk->state = BLK_NAME;
+                blk->pos = 0;
+            }
+            break;
+        case BLK_NAME:
+            if (val && blk->pos < 10)
+                blk->name[blk->pos++] = val;
+            else {
+                blk->name[blk->pos] = 0;
+                blk->state = BLK_HEADER;
+                blk->pos = 0;
+            }
+            break;
+        case BLK_HEADER:
+            blk->hdr[blk->pos++] = val;
+            if (blk->pos == sizeof(blk->hdr)) {
+                blk->blklen = blk->hdr[10] | (blk->hdr[11] << 8);
+                /* spare bytes and header CRC, the data and its CRC */
+                blk->skip = blk->blklen + 8;
+                blk->state = BLK_SKIP;
+                return true;
+            }
+            break;
+        case BLK_SKIP:
+            if (--blk->skip <= 0)
+                blk->state = BLK_SYNC;
+            break;
+    }
+    return false;
+}
+
+static tape_blk_t load_blk;
+
 void tape_load(ALLEGRO_PATH *fn)
 {
         int c = 0;
@@ -39,6 +94,7 @@ void tape_load(ALLEGRO_PATH *fn)
             p++;
         cpath = al_path_cstr(fn, ALLEGRO_NATIVE_PATH_SEP);
         log_info("tape: Loading %s %s", cpath, p);
+        load_blk.state = BLK_SYNC;
         while (loaders[c].ext)
         {
                 if (!strcasecmp(p, loaders[c].ext))
@@ -57,6 +113,71 @@ void tape_close()
         if (tape_loaded && tape_loader < 2)
            loaders[tape_loader].close();
         tape_loaded = 0;
+        tape_cat_reset();
+}
+
+/* Tape catalogue.  Each loader decodes the whole tape once when it is
+ * loaded and feeds the byte stream through tape_cat_byte so the file
+ * list is ready without winding through the tape again. */
+
+typedef struct {
+    char     name[11];
+    uint32_t load, run, size;
+} tape_file_t;
+
+static tape_file_t *cat_files;
+static int cat_count, cat_alloc;
+static tape_blk_t cat_blk;
+static uint32_t cat_size;
+
+void tape_cat_reset(void)
+{
+    if (cat_files) {
+        free(cat_files);
+        cat_files = NULL;
+    }
+    cat_count = cat_alloc = 0;
+    cat_blk.state = BLK_SYNC;
+    cat_size = 0;
+}
+
+void tape_cat_byte(uint8_t val, bool after_tone)
+{
+    tape_file_t *file;
+    uint8_t *hdr = cat_blk.hdr;
+
+    if (!tape_blk_byte(&cat_blk, val, after_tone))
+        return;
+    cat_size += cat_blk.blklen;
+    if (hdr[12] & 0x80) { /* last block of the file */
+        if (cat_count == cat_alloc) {
+            int nalloc = cat_alloc ? cat_alloc * 2 : 64;
+            tape_file_t *nfiles = realloc(cat_files, nalloc * sizeof(tape_file_t));
+            if (!nfiles) {
+                log_error("tape: out of memory building catalogue");
+                return;
+            }
+            cat_files = nfiles;
+            cat_alloc = nalloc;
+        }
+        file = cat_files + cat_count++;
+        memcpy(file->name, cat_blk.name, sizeof(file->name));
+        file->load = hdr[0] | (hdr[1] << 8) | (hdr[2] << 16) | ((uint32_t)hdr[3] << 24);
+        file->run  = hdr[4] | (hdr[5] << 8) | (hdr[6] << 16) | ((uint32_t)hdr[7] << 24);
+        file->size = cat_size;
+        cat_size = 0;
+    }
+}
+
+void tape_findfilenames(void)
+{
+    char s[64];
+
+    for (int i = 0; i < cat_count; i++) {
+        tape_file_t *file = cat_files + i;
+        sprintf(s, "%-13s Size %04X Load %08X Run %08X", file->name, file->size, file->load, file->run);
+        cataddname(s);
+    }
 }
 
 /*Every 128 clocks, ie 15.625khz*/
@@ -64,8 +185,39 @@ void tape_close()
 
 static uint16_t newdat;
 
+static inline bool tape_in_data(void)
+{
+    return load_blk.state == BLK_SKIP && load_blk.skip <= load_blk.blklen + 1;
+}
+
+/* With fast loading, carrier tone and the data part of each CFS block
+ * are played back as fast as the OS will take them.  The OS interrupt
+ * handler deals with the data bytes itself but passes the filename and
+ * header to foreground code one byte at a time, and sets up for the
+ * data only once the header is complete, so those parts are slowed
+ * down less.  Anything that does not look like a CFS block is played
+ * at the normal rate.  Every byte still goes through the OS, there is
+ * no trap to hand it whole blocks, and tape noise, if on, is generated
+ * for each byte as usual. */
+
+int tape_fastload_latch(void)
+{
+    if (tape_in_data())
+        return 1;
+    if (load_blk.state == BLK_SKIP && load_blk.skip == load_blk.blklen + 2)
+        return tapellatch; /* first data byte */
+    if (load_blk.state != BLK_SYNC)
+        return tapellatch / 2;
+    if (csw_ena ? csw_toneon > 1 : uef_toneon > 1)
+        return tapellatch / 32 + 1;
+    return tapellatch;
+}
+
 void tape_poll(void) {
     if (motor) {
+        if (tape_fastload && tape_in_data() && acia_rx_full(&sysacia))
+            return; /* wait for the OS to take the last byte */
+
         if (csw_ena) csw_poll();
         else         uef_poll();
 
@@ -80,4 +232,49 @@ void tape_poll(void) {
 
 void tape_receive(ACIA *acia, uint8_t data) {
     newdat = data | 0x100;
+    metrics.tape_bytes++;
+    bool after_tone = (csw_ena ? csw_toneon : uef_toneon) == 1;
+    if (after_tone)
+        load_blk.state = BLK_SYNC;
+    tape_blk_byte(&load_blk, data, after_tone);
+}
+
+/* Save and restore how far a tape has played so it can be closed and
+ * loaded again later without winding back to the start.  The position
+ * only makes sense to the same image in the same process. */
+
+void tape_savepos(FILE *f)
+{
+    putc(tape_loaded ? tape_loader : -1, f);
+    if (tape_loaded) {
+        fwrite(&load_blk, sizeof(load_blk), 1, f);
+        fwrite(&newdat, sizeof(newdat), 1, f);
+        fwrite(&tapelcount, sizeof(tapelcount), 1, f);
+        putc(motor, f);
+        if (csw_ena)
+            csw_savepos(f);
+        else
+            uef_savepos(f);
+    }
+}
+
+void tape_loadpos(FILE *f)
+{
+    int loader = (signed char)getc(f);
+
+    if (loader >= 0) {
+        if (!tape_loaded || loader != tape_loader) {
+            log_warn("tape: tape changed, position not restored");
+            return;
+        }
+        if (fread(&load_blk, sizeof(load_blk), 1, f) != 1
+            || fread(&newdat, sizeof(newdat), 1, f) != 1
+            || fread(&tapelcount, sizeof(tapelcount), 1, f) != 1)
+            return;
+        motor = getc(f);  // off if the tape was not loaded when the ULA was restored.
+        if (csw_ena)
+            csw_loadpos(f);
+        else
+            uef_loadpos(f);
+    }
 }
@@ -8,10 +8,18 @@ extern bool tape_loaded;
 
 void tape_load(ALLEGRO_PATH *fn);
 void tape_close(void);
+void tape_savepos(FILE *f);
+void tape_loadpos(FILE *f);
 void tape_poll(void);
 void tape_receive(ACIA *acia, uint8_t data);
+int tape_fastload_latch(void);
+
+void tape_cat_reset(void);
+void tape_cat_byte(uint8_t val, bool after_tone);
+void tape_findfilenames(void);
 
 extern int tapelcount,tapellatch,tapeledcount;
 extern bool fasttape;
+extern bool tape_fastload;  // play CFS blocks back faster than real time.
 
 #endif
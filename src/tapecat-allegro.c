@@ -1,8 +1,7 @@
 #include "b-em.h"
 #include <allegro5/allegro_native_dialog.h>
 #include "tapecat-allegro.h"
-#include "csw.h"
-#include "uef.h"
+#include "tape.h"
 
 static ALLEGRO_TEXTLOG *textlog;
 ALLEGRO_EVENT_SOURCE uevsrc;
@@ -35,10 +34,7 @@ static void *tapecat_thread(ALLEGRO_THREAD *thread, void *tdata)
 
 static void start_cat(void)
 {
-    if (csw_ena)
-        csw_findfilenames();
-    else
-        uef_findfilenames();
+    tape_findfilenames();
 }
 
 void gui_tapecat_start(void)
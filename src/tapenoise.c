@@ -4,6 +4,7 @@
 #include "b-em.h"
 #include <math.h>
 #include "ddnoise.h"
+#include "main.h"
 #include "tapenoise.h"
 #include "sound.h"
 
@@ -96,7 +97,7 @@ static void add_high(void)
 
 void tapenoise_addhigh(void)
 {
-    if (sound_tape)
+    if (sound_tape && !turbo)
         add_high();
 }
 
@@ -143,7 +144,7 @@ static void add_dat(uint8_t dat)
 
 void tapenoise_adddat(uint8_t dat)
 {
-    if (sound_tape)
+    if (sound_tape && !turbo)
         add_dat(dat);
 }
 
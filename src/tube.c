@@ -4,6 +4,7 @@
 #include <stdio.h>
 #include "b-em.h"
 #include "6502.h"
+#include "metrics.h"
 #include "model.h"
 #include "tube.h"
 
@@ -56,6 +57,35 @@ int tube_irq=0;
 tubetype tube_type=TUBEX86;
 tube_ula tubeula;
 
+/*
+ * Running the parasite on its own thread.
+ *
+ * The host hands the parasite cycles to run in batches.  The parasite
+ * thread runs them while the host carries on, so the parasite is always
+ * behind the host, but never by more than TUBE_MAX_SKEW host cycles,
+ * after which the host waits.  Before the host touches the tube ULA, or
+ * anything else belonging to the parasite, it gives it any cycles still
+ * owed and waits for it to use them up and go idle, so register accesses
+ * by the host see the parasite at the same point as when it is run inline
+ * and the parasite may only touch the ULA while the host is not.
+ *
+ * The one thing the parasite changes that belongs to the host is the
+ * host interrupt from register 4.  That is passed back through
+ * tube_host_irq and picked up at the next hand-over.
+ */
+
+#define TUBE_MAX_SKEW 1024
+
+bool tube_use_thread;  // as configured.
+bool tube_no_thread;   // running inline anyway as the thread can't help.
+
+static ALLEGRO_THREAD *tube_thread;
+static ALLEGRO_MUTEX *tube_mutex;
+static ALLEGRO_COND *tube_cond;
+static int tube_credit;          // parasite cycles given but not yet started.
+static bool tube_busy;           // parasite thread is running tube_exec.
+static int tube_host_irq = -1;   // host IRQ from the parasite, -1 if no change.
+
 static void tube_reset_most(void)
 {
     tubeula.ph1count = tubeula.ph1head = tubeula.ph1tail = 0;
@@ -76,11 +106,17 @@ void tube_reset(void)
 void tube_updateints()
 {
     int new_irq = 0;
-
-    interrupt &= ~8;
+    int host_irq = 0;
 
     if ((tubeula.r1stat & TUBE_STAT_Q) && (tubeula.hstat[3] & TUBE_DATA_AVAIL))
-        interrupt |= 8;
+        host_irq = 8;
+    if (tube_busy) {
+        al_lock_mutex(tube_mutex);
+        tube_host_irq = host_irq;
+        al_unlock_mutex(tube_mutex);
+    }
+    else
+        interrupt = (interrupt & ~8) | host_irq;
 
     if (((tubeula.r1stat & TUBE_STAT_I) && (tubeula.pstat[0] & TUBE_DATA_AVAIL)) || ((tubeula.r1stat & TUBE_STAT_J) && (tubeula.pstat[3] & TUBE_DATA_AVAIL))) {
         new_irq |= 1;
@@ -131,6 +167,8 @@ uint8_t tube_host_read(uint16_t addr)
 {
         uint8_t temp = 0;
         if (!tube_exec) return 0xFE;
+        if (tube_thread)
+            tube_thread_sync();
         switch (addr & 7)
         {
             case 0: /*Reg 1 Stat*/
@@ -196,6 +234,8 @@ uint8_t tube_host_read(uint16_t addr)
 void tube_host_write(uint16_t addr, uint8_t val)
 {
         if (!tube_exec) return;
+        if (tube_thread)
+            tube_thread_sync();
         tubeula.hpl = val;
 
         switch (addr & 7)
@@ -353,6 +393,132 @@ void tube_parasite_write(uint32_t addr, uint8_t val)
         tube_updateints();
 }
 
+static void *tube_thread_proc(ALLEGRO_THREAD *thread, void *data)
+{
+    al_lock_mutex(tube_mutex);
+    while (!al_get_thread_should_stop(thread)) {
+        if (tube_credit <= 3 || !tube_exec) {
+            al_wait_cond(tube_cond, tube_mutex);
+            continue;
+        }
+        tubecycles += tube_credit;
+        tube_credit = 0;
+        tube_busy = true;
+        al_unlock_mutex(tube_mutex);
+        tube_exec();
+        al_lock_mutex(tube_mutex);
+        tube_busy = false;
+        al_broadcast_cond(tube_cond);
+    }
+    al_unlock_mutex(tube_mutex);
+    return NULL;
+}
+
+static bool tube_thread_start(void)
+{
+    if (!tube_mutex && !(tube_mutex = al_create_mutex()))
+        return false;
+    if (!tube_cond && !(tube_cond = al_create_cond()))
+        return false;
+    tube_credit = 0;
+    tube_busy = false;
+    tube_host_irq = -1;
+    if (!(tube_thread = al_create_thread(tube_thread_proc, NULL)))
+        return false;
+    al_start_thread(tube_thread);
+    log_debug("tube: parasite thread started");
+    return true;
+}
+
+/* Pick up a change to the host interrupt made by the parasite. */
+static void tube_thread_irq(void)
+{
+    if (tube_host_irq >= 0) {
+        interrupt = (interrupt & ~8) | tube_host_irq;
+        tube_host_irq = -1;
+    }
+}
+
+/*
+ * Give the parasite the cycles corresponding to a number of host cycles,
+ * starting the thread if need be.  Falls back to running the parasite
+ * inline if the thread can't be used or there is only one CPU, where the
+ * hand-overs cost more than the thread saves.
+ */
+
+void tube_thread_run(int host_cycles)
+{
+    int cycles = (host_cycles * tube_multipler) >> 1;
+
+    metrics.tube_cycles += cycles;
+    if (debug_tube)
+        tube_thread_stop();
+    else if (!tube_thread && al_get_cpu_count() < 2) {
+        log_info("tube: only one CPU, running the parasite inline");
+        tube_no_thread = true;
+    }
+    else if (!tube_thread && !tube_thread_start()) {
+        log_warn("tube: unable to start parasite thread, running inline");
+        tube_no_thread = true;
+    }
+    if (!tube_thread) {
+        tubecycles += cycles;
+        if (tubecycles > 3)
+            tube_exec();
+        return;
+    }
+    al_lock_mutex(tube_mutex);
+    tube_credit += cycles;
+    al_broadcast_cond(tube_cond);
+    while (tube_credit > (TUBE_MAX_SKEW * tube_multipler) >> 1 && tube_exec)
+        al_wait_cond(tube_cond, tube_mutex);
+    tube_thread_irq();
+    al_unlock_mutex(tube_mutex);
+}
+
+/*
+ * Bring the parasite up to the same time as the host and wait for it to
+ * go idle so the host may touch its state.
+ */
+
+void tube_thread_sync(void)
+{
+    if (tube_thread) {
+        al_lock_mutex(tube_mutex);
+        if (tubecycle) {
+            tube_credit += (tubecycle * tube_multipler) >> 1;
+            tubecycle = 0;
+            al_broadcast_cond(tube_cond);
+        }
+        while (tube_busy || (tube_credit > 3 && tube_exec))
+            al_wait_cond(tube_cond, tube_mutex);
+        tube_thread_irq();
+        al_unlock_mutex(tube_mutex);
+    }
+}
+
+/*
+ * Stop the parasite thread, e.g. before a reset, a change of model or
+ * the parasite being debugged; it starts again when next needed.
+ */
+
+void tube_thread_stop(void)
+{
+    if (tube_thread) {
+        tube_thread_sync();
+        al_set_thread_should_stop(tube_thread);
+        al_lock_mutex(tube_mutex);
+        al_broadcast_cond(tube_cond);
+        al_unlock_mutex(tube_mutex);
+        al_join_thread(tube_thread, NULL);
+        al_destroy_thread(tube_thread);
+        tube_thread = NULL;
+        tubecycles += tube_credit;
+        tube_credit = 0;
+        log_debug("tube: parasite thread stopped");
+    }
+}
+
 void tube_updatespeed()
 {
     tube_multipler = tube_speeds[tube_speed_num].multipler * tubes[curtube].speed_multiplier;
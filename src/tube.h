@@ -62,6 +62,7 @@ extern void (*tube_proc_savestate)(ZFILE *zfp);
 extern void (*tube_proc_loadstate)(ZFILE *zfp);
 
 extern int tubecycles;
+extern int tubecycle;  // host cycles not yet passed on to the parasite.
 static inline void tubeUseCycles(int c) {tubecycles -= c;}
 static inline int tubeContinueRunning(void) {return tubecycles > 0;}
 
@@ -75,6 +76,14 @@ extern int tube_irq;
 void tube_reset(void);
 void tube_updatespeed(void);
 
+#define TUBE_THREAD_BATCH 256  // host cycles handed to the parasite at once.
+
+extern bool tube_use_thread, tube_no_thread;
+
+void tube_thread_run(int host_cycles);
+void tube_thread_sync(void);
+void tube_thread_stop(void);
+
 void tube_ula_savestate(FILE *f);
 void tube_ula_loadstate(FILE *f);
 
@@ -10,87 +10,249 @@
 #include "tape.h"
 
 int pps;
-gzFile uef_f = NULL;
 
 int uef_toneon = 0;
 
+/* The whole image is inflated into memory when it is loaded and the
+ * chunks indexed so polling is a walk along an array. */
+
+typedef struct {
+    uint32_t offset;    /* of the chunk body within uef_data */
+    uint32_t len;
+    uint16_t id;
+} uef_chunk_t;
+
+static uint8_t     *uef_data;
+static uef_chunk_t *uef_chunks;
+static int          uef_nchunks, uef_curchunk;
+static uint32_t     uef_pos, uef_end;
+
 static int uef_inchunk = 0, uef_chunkid = 0, uef_chunklen = 0;
 static int uef_chunkpos = 0, uef_chunkdatabits = 8;
 static int uef_startchunk;
 static float uef_chunkf;
 static int uef_intone = 0;
 
+static inline int uef_getc(void)
+{
+    if (uef_pos < uef_end)
+        return uef_data[uef_pos++];
+    return 0;
+}
+
+static uint8_t *uef_inflate(const char *fn, uint32_t *size_ret)
+{
+    gzFile f;
+    uint8_t *data = NULL, *ndata;
+    uint32_t size = 0, alloc = 0;
+    int got, errnum;
+
+    if (!(f = gzopen(fn, "rb"))) {
+        log_warn("uef: unable to open UEF file '%s': %s", fn, strerror(errno));
+        return NULL;
+    }
+    do {
+        if (size == alloc) {
+            alloc = alloc ? alloc * 2 : 65536;
+            if (!(ndata = realloc(data, alloc))) {
+                log_error("uef: out of memory reading '%s'", fn);
+                free(data);
+                gzclose(f);
+                return NULL;
+            }
+            data = ndata;
+        }
+        if ((got = gzread(f, data + size, alloc - size)) > 0)
+            size += got;
+    } while (got > 0);
+    if (got < 0) {
+        log_error("uef: read error on '%s': %s", fn, gzerror(f, &errnum));
+        free(data);
+        data = NULL;
+    }
+    gzclose(f);
+    *size_ret = size;
+    return data;
+}
+
+static bool uef_index(uint32_t size)
+{
+    uint32_t pos = 12, len;
+    int alloc = 0;
+    uef_chunk_t *nchunks;
+
+    while (pos + 6 <= size) {
+        if (uef_nchunks == alloc) {
+            alloc = alloc ? alloc * 2 : 256;
+            if (!(nchunks = realloc(uef_chunks, alloc * sizeof(uef_chunk_t))))
+                return false;
+            uef_chunks = nchunks;
+        }
+        len = uef_data[pos+2] | (uef_data[pos+3] << 8) | (uef_data[pos+4] << 16) | ((uint32_t)uef_data[pos+5] << 24);
+        uef_chunks[uef_nchunks].id = uef_data[pos] | (uef_data[pos+1] << 8);
+        pos += 6;
+        if (len > size - pos)
+            len = size - pos;
+        uef_chunks[uef_nchunks].offset = pos;
+        uef_chunks[uef_nchunks++].len = len;
+        pos += len;
+    }
+    return true;
+}
+
+/* Pass the data bytes of the whole tape to the catalogue, tracking
+ * carrier tone the same way uef_poll does. */
+
+static void uef_catalogue(void)
+{
+    int toneon = 0, c;
+    uint32_t len;
+    uint8_t *p, mask;
+
+    tape_cat_reset();
+    for (c = 0; c < uef_nchunks; c++) {
+        p = uef_data + uef_chunks[c].offset;
+        len = uef_chunks[c].len;
+        mask = 0xFF;
+        switch (uef_chunks[c].id) {
+            case 0x104: /*Defined data*/
+                if (len < 3)
+                    break;
+                if (p[0] == 7)
+                    mask = 0x7F;
+                p += 3;
+                len -= 3;
+                /* FALLTHROUGH */
+            case 0x100: /*Raw data*/
+                while (len--)
+                    tape_cat_byte(*p++ & mask, --toneon == 1);
+                break;
+            case 0x110: /*High tone*/
+                toneon = 2;
+                break;
+            case 0x111: /*High tone with dummy byte*/
+                tape_cat_byte(0xAA, true);
+                toneon = 2;
+                break;
+            case 0x112: /*Gap*/
+            case 0x116: /*Float gap*/
+                toneon = 0;
+                break;
+        }
+    }
+}
+
 void uef_load(const char *fn)
 {
-        int c;
+        uint32_t size;
 //      printf("OpenUEF %s %08X\n",fn,uef);
-        if (uef_f)
-           gzclose(uef_f);
-        uef_f = gzopen(fn, "rb");
-        if (!uef_f) { /*printf("Fail!\n");*/ return; }
-        for (c = 0; c < 12; c++)
-            gzgetc(uef_f);
+        uef_close();
+        if (!(uef_data = uef_inflate(fn, &size)))
+            return;
+        if (size < 12 || memcmp(uef_data, "UEF File!", 10)) {
+            log_warn("uef: '%s' is not a UEF file", fn);
+            uef_close();
+            return;
+        }
+        if (!uef_index(size)) {
+            log_error("uef: out of memory reading '%s'", fn);
+            uef_close();
+            return;
+        }
+        uef_catalogue();
+        uef_curchunk = 0;
         uef_inchunk = uef_chunklen = uef_chunkid = 0;
+        uef_intone = uef_toneon = 0;
         tapellatch = (1000000 / (1200 / 10)) / 64;
         tapelcount = 0;
         pps = 120;
         csw_ena = 0;
 //      printf("Tapellatch %i\n",tapellatch);
         tape_loaded = 1;
-//      gzseek(uef,27535,SEEK_SET);
 }
 
 void uef_close()
 {
 //printf("CloseUEF\n");
-        if (uef_f)
+        if (uef_data)
+        {
+                free(uef_data);
+                uef_data = NULL;
+        }
+        if (uef_chunks)
         {
-                gzclose(uef_f);
-                uef_f = NULL;
+                free(uef_chunks);
+                uef_chunks = NULL;
         }
+        uef_nchunks = 0;
+}
+
+/* Where playback has got to, for putting a tape back where it was
+ * after it has been closed and loaded again. */
+
+typedef struct {
+    int      curchunk, inchunk, chunkid, chunklen, chunkpos, chunkdatabits;
+    int      startchunk, intone, toneon, pps, latch;
+    uint32_t pos, end;
+    float    chunkf;
+} uef_pos_t;
+
+void uef_savepos(FILE *f)
+{
+    uef_pos_t up = {
+        uef_curchunk, uef_inchunk, uef_chunkid, uef_chunklen, uef_chunkpos,
+        uef_chunkdatabits, uef_startchunk, uef_intone, uef_toneon, pps,
+        tapellatch, uef_pos, uef_end, uef_chunkf
+    };
+    fwrite(&up, sizeof(up), 1, f);
+}
+
+void uef_loadpos(FILE *f)
+{
+    uef_pos_t up;
+
+    if (fread(&up, sizeof(up), 1, f) == 1 && up.curchunk <= uef_nchunks) {
+        uef_curchunk = up.curchunk;
+        uef_inchunk = up.inchunk;
+        uef_chunkid = up.chunkid;
+        uef_chunklen = up.chunklen;
+        uef_chunkpos = up.chunkpos;
+        uef_chunkdatabits = up.chunkdatabits;
+        uef_startchunk = up.startchunk;
+        uef_intone = up.intone;
+        uef_toneon = up.toneon;
+        pps = up.pps;
+        tapellatch = up.latch;
+        uef_pos = up.pos;
+        uef_end = up.end;
+        uef_chunkf = up.chunkf;
+    }
 }
 
-static int infilenames = 0;
-static int uefloop = 0;
-static uint8_t fdat;
-int ffound;
 static void uef_receive(uint8_t val)
 {
         uef_toneon--;
-        if (infilenames)
-        {
-                ffound = 1;
-                fdat = val;
-//                log_debug("Dat %02X %c\n",val,(val<33)?'.':val);
-        }
-        else
-        {
-                acia_receive(&sysacia, val);
-//                log_debug("Dat %02X\n",val);
-        }
+        acia_receive(&sysacia, val);
+//        log_debug("Dat %02X\n",val);
 }
 
 void uef_poll()
 {
-        int c;
         uint32_t templ;
         float *tempf;
         uint8_t temp;
-        if (!uef_f)
+        if (!uef_nchunks)
            return;
         if (!uef_inchunk)
         {
                 uef_startchunk = 1;
-//                printf("%i ",gztell(uef));
-                gzread(uef_f, &uef_chunkid, 2);
-                gzread(uef_f, &uef_chunklen, 4);
-                if (gzeof(uef_f))
-                {
-                        gzseek(uef_f, 12, SEEK_SET);
-                        gzread(uef_f, &uef_chunkid, 2);
-                        gzread(uef_f, &uef_chunklen, 4);
-                        uefloop = 1;
-                }
+                if (uef_curchunk >= uef_nchunks)
+                    uef_curchunk = 0;
+                uef_chunkid  = uef_chunks[uef_curchunk].id;
+                uef_chunklen = uef_chunks[uef_curchunk].len;
+                uef_pos      = uef_chunks[uef_curchunk].offset;
+                uef_end      = uef_pos + uef_chunklen;
+                uef_curchunk++;
                 uef_inchunk = 1;
                 uef_chunkpos = 0;
 //                printf("Chunk ID %04X len %i\n",uef_chunkid,uef_chunklen);
@@ -99,18 +261,6 @@ void uef_poll()
 //           printf("Chunk %04X\n",uef_chunkid);
         switch (uef_chunkid)
         {
-            case 0x000: /*Origin*/
-                for (c = 0; c < uef_chunklen; c++)
-                    gzgetc(uef_f);
-                uef_inchunk = 0;
-                return;
-
-            case 0x005: /*Target platform*/
-                for (c = 0; c < uef_chunklen; c++)
-                    gzgetc(uef_f);
-                uef_inchunk = 0;
-                return;
-
             case 0x100: /*Raw data*/
                 if (uef_startchunk)
                 {
@@ -118,19 +268,19 @@ void uef_poll()
                         uef_startchunk = 0;
                 }
                 uef_chunklen--;
-                if (!uef_chunklen)
+                if (uef_chunklen <= 0)
                 {
                         uef_inchunk = 0;
                 }
-                uef_receive(gzgetc(uef_f));
+                uef_receive(uef_getc());
                 return;
 
             case 0x104: /*Defined data*/
                 if (!uef_chunkpos)
                 {
-                        uef_chunkdatabits = gzgetc(uef_f);
-                        gzgetc(uef_f);
-                        gzgetc(uef_f);
+                        uef_chunkdatabits = uef_getc();
+                        uef_getc();
+                        uef_getc();
                         uef_chunklen -= 3;
                         uef_chunkpos = 1;
                         acia_dcdlow(&sysacia);
@@ -140,7 +290,7 @@ void uef_poll()
                         uef_chunklen--;
                         if (uef_chunklen <= 0)
                            uef_inchunk = 0;
-                        temp = gzgetc(uef_f);
+                        temp = uef_getc();
 //                        printf("%i : %i %02X\n",gztell(uef),uef_chunklen,temp);
                         if (uef_chunkdatabits == 7) uef_receive(temp & 0x7F);
                         else                        uef_receive(temp);
@@ -152,8 +302,8 @@ void uef_poll()
                 if (!uef_intone)
                 {
                         acia_dcdhigh(&sysacia);
-                        uef_intone = gzgetc(uef_f);
-                        uef_intone |= (gzgetc(uef_f) << 8);
+                        uef_intone = uef_getc();
+                        uef_intone |= (uef_getc() << 8);
                         uef_intone /= 20;
                         if (!uef_intone) uef_intone = 1;
 //                        printf("uef_intone %i\n",uef_intone);
@@ -173,8 +323,8 @@ void uef_poll()
                 if (!uef_intone)
                 {
                         acia_dcdhigh(&sysacia);
-                        uef_intone = gzgetc(uef_f);
-                        uef_intone |= (gzgetc(uef_f)<<8);
+                        uef_intone = uef_getc();
+                        uef_intone |= (uef_getc()<<8);
                         uef_intone /= 20;
                         if (!uef_intone) uef_intone = 1;
                 }
@@ -188,8 +338,8 @@ void uef_poll()
                         else if (!uef_intone)
                         {
                                 uef_inchunk = 2;
-                                uef_intone = gzgetc(uef_f);
-                                uef_intone |= (gzgetc(uef_f) << 8);
+                                uef_intone = uef_getc();
+                                uef_intone |= (uef_getc() << 8);
                                 uef_intone /= 20;
                                 if (!uef_intone) uef_intone = 1;
                                 uef_receive(0xAA);
@@ -202,8 +352,8 @@ void uef_poll()
                 if (!uef_intone)
                 {
 //                        acia_dcdhigh(&sysacia);
-                        uef_intone = gzgetc(uef_f);
-                        uef_intone |= (gzgetc(uef_f) << 8);
+                        uef_intone = uef_getc();
+                        uef_intone |= (uef_getc() << 8);
                         uef_intone /= 20;
 //                        printf("gap uef_intone %i\n",uef_intone);
                         if (!uef_intone) uef_intone = 1;
@@ -219,10 +369,10 @@ void uef_poll()
                 return;
 
             case 0x113: /*Float baud rate*/
-                templ = gzgetc(uef_f);
-                templ |= (gzgetc(uef_f) << 8);
-                templ |= (gzgetc(uef_f) << 16);
-                templ |= (gzgetc(uef_f) << 24);
+                templ = uef_getc();
+                templ |= (uef_getc() << 8);
+                templ |= (uef_getc() << 16);
+                templ |= (uef_getc() << 24);
                 tempf = (float *)&templ;
                 tapellatch = (1000000 / ((*tempf) / 10)) / 64;
                 pps = (*tempf) / 10;
@@ -233,10 +383,10 @@ void uef_poll()
                 uef_toneon = 0;
                 if (!uef_chunkpos)
                 {
-                        templ = gzgetc(uef_f);
-                        templ |= (gzgetc(uef_f) << 8);
-                        templ |= (gzgetc(uef_f) << 16);
-                        templ |= (gzgetc(uef_f) << 24);
+                        templ = uef_getc();
+                        templ |= (uef_getc() << 8);
+                        templ |= (uef_getc() << 16);
+                        templ |= (uef_getc() << 24);
                         tempf = (float *)&templ;
                         uef_chunkf = *tempf;
                         //printf("Gap %f %i\n",uef_chunkf,pps);
@@ -251,17 +401,12 @@ void uef_poll()
                 }
                 return;
 
+            case 0x000: /*Origin*/
+            case 0x005: /*Target platform*/
             case 0x114: /*Security waves*/
             case 0x115: /*Polarity change*/
-//                default:
-                for (c = 0; c < uef_chunklen; c++)
-                    gzgetc(uef_f);
-                uef_inchunk = 0;
-                return;
-
             default:
-                for (c = 0; c < uef_chunklen; c++)
-                    gzgetc(uef_f);
+                /* The next chunk is found from the index. */
                 uef_inchunk = 0;
                 return;
 //116 : float gap
@@ -272,127 +417,3 @@ void uef_poll()
 //        printf("Bad chunk ID %04X length %i\n",uef_chunkid,uef_chunklen);
 //        exit(-1);
 }
-
-uint8_t fbuffer[4];
-
-#define getuefbyte()            ffound = 0; \
-                                while (!ffound && !uefloop) \
-                                { \
-                                        uef_poll(); \
-                                } \
-                                if (uefloop) break;
-
-uint8_t ffilename[16];
-void uef_findfilenames()
-{
-        int temp;
-        uint8_t tb;
-        int c;
-        int fsize = 0;
-        char s[256];
-        uint32_t run, load;
-        uint8_t status;
-        int skip;
-        int binchunk  = uef_inchunk,  bchunkid = uef_chunkid, bchunklen = uef_chunklen;
-        int bchunkpos = uef_chunkpos, bchunkdatabits = uef_chunkdatabits;
-        int bintone   = uef_intone,   bffound = ffound;
-        float bchunkf = uef_chunkf;
-        uint8_t bdat  = fdat;
-        if (!uef_f) return;
-
-        uef_inchunk  = 0; uef_chunkid = 0; uef_chunklen = 0;
-        uef_chunkpos = 0; uef_chunkdatabits = 8; uef_intone = 0;
-        uef_chunkf   = 0;
-
-        temp=gztell(uef_f);
-        gzseek(uef_f, 12, SEEK_SET);
-        uefloop = 0;
-        infilenames = 1;
-        while (!uefloop)
-        {
-                ffound = 0;
-                while (!ffound && !uefloop)
-                {
-                        uef_poll();
-                }
-                if (uefloop) break;
-                fbuffer[0] = fbuffer[1];
-                fbuffer[1] = fbuffer[2];
-                fbuffer[2] = fbuffer[3];
-                fbuffer[3] = fdat;
-                if (fdat == 0x2A && uef_toneon == 1)
-                {
-                        fbuffer[3] = 0;
-                        c = 0;
-                        do
-                        {
-                                ffound = 0;
-                                while (!ffound && !uefloop)
-                                {
-                                        uef_poll();
-                                }
-                                if (uefloop) break;
-                                ffilename[c++] = fdat;
-                        } while (fdat != 0x0 && c < 10);
-                        if (uefloop) break;
-                        c--;
-                        while (c < 13) ffilename[c++] = 32;
-                        ffilename[c] = 0;
-
-                                getuefbyte();
-                                tb = fdat;
-                                getuefbyte();
-                                load = tb | (fdat << 8);
-                                getuefbyte();
-                                tb = fdat;
-                                getuefbyte();
-                                load |= (tb | (fdat << 8)) << 16;
-
-                                getuefbyte();
-                                tb = fdat;
-                                getuefbyte();
-                                run = tb | (fdat << 8);
-                                getuefbyte();
-                                tb = fdat;
-                                getuefbyte();
-                                run |= (tb | (fdat << 8)) << 16;
-
-                                getuefbyte();
-                                getuefbyte();
-
-                                getuefbyte();
-                                tb = fdat;
-                                getuefbyte();
-                                skip = tb | (fdat << 8);
-
-                                fsize += skip;
-
-                                getuefbyte();
-                                status = fdat;
-
-                        if (status & 0x80)
-                        {
-                                sprintf(s, "%s Size %04X Load %08X Run %08X", ffilename, fsize, load, run);
-                                cataddname(s);
-                                fsize = 0;
-                        }
-                        for (c = 0; c <skip + 8; c++)
-                        {
-                                getuefbyte();
-                        }
-                }
-        }
-        infilenames = 0;
-        gzseek(uef_f, temp, SEEK_SET);
-        uefloop = 0;
-        uef_inchunk       = binchunk;
-        uef_chunkid       = bchunkid;
-        uef_chunklen      = bchunklen;
-        uef_chunkpos      = bchunkpos;
-        uef_chunkdatabits = bchunkdatabits;
-        uef_chunkf        = bchunkf;
-        fdat = bdat;
-        ffound = bffound;
-        uef_intone = bintone;
-}
-
@@ -4,7 +4,8 @@
 void uef_load(const char *fn);
 void uef_close(void);
 void uef_poll(void);
-void uef_findfilenames(void);
+void uef_savepos(FILE *f);
+void uef_loadpos(FILE *f);
 
 extern int uef_toneon;
 
@@ -5,6 +5,7 @@
 #include "b-em.h"
 #include "via.h"
 #include "uservia.h"
+#include "sched.h"
 #include "model.h"
 #include "compact_joystick.h"
 #include "mouse.h"
@@ -92,9 +93,22 @@ uint8_t uservia_read(uint16_t addr)
     return via_read(&uservia, addr);
 }
 
+static void uservia_run(int cycles)
+{
+        via_poll(&uservia, cycles);
+}
+
+static int uservia_next(void)
+{
+        return via_next_event(&uservia);
+}
+
+static const sched_client_t uservia_client = { "uservia", uservia_run, uservia_next };
+
 void uservia_reset()
 {
         via_reset(&uservia);
+        sched_register(&uservia_client);
 
         uservia.read_portA = uservia_read_portA;
         uservia.read_portB = uservia_read_portB;
@@ -72,7 +72,11 @@ const char *vdfs_boot_dir = NULL;
  *
  * In the event this is a directory rather than a file this entry
  * will contain a head pointer to a linked list of children, those
- * being contents of the directory.
+ * being contents of the directory.  Once a directory has been searched
+ * it also gets an index, a hash table of the children by case-folded
+ * Acorn name and by host name, with the chains running through the
+ * children themselves.  The list remains the definitive record of the
+ * contents and gives the order for catalogues.
  */
 
 #define MAX_FILE_NAME    10
@@ -110,6 +114,12 @@ const char *vdfs_boot_dir = NULL;
 
 typedef struct vdfs_entry vdfs_entry;
 
+typedef struct {
+    unsigned   size;        // buckets per name, a power of two.
+    unsigned   count;       // children indexed.
+    vdfs_entry *bucket[];   // by Acorn name then by host name.
+} vdfs_index;
+
 typedef enum {
     SORT_NONE,
     SORT_ADFS,
@@ -119,6 +129,10 @@ typedef enum {
 struct vdfs_entry {
     vdfs_entry *parent;
     vdfs_entry *next;
+    vdfs_entry *acorn_hnext;    // next in parent's index by Acorn name.
+    vdfs_entry *host_hnext;     // next in parent's index by host name.
+    uint32_t   acorn_hash;      // hash filed under in parent's index.
+    bool       indexed;
     char       *host_path;
     char       *host_fn;
     char       *host_inf;
@@ -136,6 +150,7 @@ struct vdfs_entry {
         } file;
         struct {
             vdfs_entry *children;
+            vdfs_index *index;
             time_t     scan_mtime;
             unsigned   scan_seq;
             sort_type  sorted;
@@ -431,6 +446,135 @@ static void flush_all(void)
     }
 }
 
+/*
+ * Directory index.  Entries are kept at the head of their chains, as
+ * they are in the list of children, so where two children share a
+ * name the one found is the one the list would give before sorting.
+ */
+
+#define INDEX_MIN_SIZE 16
+
+static uint32_t acorn_hash(const char *fn, unsigned len)
+{
+    uint32_t hash = 2166136261u;
+    while (len--) {
+        int ch = *fn++;
+        if (ch >= 'a' && ch <= 'z')
+            ch = ch - 'a' + 'A';
+        hash = (hash ^ (ch & 0xff)) * 16777619u;
+    }
+    return hash;
+}
+
+static uint32_t host_hash(const char *fn)
+{
+    uint32_t hash = 2166136261u;
+    int ch;
+    while ((ch = *fn++))
+        hash = (hash ^ (ch & 0xff)) * 16777619u;
+    return hash;
+}
+
+static void index_link(vdfs_index *index, vdfs_entry *ent)
+{
+    vdfs_entry **acorn = &index->bucket[ent->acorn_hash & (index->size - 1)];
+    vdfs_entry **host = &index->bucket[index->size + (host_hash(ent->host_fn) & (index->size - 1))];
+    ent->acorn_hnext = *acorn;
+    *acorn = ent;
+    ent->host_hnext = *host;
+    *host = ent;
+    ent->indexed = true;
+    index->count++;
+}
+
+static void index_free(vdfs_entry *dir)
+{
+    if (dir->u.dir.index) {
+        free(dir->u.dir.index);
+        dir->u.dir.index = NULL;
+    }
+}
+
+static vdfs_index *index_build(vdfs_entry *dir)
+{
+    unsigned count = 0, size = INDEX_MIN_SIZE;
+    vdfs_entry *ent;
+
+    for (ent = dir->u.dir.children; ent; ent = ent->next)
+        count++;
+    while (size < count)
+        size <<= 1;
+    vdfs_index *index = calloc(1, sizeof(vdfs_index) + 2 * size * sizeof(vdfs_entry *));
+    if (index) {
+        index->size = size;
+        // Link in reverse list order so the chains follow the list.
+        vdfs_entry **ents = malloc(count * sizeof(vdfs_entry *));
+        if (ents || !count) {
+            unsigned ix = 0;
+            for (ent = dir->u.dir.children; ent; ent = ent->next) {
+                ent->acorn_hash = acorn_hash(ent->acorn_fn, ent->acorn_len);
+                ents[ix++] = ent;
+            }
+            while (ix)
+                index_link(index, ents[--ix]);
+            free(ents);
+            free(dir->u.dir.index);
+            dir->u.dir.index = index;
+            log_debug("vdfs: index_build: %u entries in %u buckets for %s", count, size, dir->host_path);
+            return index;
+        }
+        free(index);
+    }
+    log_warn("vdfs: out of memory indexing %s, falling back to linear search", dir->host_path);
+    return NULL;
+}
+
+static vdfs_index *dir_index(vdfs_entry *dir)
+{
+    vdfs_index *index = dir->u.dir.index;
+    if (!index)
+        index = index_build(dir);
+    return index;
+}
+
+// Index a child that has just been put at the head of the list.
+
+static void index_add(vdfs_entry *dir, vdfs_entry *ent)
+{
+    vdfs_index *index = dir->u.dir.index;
+    if (index) {
+        if (index->count >= index->size)
+            index_build(dir);
+        else {
+            ent->acorn_hash = acorn_hash(ent->acorn_fn, ent->acorn_len);
+            index_link(index, ent);
+        }
+    }
+}
+
+// Re-file a child whose Acorn name may have changed.
+
+static void index_update(vdfs_entry *ent)
+{
+    vdfs_entry *dir = ent->parent;
+    if (dir && dir != ent && ent->indexed) {
+        vdfs_index *index = dir->u.dir.index;
+        uint32_t hash = acorn_hash(ent->acorn_fn, ent->acorn_len);
+        if (index && hash != ent->acorn_hash) {
+            unsigned mask = index->size - 1;
+            vdfs_entry **pp = &index->bucket[ent->acorn_hash & mask];
+            while (*pp && *pp != ent)
+                pp = &(*pp)->acorn_hnext;
+            if (*pp)
+                *pp = ent->acorn_hnext;
+            pp = &index->bucket[hash & mask];
+            ent->acorn_hnext = *pp;
+            *pp = ent;
+            ent->acorn_hash = hash;
+        }
+    }
+}
+
 static void free_entry(vdfs_entry *ent)
 {
     if (ent) {
@@ -438,8 +582,10 @@ static void free_entry(vdfs_entry *ent)
         char *ptr = ent->host_path;
         if (ptr)
             free(ptr);
-        if (ent->attribs & ATTR_IS_DIR)
+        if (ent->attribs & ATTR_IS_DIR) {
             free_entry(ent->u.dir.children);
+            index_free(ent);
+        }
         free(ent);
     }
 }
@@ -632,6 +778,7 @@ static void vdfs_hosterr(int errnum)
 static void init_dir(vdfs_entry *ent)
 {
     ent->u.dir.children = NULL;
+    ent->u.dir.index = NULL;
     ent->u.dir.scan_mtime = 0;
     ent->u.dir.scan_seq = 0;
     ent->u.dir.sorted = SORT_NONE;
@@ -673,6 +820,7 @@ static void scan_attr(vdfs_entry *ent)
                 log_debug("vdfs: dir %.*s has become a file", ent->acorn_len, ent->acorn_fn);
                 attribs &= ~ATTR_IS_DIR;
                 free_entry(ent->u.dir.children);
+                index_free(ent);
             }
             ent->u.file.load_addr = 0;
             ent->u.file.exec_addr = 0;
@@ -727,6 +875,7 @@ static void scan_attr(vdfs_entry *ent)
                 log_debug("vdfs: dir %.*s has become a file", ent->acorn_len, ent->acorn_fn);
                 attribs &= ~ATTR_IS_DIR;
                 free_entry(ent->u.dir.children);
+                index_free(ent);
             }
             ent->u.file.load_addr = 0;
             ent->u.file.exec_addr = 0;
@@ -1101,11 +1250,15 @@ static void scan_entry(vdfs_entry *ent)
         scan_inf_file(ent);
     if (ent->acorn_len == 0)
         hst2bbc(ent);
+    index_update(ent);
 }
 
 static void init_entry(vdfs_entry *ent)
 {
     ent->next = NULL;
+    ent->acorn_hnext = NULL;
+    ent->host_hnext = NULL;
+    ent->indexed = false;
     ent->host_path = NULL;
     ent->host_fn = ".";
     ent->acorn_len = 0;
@@ -1146,6 +1299,14 @@ static int vdfs_cmp(vdfs_entry *ent_a, vdfs_entry *ent_b)
 
 static vdfs_entry *acorn_search(vdfs_entry *dir, vdfs_entry *obj)
 {
+    vdfs_index *index = dir_index(dir);
+    if (index) {
+        uint32_t hash = acorn_hash(obj->acorn_fn, obj->acorn_len);
+        for (vdfs_entry *ent = index->bucket[hash & (index->size - 1)]; ent; ent = ent->acorn_hnext)
+            if (!vdfs_cmp(ent, obj))
+                return ent;
+        return NULL;
+    }
     for (vdfs_entry *ent = dir->u.dir.children; ent; ent = ent->next)
         if (!vdfs_cmp(ent, obj))
             return ent;
@@ -1201,8 +1362,42 @@ bool vdfs_wildmat(const char *pattern, unsigned pat_len, const char *candidate,
     }
 }
 
+static bool is_wild(const char *fn, unsigned len)
+{
+    return memchr(fn, '*', len) || memchr(fn, '#', len);
+}
+
+/*
+ * Find the first child that has a given name, which must not contain
+ * wildcards, in a given DFS directory or in any if dfs_dir is zero.
+ */
+
+static vdfs_entry *name_search(vdfs_entry *dir, const char *fn, unsigned len, int dfs_dir)
+{
+    vdfs_index *index = dir_index(dir);
+    vdfs_entry *ent;
+
+    if (index)
+        ent = index->bucket[acorn_hash(fn, len) & (index->size - 1)];
+    else
+        ent = dir->u.dir.children;
+    while (ent) {
+        if (ent->acorn_len == len && (!dfs_dir || !vdfs_cmpch(dfs_dir, ent->dfs_dir))) {
+            unsigned ix = 0;
+            while (ix < len && !vdfs_cmpch(fn[ix], ent->acorn_fn[ix]))
+                ix++;
+            if (ix == len)
+                return ent;
+        }
+        ent = index ? ent->acorn_hnext : ent->next;
+    }
+    return NULL;
+}
+
 static vdfs_entry *wild_search(vdfs_entry *dir, vdfs_findres *res)
 {
+    if (!is_wild(res->acorn_fn, res->acorn_len))
+        return name_search(dir, res->acorn_fn, res->acorn_len, 0);
     for (vdfs_entry *ent = dir->u.dir.children; ent; ent = ent->next)
         if (vdfs_wildmat(res->acorn_fn, res->acorn_len, ent->acorn_fn, ent->acorn_len))
             return ent;
@@ -1256,6 +1451,7 @@ static vdfs_entry *new_entry(vdfs_entry *dir, const char *host_fn)
             ent->next = dir->u.dir.children;
             dir->u.dir.children = ent;
             dir->u.dir.sorted = SORT_NONE;
+            index_add(dir, ent);
             log_debug("vdfs: new_entry: returning new entry %p", ent);
             return ent;
         }
@@ -1268,6 +1464,14 @@ static vdfs_entry *new_entry(vdfs_entry *dir, const char *host_fn)
 
 static vdfs_entry *host_search(vdfs_entry *dir, const char *host_fn)
 {
+    vdfs_index *index = dir_index(dir);
+    if (index) {
+        uint32_t hash = host_hash(host_fn);
+        for (vdfs_entry *ent = index->bucket[index->size + (hash & (index->size - 1))]; ent; ent = ent->host_hnext)
+            if (!strcmp(ent->host_fn, host_fn))
+                return ent;
+        return NULL;
+    }
     for (vdfs_entry *ent = dir->u.dir.children; ent; ent = ent->next)
         if (!strcmp(ent->host_fn, host_fn))
             return ent;
@@ -1324,6 +1528,7 @@ static int scan_dir(vdfs_entry *dir)
         scan_dir_host(dir, dp);
         closedir(dp);
         scan_inf_dir(dir);
+        index_update(dir);
         dir->u.dir.scan_seq = scan_seq;
         dir->u.dir.scan_mtime = stb.st_mtime;
         return 0;
@@ -1506,12 +1711,19 @@ static vdfs_entry *find_entry_dfs(const vdfs_path *path, vdfs_findres *res, vdfs
     memcpy(res->acorn_fn, filename, len);
     res->acorn_len = len;
     if (!scan_dir(dir->dir)) {
-        for (vdfs_entry *ent = dir->dir->u.dir.children; ent; ent = ent->next) {
-            log_debug("vdfs: find_entry_dfs, considering entry %c.%.*s", ent->dfs_dir, ent->acorn_len, ent->acorn_fn);
-            if (srchdir == '*' || srchdir == '#' || !vdfs_cmpch(srchdir, ent->dfs_dir)) {
-                log_debug("vdfs: find_entry_dfs, matched DFS dir");
-                if (vdfs_wildmat(res->acorn_fn, len, ent->acorn_fn, ent->acorn_len))
-                    return ent;
+        if (!is_wild(filename, len)) {
+            vdfs_entry *ent = name_search(dir->dir, filename, len, (srchdir == '*' || srchdir == '#') ? 0 : srchdir);
+            if (ent)
+                return ent;
+        }
+        else {
+            for (vdfs_entry *ent = dir->dir->u.dir.children; ent; ent = ent->next) {
+                log_debug("vdfs: find_entry_dfs, considering entry %c.%.*s", ent->dfs_dir, ent->acorn_len, ent->acorn_fn);
+                if (srchdir == '*' || srchdir == '#' || !vdfs_cmpch(srchdir, ent->dfs_dir)) {
+                    log_debug("vdfs: find_entry_dfs, matched DFS dir");
+                    if (vdfs_wildmat(res->acorn_fn, len, ent->acorn_fn, ent->acorn_len))
+                        return ent;
+                }
             }
         }
     }
@@ -1568,6 +1780,7 @@ static vdfs_entry *add_new_file(vdfs_findres *res)
             new_ent->next = dir->u.dir.children;
             dir->u.dir.children = new_ent;
             dir->u.dir.sorted = SORT_NONE;
+            index_add(dir, new_ent);
             return new_ent;
         }
         free(new_ent);
@@ -1717,6 +1930,7 @@ void vdfs_close(void)
         root_dir.u.dir.children = NULL;
         root_dir.u.dir.sorted = SORT_NONE;
     }
+    index_free(&root_dir);
 }
 
 void vdfs_set_root(const char *root)
@@ -1948,9 +2162,11 @@ static void exec_swr_fs(uint8_t flags, uint16_t fname, int8_t romid, uint32_t st
                             if (ent->attribs & ATTR_IS_DIR)
                                 vdfs_error(err_wont);
                             else if ((fp = fopen(ent->host_path, "rb"))) {
-                                if (fread(rom + romid * 0x4000 + start, len, 1, fp) != 1 && ferror(fp))
+                                uint8_t *rom_ptr = rom + romid * 0x4000 + start;
+                                if (fread(rom_ptr, len, 1, fp) != 1 && ferror(fp))
                                     log_warn("vdfs: error reading file '%s': %s", ent->host_fn, strerror(errno));
                                 fclose(fp);
+                                m6502_mem_written(rom_ptr, len);
                             } else {
                                 log_warn("vdfs: unable to load file '%s': %s", ent->host_fn, strerror(errno));
                                 vdfs_hosterr(errno);
@@ -2006,7 +2222,9 @@ static void exec_swr_ram(uint8_t flags, uint32_t ram_start, uint16_t len, uint32
     log_debug("vdfs: exec_swr_ram: flags=%02x, ram_start=%04x, len=%04x, sw_start=%04x, romid=%02d\n", flags, ram_start, len, sw_start, romid);
     int16_t nromid = swr_calc_addr(flags, &sw_start, romid);
     if (nromid >= 0) {
-        uint8_t *rom_ptr = rom + romid * 0x4000 + sw_start;
+        uint8_t *rom_base = rom + romid * 0x4000 + sw_start;
+        uint8_t *rom_ptr = rom_base;
+        uint16_t count = len;
         if (ram_start >= 0xffff0000 || curtube == -1) {
             if (flags & 0x80)
                 while (len--)
@@ -2023,6 +2241,8 @@ static void exec_swr_ram(uint8_t flags, uint32_t ram_start, uint16_t len, uint32
                 while (len--)
                     tube_writemem(ram_start++, *rom_ptr++);
         }
+        if (flags & 0x80)
+            m6502_mem_written(rom_base, count);
     }
 }
 
@@ -4008,11 +4228,15 @@ static void rename_tail(vdfs_entry *old_ent, vdfs_entry *new_ent)
         if (old_ent->attribs & ATTR_IS_DIR) {
             new_ent->attribs |= ATTR_EXISTS|ATTR_IS_DIR;
             new_ent->u.dir.children   = old_ent->u.dir.children;
+            new_ent->u.dir.index      = old_ent->u.dir.index;
             new_ent->u.dir.scan_seq   = old_ent->u.dir.scan_seq;
             new_ent->u.dir.scan_mtime = old_ent->u.dir.scan_mtime;
             new_ent->u.dir.sorted     = old_ent->u.dir.sorted;
             old_ent->u.dir.children   = NULL;
+            old_ent->u.dir.index      = NULL;
             old_ent->u.dir.sorted     = SORT_NONE;
+            for (vdfs_entry *ent = new_ent->u.dir.children; ent; ent = ent->next)
+                ent->parent = new_ent;
         }
         else {
             new_ent->attribs |= ATTR_EXISTS;
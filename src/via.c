@@ -1,5 +1,6 @@
 #include "b-em.h"
 #include "6502.h"
+#include "sched.h"
 #include "via.h"
 
 #define INT_CA1    0x02
@@ -71,6 +72,29 @@ void via_poll(VIA *v, int cycles)
         via_shift(v, cycles);
 }
 
+/*
+ * Return the number of cycles until via_poll next has something to do
+ * other than count down, i.e. a timer raising an interrupt.
+ */
+
+int via_next_event(VIA *v)
+{
+    int due = SCHED_MAX_DELAY;
+
+    if ((v->acr & 0x1c) == 0x18) {
+        /*Shift register clocked every cycle, due when the last bit is out*/
+        if (v->sr_count > 0)
+            due = v->sr_count;
+        else if (!(v->ifr & 0x04))
+            return 1;
+    }
+    if (!v->t1hit && v->t1c - TLIMIT < due)
+        due = v->t1c - TLIMIT + 1;
+    if (!(v->acr & 0x20) && !v->t2hit && v->t2c - TLIMIT < due)
+        due = v->t2c - TLIMIT + 1;
+    return due;
+}
+
 void via_write(VIA *v, uint16_t addr, uint8_t val)
 {
         switch (addr&0xF)
@@ -4,6 +4,7 @@
 #include "b-em.h"
 #include "led.h"
 #include "main.h"
+#include "metrics.h"
 #include "pal.h"
 #include "serial.h"
 #include "tape.h"
@@ -19,6 +20,7 @@ int vid_ledlocation = LED_LOC_NONE;
 int vid_ledvisibility = LED_VIS_ALWAYS;
 
 static int fskipcount;
+static char *shadow;    // copy of the rows of b last drawn.
 
 int vid_savescrshot = 0;
 char vid_scrshotname[260];
@@ -28,12 +30,20 @@ int save_winsizex, save_winsizey;
 int scr_x_start, scr_x_size, scr_y_start, scr_y_size;
 
 bool vid_print_mode = false;
+bool vid_headless = false;
 
 void video_close()
 {
+    video_render_close();
     al_destroy_bitmap(b32);
     al_destroy_bitmap(b16);
     al_destroy_bitmap(b);
+    if (bdisp)
+        al_destroy_bitmap(bdisp);
+    if (shadow) {
+        free(shadow);
+        shadow = NULL;
+    }
 }
 
 #ifdef WIN32
@@ -243,13 +253,13 @@ static void upscale_only(ALLEGRO_BITMAP *src, int sx, int sy, int sw, int sh, in
     }
 }
 
-static void line_double(void)
+static void line_double(int y1, int y2)
 {
-    char *yptr1 = (char *)region->data + region->pitch * firsty * 2;
+    char *yptr1 = (char *)region->data + region->pitch * y1 * 2;
     char *yptr2 = yptr1 + region->pitch;
     size_t linesize = abs(region->pitch);
 
-    for (int y = firsty; y < lasty; y++) {
+    for (int y = y1; y < y2; y++) {
         memcpy(yptr2, yptr1, linesize);
         yptr1 = yptr2 + region->pitch;
         yptr2 = yptr1 + region->pitch;
@@ -261,10 +271,10 @@ static void mono_convert(int x1, int y1, int x2, int y2, ALLEGRO_COLOR mono_col)
     float mono_r, mono_g, mono_b;
     al_unmap_rgb_f(mono_col, &mono_r, &mono_g, &mono_b);
     log_debug("mono_convert: mono_r=%g, mono_g=%g, mono_b=%g", mono_r, mono_g, mono_b);
-    ALLEGRO_LOCKED_REGION *dest_region = al_lock_bitmap(b32, ALLEGRO_PIXEL_FORMAT_ARGB_8888, ALLEGRO_LOCK_WRITEONLY);
+    ALLEGRO_LOCKED_REGION *dest_region = al_lock_bitmap_region(b32, x1, y1, x2 - x1, y2 - y1, ALLEGRO_PIXEL_FORMAT_ARGB_8888, ALLEGRO_LOCK_WRITEONLY);
     for (int y = y1; y < y2; ++y) {
         char *src_row = (char *)region->data + region->pitch * y;
-        char *dest_row = (char *)dest_region->data + dest_region->pitch * y;
+        char *dest_row = (char *)dest_region->data + dest_region->pitch * (y - y1) - x1 * dest_region->pixel_size;
         for (int x = x1; x < x2; ++x) {
             uint32_t *src_addr = (uint32_t *)(src_row + x * region->pixel_size);
             uint32_t pixel = *src_addr;
@@ -308,7 +318,7 @@ static inline void save_screenshot(void)
                             al_draw_bitmap_region(b, firstx, y, xsize, 1, 0, c, 0);
                         break;
                     case VDT_LINEDOUBLE:
-                        line_double();
+                        line_double(firsty, lasty);
                         al_unlock_bitmap(b);
                         al_draw_scaled_bitmap(b, firstx, firsty << 1, xsize, ysize << 1, 0, 0, xsize, ysize << 1, 0);
                         break;
@@ -334,7 +344,7 @@ static inline void save_screenshot(void)
                             al_draw_bitmap_region(b32, firstx, y, xsize, 1, 0, c, 0);
                         break;
                     case VDT_LINEDOUBLE:
-                        line_double();
+                        line_double(firsty, lasty);
                         pal_convert(firstx, firsty << 1, lastx, lasty << 1, 1);
                         al_set_target_bitmap(scrshotb);
                         al_draw_bitmap_region(b32, firstx, firsty << 1, xsize, ysize << 1, 0, 0, 0);
@@ -368,7 +378,7 @@ static inline void save_screenshot(void)
                             al_draw_bitmap_region(b32, firstx, y, xsize, 1, 0, c, 0);
                         break;
                     case VDT_LINEDOUBLE:
-                        line_double();
+                        line_double(firsty, lasty);
                         mono_convert(firstx, firsty << 1, lastx, lasty << 1, mono_col);
                         al_set_target_bitmap(scrshotb);
                         al_draw_bitmap_region(b32, firstx, firsty << 1, xsize, ysize << 1, 0, 0, 0);
@@ -440,7 +450,91 @@ static inline void calc_limits(bool non_ttx, uint8_t vtotal)
     }
 }
 
-static inline void blit_screen(void)
+/*
+ * Change tracking.  The rows of b that the current display type shows
+ * are compared each frame with a copy of the rows last drawn so that
+ * only changed rows are converted and uploaded to the display bitmap
+ * and a frame in which nothing changed is not drawn at all.
+ * Everything is redrawn when the view changes and at least once a
+ * second in case the window contents or the texture were lost.
+ */
+
+#define BLIT_MAX_SKIP 50
+
+static const int led_visible_for_frames = 50;
+static const int led_fade_frames = 25;
+
+static int blit_skipped;
+
+static struct blit_view {
+    int firstx, firsty, lastx, lasty;
+    int dtype, colour, borders;
+    int x_start, x_size, y_start, y_size, winx, winy;
+} last_view;
+
+/*
+ * Compare every step'th row from y1 up to y2 with the copy and narrow
+ * y1 and y2 down to the band of rows that changed.  Returns false if
+ * none did.
+ */
+
+static bool find_changed_rows(int *y1, int *y2, int step)
+{
+    size_t offset = firstx * region->pixel_size;
+    size_t linesize = (lastx - firstx) * region->pixel_size;
+    size_t pitch = abs(region->pitch);
+    int first = -1, last = -1;
+
+    if (!shadow && !(shadow = calloc(800, pitch)))
+        return true;
+    for (int y = *y1; y < *y2; y += step) {
+        const char *row = (const char *)region->data + region->pitch * y + offset;
+        char *copy = shadow + pitch * y + offset;
+        if (memcmp(row, copy, linesize)) {
+            memcpy(copy, row, linesize);
+            if (first < 0)
+                first = y;
+            last = y;
+        }
+    }
+    if (first < 0)
+        return false;
+    *y1 = first;
+    *y2 = last + step;
+    return true;
+}
+
+static bool view_changed(void)
+{
+    struct blit_view view = {
+        firstx, firsty, lastx, lasty,
+        vid_dtype_intern, vid_colour_out, vid_fullborders,
+        scr_x_start, scr_x_size, scr_y_start, scr_y_size, winsizex, winsizey
+    };
+    if (memcmp(&view, &last_view, sizeof(view))) {
+        last_view = view;
+        return true;
+    }
+    return false;
+}
+
+static bool leds_changing(void)
+{
+    return vid_ledlocation > LED_LOC_NONE && (led_ticks > 0 || framesrun - last_led_update_at <= led_visible_for_frames);
+}
+
+static void upload_rows(int y1, int y2)
+{
+    size_t linesize = (lastx - firstx) * region->pixel_size;
+    ALLEGRO_LOCKED_REGION *dest = al_lock_bitmap_region(bdisp, firstx, y1, lastx - firstx, y2 - y1, ALLEGRO_PIXEL_FORMAT_ARGB_8888, ALLEGRO_LOCK_WRITEONLY);
+    if (dest) {
+        for (int y = y1; y < y2; y++)
+            memcpy((char *)dest->data + dest->pitch * (y - y1), (char *)region->data + region->pitch * y + firstx * region->pixel_size, linesize);
+        al_unlock_bitmap(bdisp);
+    }
+}
+
+static inline void blit_screen(int y1, int y2)
 {
     int xsize = lastx - firstx;
     int ysize = lasty - firsty + 1;
@@ -448,30 +542,27 @@ static inline void blit_screen(void)
 
     switch(vid_colour_out) {
         case VDC_RGB:
+            if (vid_dtype_intern == VDT_LINEDOUBLE)
+                line_double(y1 >> 1, y2 >> 1);
+            upload_rows(y1, y2);
             switch(vid_dtype_intern) {
                 case VDT_SCALE:
-                    al_unlock_bitmap(b);
                     al_set_target_backbuffer(al_get_current_display());
-                    al_draw_scaled_bitmap(b, firstx, firsty, xsize, ysize, scr_x_start, scr_y_start, scr_x_size, scr_y_size, 0);
+                    al_draw_scaled_bitmap(bdisp, firstx, firsty, xsize, ysize, scr_x_start, scr_y_start, scr_x_size, scr_y_size, 0);
                     break;
                 case VDT_INTERLACE:
-                    al_unlock_bitmap(b);
-                    upscale_only(b, firstx, firsty << 1, lastx - firstx, (lasty - firsty) << 1, scr_x_start, scr_y_start, scr_x_size, scr_y_size);
+                    upscale_only(bdisp, firstx, firsty << 1, lastx - firstx, (lasty - firsty) << 1, scr_x_start, scr_y_start, scr_x_size, scr_y_size);
                     break;
                 case VDT_SCANLINES:
-                    al_unlock_bitmap(b);
                     al_set_target_bitmap(b16);
                     al_clear_to_color(border_col);
                     for (int c = firsty; c < lasty; c++)
-                        al_draw_bitmap_region(b, firstx, c, xsize, 1, 0, c << 1, 0);
+                        al_draw_bitmap_region(bdisp, firstx, c, xsize, 1, 0, c << 1, 0);
                     upscale_only(b16, 0, firsty << 1, lastx - firstx, (lasty - firsty) << 1, scr_x_start, scr_y_start, scr_x_size, scr_y_size);
                     break;
                 case VDT_LINEDOUBLE:
-                    line_double();
-                    al_unlock_bitmap(b);
-                    upscale_only(b, firstx, firsty << 1, xsize, ysize  << 1, scr_x_start, scr_y_start, scr_x_size, scr_y_size);
+                    upscale_only(bdisp, firstx, firsty << 1, xsize, ysize  << 1, scr_x_start, scr_y_start, scr_x_size, scr_y_size);
             }
-            region = al_lock_bitmap(b, ALLEGRO_PIXEL_FORMAT_ARGB_8888, ALLEGRO_LOCK_WRITEONLY);
             break;
         case VDC_PAL:
             switch(vid_dtype_intern) {
@@ -493,7 +584,7 @@ static inline void blit_screen(void)
                     upscale_only(b16, 0, firsty << 1, xsize, ysize << 1, scr_x_start, scr_y_start, scr_x_size, scr_y_size);
                     break;
                 case VDT_LINEDOUBLE:
-                    line_double();
+                    line_double(firsty, lasty);
                     pal_convert(firstx, firsty << 1, lastx, lasty << 1, 1);
                     upscale_only(b32, firstx, firsty << 1, xsize, ysize << 1, scr_x_start, scr_y_start, scr_x_size, scr_y_size);
                     break;
@@ -510,16 +601,16 @@ static inline void blit_screen(void)
         mono_common:
             switch(vid_dtype_intern) {
                 case VDT_SCALE:
-                    mono_convert(firstx, firsty, lastx, lasty, mono_col);
+                    mono_convert(firstx, y1, lastx, y2, mono_col);
                     al_set_target_backbuffer(al_get_current_display());
                     al_draw_scaled_bitmap(b32, firstx, firsty, xsize, ysize, scr_x_start, scr_y_start, scr_x_size, scr_y_size, 0);
                     break;
                 case VDT_INTERLACE:
-                    mono_convert(firstx, firsty << 1, lastx, lasty << 1, mono_col);
+                    mono_convert(firstx, y1, lastx, y2, mono_col);
                     upscale_only(b32, firstx, firsty << 1, xsize, ysize << 1, scr_x_start, scr_y_start, scr_x_size, scr_y_size);
                     break;
                 case VDT_SCANLINES:
-                    mono_convert(firstx, firsty, lastx, lasty, mono_col);
+                    mono_convert(firstx, y1, lastx, y2, mono_col);
                     al_set_target_bitmap(b16);
                     al_clear_to_color(al_map_rgb(0, 0,0));
                     for (int c = firsty; c < lasty; c++)
@@ -527,8 +618,8 @@ static inline void blit_screen(void)
                     upscale_only(b16, 0, firsty << 1, xsize, ysize << 1, scr_x_start, scr_y_start, scr_x_size, scr_y_size);
                     break;
                 case VDT_LINEDOUBLE:
-                    line_double();
-                    mono_convert(firstx, firsty << 1, lastx, lasty << 1, mono_col);
+                    line_double(y1 >> 1, y2 >> 1);
+                    mono_convert(firstx, y1, lastx, y2, mono_col);
                     upscale_only(b32, firstx, firsty << 1, xsize, ysize << 1, scr_x_start, scr_y_start, scr_x_size, scr_y_size);
                     break;
 
@@ -567,9 +658,6 @@ static void render_leds(void)
         }
         else {
             ALLEGRO_COLOR led_tint;
-            const int led_visible_for_frames = 50;
-            const int led_fade_frames = 25;
-
             int led_visible_frames_left = led_visible_for_frames - (framesrun - last_led_update_at);
             if (led_visible_frames_left > 0) {
                 log_debug("led: visible frames left=%d", led_visible_frames_left);
@@ -594,7 +682,9 @@ void video_doblit(bool non_ttx, uint8_t vtotal)
         save_screenshot();
 
     ++framesrun;
-    if (++fskipcount >= ((motor && fasttape) ? 5 : vid_fskipmax)) {
+    if (vid_headless || turbo)
+        fskipcount = 0;
+    else if (++fskipcount >= ((motor && fasttape) ? 5 : vid_fskipmax)) {
         if (fullscreen_pending) {
             ALLEGRO_DISPLAY *display = al_get_current_display();
             int newsizex = al_get_display_width(display);
@@ -611,15 +701,35 @@ void video_doblit(bool non_ttx, uint8_t vtotal)
         lasty++;
         calc_limits(non_ttx, vtotal);
         fskipcount = 0;
-        blit_screen();
-        if (scr_x_start > 0)
-            fill_pillarbox();
-        else if (scr_y_start > 0)
-            fill_letterbox();
-
-        render_leds();
-        al_set_target_bitmap(b);
-        al_flip_display();
+        metrics.frames_drawn++;
+
+        int y1 = firsty, y2 = lasty + 1, step = 1;
+        if (vid_dtype_intern == VDT_INTERLACE || vid_dtype_intern == VDT_LINEDOUBLE) {
+            y1 <<= 1;
+            y2 <<= 1;
+            if (vid_dtype_intern == VDT_LINEDOUBLE)
+                step = 2;
+        }
+        // the PAL filter carries state from one frame to the next.
+        bool redraw_all = view_changed() || blit_skipped >= BLIT_MAX_SKIP || vid_colour_out == VDC_PAL || leds_changing();
+        int cy1 = y1, cy2 = y2;
+        if (find_changed_rows(&cy1, &cy2, step) || redraw_all) {
+            if (redraw_all)
+                blit_screen(y1, y2);
+            else
+                blit_screen(cy1, cy2);
+            if (scr_x_start > 0)
+                fill_pillarbox();
+            else if (scr_y_start > 0)
+                fill_letterbox();
+
+            render_leds();
+            al_set_target_bitmap(b);
+            al_flip_display();
+            blit_skipped = 0;
+        }
+        else
+            blit_skipped++;
     }
     firstx = firsty = 65535;
     lastx  = lasty  = 0;
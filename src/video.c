@@ -8,6 +8,7 @@
 
 #include "config.h"
 #include "6502.h"
+#include "main.h"
 #include "mem.h"
 #include "model.h"
 #include "serial.h"
@@ -25,6 +26,8 @@ int interlline = 0;
 static int colblack;
 static int colwhite;
 
+static bool vr_state_dirty = true;  // renderer needs a new copy of vr_state_t.
+
 /*6845 CRTC*/
 uint8_t crtc[32];
 static const uint8_t crtc_mask[32] = { 0xFF, 0xFF, 0xFF, 0xFF, 0x7F, 0x1F, 0x7F, 0x7F, 0xF3, 0x1F, 0x7F, 0x1F, 0x3F, 0xFF, 0x3F, 0xFF, 0x3F, 0xFF };
@@ -68,6 +71,8 @@ static void crtc_setreg(int reg, uint8_t val)
         vdispen = 0;
     else if (reg == 8)
         set_intern_dtype(vid_dtype_user);
+    else if (reg == 1)
+        vr_state_dirty = true;
     else if (reg == 12)
         ttxbank = (MASTER|BPLUS) ? 0x7c00 : 0x3C00 | ((val & 0x8) << 11);
 }
@@ -144,12 +149,36 @@ uint8_t nula_attribute_text;
 
 static int nula_left_cut;
 static int nula_left_edge;
-static int mode7_need_new_lookup;
+static int mode7_need_new_lookup = 1;
 
 static int nula_spect_toggle = 0;
 static int nula_spect_paper = 0;
 static int nula_spect_ink = 0;
 
+/*
+ * The video ULA and NuLA state as seen by the renderer.  This is a copy
+ * sent along with the drawing commands whenever the emulated registers
+ * change so that palette changes part way down the screen still take
+ * effect at the right place.
+ */
+
+typedef struct {
+    int     ula_pal[16];
+    int     nula_collook[16];
+    int     colblack;
+    uint8_t ula_ctrl;
+    uint8_t ula_mode;
+    uint8_t crtc_mode;
+    uint8_t crtc1;
+    uint8_t nula_palette_mode;
+    uint8_t nula_attribute_mode;
+    uint8_t nula_attribute_text;
+    uint8_t nula_horizontal_offset;
+    uint8_t nula_left_blank;
+} vr_state_t;
+
+static vr_state_t vrs;
+
 static const uint8_t nula_spect_colours[] =
 {
     8, // 000 Black.
@@ -201,8 +230,8 @@ static inline void put_pixels_checked(ALLEGRO_LOCKED_REGION *region, int x, int
 
 static inline void nula_putpixel_checked(ALLEGRO_LOCKED_REGION *region, int x, int y, uint32_t colour, int line)
 {
-    if (crtc_mode && (nula_horizontal_offset || nula_left_blank) && (x < nula_left_cut || x >= nula_left_edge + (crtc[1] * crtc_mode * 8)))
-        put_pixel_checked(region, x, y, colblack, line);
+    if (vrs.crtc_mode && (vrs.nula_horizontal_offset || vrs.nula_left_blank) && (x < nula_left_cut || x >= nula_left_edge + (vrs.crtc1 * vrs.crtc_mode * 8)))
+        put_pixel_checked(region, x, y, vrs.colblack, line);
     else if (x < 1280)
         put_pixel_checked(region, x, y, colour, line);
 }
@@ -229,8 +258,8 @@ static inline void put_pixels(ALLEGRO_LOCKED_REGION *region, int x, int y, int c
 
 static inline void nula_putpixel(ALLEGRO_LOCKED_REGION *region, int x, int y, uint32_t colour)
 {
-    if (crtc_mode && (nula_horizontal_offset || nula_left_blank) && (x < nula_left_cut || x >= nula_left_edge + (crtc[1] * crtc_mode * 8)))
-        put_pixel(region, x, y, colblack);
+    if (vrs.crtc_mode && (vrs.nula_horizontal_offset || vrs.nula_left_blank) && (x < nula_left_cut || x >= nula_left_edge + (vrs.crtc1 * vrs.crtc_mode * 8)))
+        put_pixel(region, x, y, vrs.colblack);
     else if (x < 1280)
         put_pixel(region, x, y, colour);
 }
@@ -256,7 +285,7 @@ static void nula_default_palette(void)
     nula_collook[14] = 0xff00ffff; // cyan
     nula_collook[15] = 0xffffffff; // white
 
-    mode7_need_new_lookup = 1;
+    vr_state_dirty = true;
 }
 
 void nula_reset(void)
@@ -417,7 +446,6 @@ void videoula_write(uint16_t addr, uint8_t val)
                     if ((ula_palbak[c] & 8) && (ula_ctrl & 1) && nula_flash[(ula_palbak[c] & 7) ^ 7])
                         ula_pal[c] = nula_collook[ula_palbak[c] & 15];
                 }
-                mode7_need_new_lookup = 1;
             } else {
                 // Remember the first byte
                 nula_pal_first_byte = val;
@@ -428,6 +456,7 @@ void videoula_write(uint16_t addr, uint8_t val)
         break;
 
     }
+    vr_state_dirty = true;
 }
 
 void videoula_savestate(FILE * f)
@@ -477,6 +506,7 @@ void videoula_loadstate(FILE * f)
     nula_disable = *ptr++;
     nula_attribute_mode = *ptr++;
     nula_attribute_text = *ptr++;
+    vr_state_dirty = true;
 }
 
 /*Mode 7 (SAA5050)*/
@@ -486,6 +516,20 @@ static uint8_t *mode7_chars = NULL, *mode7_graph, *mode7_sepgraph, *mode7_p, *mo
 static int mode7_width, mode7_bytes_per_char;
 static int mode7_lookup[8][8][16];
 
+/*
+ * Rendered span cache.  The font has only a few hundred distinct rows of
+ * weights once each row is split into its two interlace fields, so each
+ * field of each font row is mapped to a pattern number when the font is
+ * loaded and a cell is drawn by copying the span for that pattern in the
+ * current foreground/background pair, rendering it the first time it is
+ * needed.  The spans are discarded when the colour lookup changes.
+ */
+static uint16_t *mode7_rowpat;   /* two pattern numbers per font row. */
+static uint8_t *mode7_patdata;   /* mode7_width weights per pattern.  */
+static uint32_t *mode7_spans;    /* mode7_width pixels per pattern/colour pair. */
+static uint8_t *mode7_span_ok;
+static int mode7_npats;
+
 static int mode7_col = 7, mode7_bg = 0;
 static int mode7_sep = 0;
 static int mode7_dbl, mode7_nextdbl, mode7_wasdbl;
@@ -497,6 +541,69 @@ static uint8_t mode7_heldchar, mode7_holdchar;
 
 #define MODE7_CHAR_BANKS       3
 #define MODE7_NUM_CHARS       96
+#define MODE7_COL_PAIRS       64
+
+static bool mode7_index_rows(const uint8_t *chars, int nrows)
+{
+    int nfields = nrows * 2;
+    if (nfields > 65536)
+        return false;
+
+    int hsize = 1;
+    while (hsize < nfields * 2)
+        hsize <<= 1;
+
+    uint16_t *rowpat = malloc(nfields * sizeof(uint16_t));
+    uint8_t *patdata = malloc(nfields * mode7_width);
+    int *hash = malloc(hsize * sizeof(int));
+    if (!rowpat || !patdata || !hash) {
+        free(rowpat);
+        free(patdata);
+        free(hash);
+        return false;
+    }
+    for (int i = 0; i < hsize; i++)
+        hash[i] = -1;
+
+    int npats = 0;
+    for (int field = 0; field < nfields; field++) {
+        const uint8_t *src = chars + (field >> 1) * mode7_width;
+        uint8_t *weights = patdata + npats * mode7_width;
+        uint32_t h = 2166136261u;
+        for (int c = 0; c < mode7_width; c++) {
+            weights[c] = (field & 1) ? src[c] >> 4 : src[c] & 0x0f;
+            h = (h ^ weights[c]) * 16777619u;
+        }
+        int slot = h & (hsize - 1);
+        while (hash[slot] >= 0 && memcmp(patdata + hash[slot] * mode7_width, weights, mode7_width))
+            slot = (slot + 1) & (hsize - 1);
+        if (hash[slot] < 0)
+            hash[slot] = npats++;
+        rowpat[field] = hash[slot];
+    }
+    free(hash);
+
+    uint32_t *spans = malloc(npats * MODE7_COL_PAIRS * mode7_width * sizeof(uint32_t));
+    uint8_t *span_ok = calloc(npats, MODE7_COL_PAIRS);
+    if (!spans || !span_ok) {
+        free(rowpat);
+        free(patdata);
+        free(spans);
+        free(span_ok);
+        return false;
+    }
+    free(mode7_rowpat);
+    free(mode7_patdata);
+    free(mode7_spans);
+    free(mode7_span_ok);
+    mode7_rowpat = rowpat;
+    mode7_patdata = patdata;
+    mode7_spans = spans;
+    mode7_span_ok = span_ok;
+    mode7_npats = npats;
+    log_debug("video: mode 7 font has %d distinct row patterns", npats);
+    return true;
+}
 
 static bool mode7_load_file(const char *cpath)
 {
@@ -523,7 +630,16 @@ static bool mode7_load_file(const char *cpath)
                 int total_size = bytes_per_bank * MODE7_CHAR_BANKS;
                 uint8_t *new_chars = malloc(total_size);
                 if (new_chars) {
-                    if (fread(new_chars, total_size, 1, fp) == 1) {
+                    if (fread(new_chars, total_size, 1, fp) != 1) {
+                        const char *msg = ferror(fp) ? strerror(errno) : "file is too short";
+                        log_error("video: error reading body of teletext font file '%s': %s", cpath, msg);
+                        free(new_chars);
+                    }
+                    else if (!mode7_index_rows(new_chars, rows * MODE7_NUM_CHARS * MODE7_CHAR_BANKS)) {
+                        log_error("video: out of memory indexing teletext font file '%s'", cpath);
+                        free(new_chars);
+                    }
+                    else {
                         if (mode7_chars)
                             free(mode7_chars);
                         mode7_p = mode7_chars = new_chars;
@@ -532,11 +648,6 @@ static bool mode7_load_file(const char *cpath)
                         log_debug("video: mode7_makechars chars=%p, graph=%p, sepgraph=%p", mode7_chars, mode7_graph, mode7_sepgraph);
                         worked = true;
                     }
-                    else {
-                        const char *msg = ferror(fp) ? strerror(errno) : "file is too short";
-                        log_error("video: error reading body of teletext font file '%s': %s", cpath, msg);
-                        free(new_chars);
-                    }
                 }
                 else
                     log_error("video: out of memory reading teletext font file '%s'", cpath);
@@ -556,6 +667,8 @@ static bool mode7_load_file(const char *cpath)
 bool mode7_loadchars(const char *fn)
 {
     bool worked = false;
+
+    video_render_sync();
     if (is_relative_filename(fn)) {
         ALLEGRO_PATH *path = find_dat_file(font_dir, fn, ".fnt");
         if (path) {
@@ -589,12 +702,12 @@ static void mode7_gen_nula_lookup(void)
     int weight, lu_red, lu_grn, lu_blu;
 
     for (fg_ix = 0; fg_ix < 8; fg_ix++) {
-        fg_pix = nula_collook[fg_ix];
+        fg_pix = vrs.nula_collook[fg_ix];
         fg_red = (fg_pix >> 16) & 0xff;
         fg_grn = (fg_pix >> 8) & 0xff;
         fg_blu = fg_pix & 0xff;
         for (bg_ix = 0; bg_ix < 8; bg_ix++) {
-            bg_pix = nula_collook[bg_ix];
+            bg_pix = vrs.nula_collook[bg_ix];
             bg_red = (bg_pix >> 16) & 0xff;
             bg_grn = (bg_pix >> 8) & 0xff;
             bg_blu = bg_pix & 0xff;
@@ -606,160 +719,643 @@ static void mode7_gen_nula_lookup(void)
             }
         }
     }
+    if (mode7_span_ok)
+        memset(mode7_span_ok, 0, mode7_npats * MODE7_COL_PAIRS);
     mode7_need_new_lookup = 0;
 }
 
-static void mode7_render(ALLEGRO_LOCKED_REGION *region, uint8_t dat)
-{
-    if (scrx < (1280-32)) {
-        int mcolx = mode7_col;
-        int holdoff = 0, holdclear = 0;
-        int mode7_flashx = mode7_flash, mode7_dblx = mode7_dbl;
-        int *on;
+/*
+ * Draw one teletext character.  The SAA5050 is two characters behind the
+ * CRTC so dat is the character fetched two calls to mode7_fetch ago.
+ */
 
-        if (mode7_need_new_lookup)
-            mode7_gen_nula_lookup();
+static void mode7_render(ALLEGRO_LOCKED_REGION *region, int x, int y, uint8_t dat, int row, bool interindex)
+{
+    int mcolx = mode7_col;
+    int holdoff = 0, holdclear = 0;
+    int mode7_flashx = mode7_flash, mode7_dblx = mode7_dbl;
+
+    if (mode7_need_new_lookup)
+        mode7_gen_nula_lookup();
+
+    uint8_t *mode7_px = mode7_p;
+
+    if (dat < 0x20) {
+        switch (dat) {
+        case 1: /* 129: alphanumeric red     */
+        case 2: /* 130: alphanumeric green   */
+        case 3: /* 131: alphanumeric yellow  */
+        case 4: /* 132: alphanumeric blue    */
+        case 5: /* 133: alphanumeric magenta */
+        case 6: /* 134: alphanumeric cyan    */
+        case 7: /* 135: alphanumeric white   */
+            mode7_gfx = 0;
+            mode7_col = dat;
+            mode7_p = mode7_chars;
+            holdclear = 1;
+            break;
+        case 8: /* 136: flash */
+            mode7_flash = 1;
+            break;
+        case 9: /* 137: steady */
+            mode7_flash = 0;
+            break;
+        case 12: /* 140: normal height */
+        case 13: /* 141: double height */
+            mode7_dbl = dat & 1;
+            if (mode7_dbl)
+                mode7_wasdbl = 1;
+            break;
+        case 17: /* 145: graphics red     */
+        case 18: /* 146: graphics green   */
+        case 19: /* 147: graphics yellow  */
+        case 20: /* 148: graphics blue    */
+        case 21: /* 149: graphics magenta */
+        case 22: /* 150: graphics cyan    */
+        case 23: /* 151: graphics white   */
+            mode7_gfx = 1;
+            mode7_col = dat & 7;
+            if (mode7_sep)
+                mode7_p = mode7_sepgraph;
+            else
+                mode7_p = mode7_graph;
+            break;
+        case 24: /* 152: conceal */
+            mode7_col = mcolx = mode7_bg;
+            break;
+        case 25: /* 153: contiguous graphics */
+            if (mode7_gfx)
+                mode7_p = mode7_graph;
+            mode7_sep = 0;
+            break;
+        case 26: /* 154: separated graphics */
+            if (mode7_gfx)
+                mode7_p = mode7_sepgraph;
+            mode7_sep = 1;
+            break;
+        case 28: /* 156: black background */
+            mode7_bg = 0;
+            break;
+        case 29: /* 157: new background */
+            mode7_bg = mode7_col;
+            break;
+        case 30: /* 158: hold graphics */
+            mode7_holdchar = 1;
+            break;
+        case 31: /* 159: release graphics */
+            holdoff = 1;
+            break;
+        }
+        if (mode7_holdchar) {
+            dat = mode7_heldchar;
+            if (!(dat & 0x20))
+                dat = 0x20;
+            mode7_px = mode7_heldp;
+        } else
+            dat = 0x20;
+        if (mode7_dblx != mode7_dbl)
+            dat = 0x20;           /*Double height doesn't respect held characters */
+        if (!mode7_holdchar || !mode7_gfx)
+            mode7_heldchar = 0x20;
+    } else if (mode7_gfx && dat & 0x20) {
+        mode7_heldchar = dat;
+        mode7_heldp = mode7_px;
+    }
 
-        uint8_t t = mode7_buf[0];
-        mode7_buf[0] = mode7_buf[1];
-        mode7_buf[1] = dat;
-        dat = t;
-        uint8_t *mode7_px = mode7_p;
+    int off = mode7_lookup[0][mode7_bg & 7][0];
+    int xpos = x + 16;
 
-        if (dat == 255) {
+    if (mode7_flashx && !mode7_flashon)
+        put_pixels(region, xpos, y, mode7_width, off);
+    else {
+        const uint8_t *ptr = mode7_px + (dat - 0x20) * mode7_bytes_per_char;
+        if (mode7_dblx) {
+            if (!mode7_nextdbl)
+                ptr += (row >> 1) * mode7_width;
+            else
+                ptr += ((row >> 1) + 5) * mode7_width;
+        }
+        else
+            ptr += row * mode7_width;
+
+        int fg = (!mode7_dbl && mode7_nextdbl) ? mode7_bg & 7 : mcolx & 7;
+        int pair = (fg << 3) | (mode7_bg & 7);
+        int field = (ptr - mode7_chars) / mode7_width * 2;
+        if ((!mode7_dblx && interindex) || (mode7_dblx && row & 1))
+            field++;
+
+        int span_ix = mode7_rowpat[field] * MODE7_COL_PAIRS + pair;
+        uint32_t *span = mode7_spans + span_ix * mode7_width;
+        if (!mode7_span_ok[span_ix]) {
+            const int *on = mode7_lookup[fg][mode7_bg & 7];
+            const uint8_t *weights = mode7_patdata + mode7_rowpat[field] * mode7_width;
             for (int c = 0; c < mode7_width; c++)
-                put_pixel(region, scrx + c + 16, scry, colblack);
-            return;
+                span[c] = on[weights[c]];
+            mode7_span_ok[span_ix] = 1;
         }
+        memcpy((char *)region->data + region->pitch * y + xpos * region->pixel_size, span, mode7_width * sizeof(uint32_t));
+    }
 
-        if (dat < 0x20) {
-            switch (dat) {
-            case 1: /* 129: alphanumeric red     */
-            case 2: /* 130: alphanumeric green   */
-            case 3: /* 131: alphanumeric yellow  */
-            case 4: /* 132: alphanumeric blue    */
-            case 5: /* 133: alphanumeric magenta */
-            case 6: /* 134: alphanumeric cyan    */
-            case 7: /* 135: alphanumeric white   */
-                mode7_gfx = 0;
-                mode7_col = dat;
-                mode7_p = mode7_chars;
-                holdclear = 1;
+    if (holdoff) {
+        mode7_holdchar = 0;
+        mode7_heldchar = 32;
+    }
+    if (holdclear)
+        mode7_heldchar = 32;
+}
+
+/*
+ * Byte to pixel lookup for the ordinary bitmap modes.  Each entry holds
+ * the sixteen pixels for one byte of screen memory in the current ULA
+ * mode and palette, the high frequency modes using the first eight.
+ * Entries are filled in as bytes are drawn and all become stale when
+ * the renderer receives a new mode or palette.
+ */
+
+static uint32_t vr_byte_pixels[256][16];
+static uint32_t vr_byte_gen[256];
+static uint32_t vr_pixel_gen = 1;
+
+static inline const uint32_t *vr_pixels(uint8_t dat)
+{
+    uint32_t *pix = vr_byte_pixels[dat];
+    if (vr_byte_gen[dat] != vr_pixel_gen) {
+        const int *pal = vrs.nula_palette_mode ? vrs.nula_collook : vrs.ula_pal;
+        const uint8_t *ix = table4bpp[vrs.ula_mode][dat];
+        for (int c = 0; c < 16; c++)
+            pix[c] = pal[ix[c]];
+        vr_byte_gen[dat] = vr_pixel_gen;
+    }
+    return pix;
+}
+
+static inline void vr_put_span(ALLEGRO_LOCKED_REGION *region, int x, int y, const uint32_t *pix, int count)
+{
+    if ((vrs.crtc_mode && (vrs.nula_horizontal_offset || vrs.nula_left_blank)) || x < 0 || x + count > 1280) {
+        for (int c = 0; c < count; c++)
+            nula_putpixel(region, x + c, y, pix[c]);
+    }
+    else
+        memcpy((char *)region->data + region->pitch * y + x * region->pixel_size, pix, count * sizeof(uint32_t));
+}
+
+/*
+ * Draw one byte of screen memory in one of the high frequency (80 column
+ * and 4 colour/16 colour 2MHz) modes.
+ */
+
+static void render_hifreq(ALLEGRO_LOCKED_REGION *region, int x, int y, uint8_t dat)
+{
+    int c;
+
+    if (vrs.nula_attribute_mode && vrs.ula_mode > 1) {
+        if (vrs.ula_mode == 3) {
+            // 1bpp
+            if (vrs.nula_attribute_text) {
+                int attribute = ((dat & 7) << 1);
+                float pc = 0.0f;
+                for (c = 0; c < 7; c++, pc += 0.75f) {
+                    int output = vrs.ula_pal[attribute | (dat >> (7 - (int) pc) & 1)];
+                    nula_putpixel(region, x + c, y, output);
+                }
+                // Very loose approximation of the text attribute mode
+                nula_putpixel(region, x + 7, y, vrs.ula_pal[attribute]);
+            }
+            else if (vrs.nula_attribute_mode >= 2) {
+                /* Spectrum mode */
+                if (nula_spect_toggle) {
+                    for (int c = -8; c < 8; c += 2) {
+                        int colour = dat & 0x80 ? nula_spect_ink : nula_spect_paper;
+                        nula_putpixel(region, x + c, y, colour);
+                        nula_putpixel(region, x + c + 1, y, colour);
+                        dat <<= 1;
+                    }
+                    nula_spect_toggle = 0;
+                }
+                else {
+                    if (dat == 0x80 && vrs.nula_attribute_mode == 2) {
+                        /* Spectrum Border colour */
+                        nula_spect_ink = nula_spect_paper = vrs.nula_collook[0];
+                    }
+                    else {
+                        /* Convert the ink and paper colours from the
+                         * attribute byte into indexes into the NuLA 12-bit
+                         * pallete as the bits are in the wrong order.
+                         */
+                        int ink = nula_spect_colours[dat & 7];
+                        int paper = nula_spect_colours[(dat >> 3) & 7];
+                        if (vrs.nula_attribute_mode == 2) {
+                            /* Spectrum attributes. */
+                            if (dat & 0x40) {
+                                // Brightness bit shared between ink and paper.
+                                ink |= 0x08;
+                                paper |= 0x08;
+                            }
+                        }
+                        else {
+                            /* Thomson attributes.  Black is not mapped to palette
+                             * entry 8 like the spectrum.
+                             */
+                            ink &= 7;
+                            paper &= 7;
+                            /* Most significant bit, equivalent to brightness bit in
+                             * spectrum mode, is separate for fg and bg.
+                             */
+                            if (dat & 0x40)
+                                ink |= 0x08;
+                            if (dat & 0x80)
+                                paper |= 0x08;
+                        }
+                        if (dat & 0x80 && vrs.ula_ctrl & 1) {
+                            // Flashing - use swapped colours.
+                            int tmp = ink;
+                            ink = paper;
+                            paper = tmp;
+                        }
+                        /* Do the lookup into the 12-bit pallete to get final RGB
+                         * values now - they will be the same for each of the
+                         * pixels that follow.
+                         */
+                        nula_spect_ink = vrs.nula_collook[ink];
+                        nula_spect_paper = vrs.nula_collook[paper];
+                    }
+                    nula_spect_toggle = 1;
+                }
+            }
+            else {
+                /* Normal NuLA attribute mode */
+                int attribute = ((dat & 3) << 2);
+                float pc = 0.0f;
+                for (c = 0; c < 8; c++, pc += 0.75f) {
+                    int output = vrs.ula_pal[attribute | (dat >> (7 - (int) pc) & 1)];
+                    nula_putpixel(region, x + c, y, output);
+                }
+            }
+        } else {
+            int attribute = (((dat & 16) >> 1) | ((dat & 1) << 2));
+            float pc = 0.0f;
+            for (c = 0; c < 8; c++, pc += 0.75f) {
+                int a = 3 - ((int) pc) / 2;
+                int output = vrs.ula_pal[attribute | ((dat >> (a + 3)) & 2) | ((dat >> a) & 1)];
+                nula_putpixel(region, x + c, y, output);
+            }
+        }
+    } else
+        vr_put_span(region, x, y, vr_pixels(dat), 8);
+}
+
+/*
+ * Draw one byte of screen memory in one of the low frequency modes.
+ */
+
+static void render_lofreq(ALLEGRO_LOCKED_REGION *region, int x, int y, uint8_t dat)
+{
+    int c;
+
+    if (vrs.nula_attribute_mode && vrs.ula_mode > 1) {
+        // In low frequency clock can only have 1bpp modes
+        if (vrs.nula_attribute_text) {
+            int attribute = ((dat & 7) << 1);
+            float pc = 0.0f;
+            for (c = 0; c < 14; c++, pc += 0.375f) {
+                int output = vrs.ula_pal[attribute | (dat >> (7 - (int) pc) & 1)];
+                nula_putpixel(region, x + c, y, output);
+            }
+
+            // Very loose approximation of the text attribute mode
+            nula_putpixel(region, x + 14, y, vrs.ula_pal[attribute]);
+            nula_putpixel(region, x + 15, y, vrs.ula_pal[attribute]);
+        } else {
+            int attribute = ((dat & 3) << 2);
+            float pc = 0.0f;
+            for (c = 0; c < 16; c++, pc += 0.375f) {
+                int output = vrs.ula_pal[attribute | (dat >> (7 - (int) pc) & 1)];
+                nula_putpixel(region, x + c, y, output);
+            }
+        }
+    } else
+        vr_put_span(region, x, y, vr_pixels(dat), 16);
+}
+
+/*
+ * Rendering.
+ *
+ * video_poll runs the CRTC and fetches screen memory on the emulation
+ * thread but does not draw anything itself.  It records what is to be
+ * drawn as a stream of small commands which are passed on in batches
+ * and executed by vr_render.  When vid_render_thread is set and the
+ * host has more than one CPU that happens on a separate thread so pixel
+ * generation overlaps emulation.  The thread is handed a batch only
+ * when it is full, or at the end of a frame, so the cost of the hand
+ * over is spread across many scanlines.  Otherwise each scanline is
+ * drawn as soon as it is complete.
+ *
+ * The renderer owns the mode 7 and NuLA attribute mode state and the
+ * locked region of the screen bitmap so anything else wanting to use
+ * these must call video_render_sync first.
+ */
+
+enum {
+    VR_STATE,       // followed by a vr_state_t.
+    VR_FILL,        // arg pixels of the blank colour.
+    VR_HIFREQ,      // dat is a byte of screen memory.
+    VR_LOFREQ,
+    VR_MODE7,       // dat is a character, sc the row within it.
+    VR_MODE7_BLANK,
+    VR_CURSOR,      // dat+1 pixels exclusive-ored with arg.
+    VR_EDGE,        // x is the NuLA left edge, arg the left cut.
+    VR_HSYNC        // end of a scanline, flags as below.
+};
+
+#define VR_HSYNC_ROW   0x01  // end of a character row too.
+#define VR_HSYNC_SPECT 0x02  // reset NuLA spectrum attribute toggle.
+#define VR_HSYNC_VSYNC 0x04  // step the teletext flash timer.
+
+typedef struct {
+    uint8_t op;
+    uint8_t dat;
+    uint8_t sc;
+    uint8_t flags;
+    int16_t x;
+    int16_t y;
+    int32_t arg;
+} vr_cmd_t;
+
+#define VR_BATCH_SIZE 16384
+#define VR_NUM_BATCHES 64
+
+typedef struct {
+    size_t used;
+    uint8_t data[VR_BATCH_SIZE];
+} vr_batch_t;
+
+bool vid_render_thread = false;
+
+static vr_batch_t *vr_batches, *vr_cur;
+static unsigned vr_head, vr_tail;
+static bool vr_stop;
+static ALLEGRO_THREAD *vr_thread;
+static ALLEGRO_MUTEX *vr_mutex;
+static ALLEGRO_COND *vr_cond;
+
+static void vr_render(const vr_batch_t *batch)
+{
+    const uint8_t *ptr = batch->data;
+    const uint8_t *end = ptr + batch->used;
+
+    while (ptr < end) {
+        const vr_cmd_t *cmd = (const vr_cmd_t *)ptr;
+        ptr += sizeof(vr_cmd_t);
+        switch(cmd->op) {
+            case VR_STATE: {
+                const vr_state_t *st = (const vr_state_t *)ptr;
+                if (memcmp(vrs.nula_collook, st->nula_collook, 8 * sizeof(int)))
+                    mode7_need_new_lookup = 1;
+                if (memcmp(vrs.ula_pal, st->ula_pal, sizeof(vrs.ula_pal)) || memcmp(vrs.nula_collook, st->nula_collook, sizeof(vrs.nula_collook))
+                    || vrs.ula_mode != st->ula_mode || vrs.nula_palette_mode != st->nula_palette_mode)
+                    vr_pixel_gen++;
+                memcpy(&vrs, ptr, sizeof(vr_state_t));
+                ptr += sizeof(vr_state_t);
                 break;
-            case 8: /* 136: flash */
-                mode7_flash = 1;
+            }
+            case VR_FILL:
+                put_pixels(region, cmd->x, cmd->y, cmd->arg, vrs.colblack);
                 break;
-            case 9: /* 137: steady */
-                mode7_flash = 0;
+            case VR_HIFREQ:
+                render_hifreq(region, cmd->x, cmd->y, cmd->dat);
                 break;
-            case 12: /* 140: normal height */
-            case 13: /* 141: double height */
-                mode7_dbl = dat & 1;
-                if (mode7_dbl)
-                    mode7_wasdbl = 1;
+            case VR_LOFREQ:
+                render_lofreq(region, cmd->x, cmd->y, cmd->dat);
                 break;
-            case 17: /* 145: graphics red     */
-            case 18: /* 146: graphics green   */
-            case 19: /* 147: graphics yellow  */
-            case 20: /* 148: graphics blue    */
-            case 21: /* 149: graphics magenta */
-            case 22: /* 150: graphics cyan    */
-            case 23: /* 151: graphics white   */
-                mode7_gfx = 1;
-                mode7_col = dat & 7;
-                if (mode7_sep)
-                    mode7_p = mode7_sepgraph;
-                else
-                    mode7_p = mode7_graph;
+            case VR_MODE7:
+                mode7_render(region, cmd->x, cmd->y, cmd->dat, cmd->sc, cmd->flags);
                 break;
-            case 24: /* 152: conceal */
-                mode7_col = mcolx = mode7_bg;
+            case VR_MODE7_BLANK:
+                put_pixels(region, cmd->x + 16, cmd->y, mode7_width, vrs.colblack);
                 break;
-            case 25: /* 153: contiguous graphics */
-                if (mode7_gfx)
-                    mode7_p = mode7_graph;
-                mode7_sep = 0;
+            case VR_CURSOR:
+                for (int c = cmd->dat; c >= 0; c--)
+                    nula_putpixel(region, cmd->x + c, cmd->y, get_pixel(region, cmd->x + c, cmd->y) ^ cmd->arg);
                 break;
-            case 26: /* 154: separated graphics */
-                if (mode7_gfx)
-                    mode7_p = mode7_sepgraph;
-                mode7_sep = 1;
+            case VR_EDGE:
+                nula_left_edge = cmd->x;
+                nula_left_cut = cmd->arg;
                 break;
-            case 28: /* 156: black background */
+            case VR_HSYNC:
+                mode7_col = 7;
                 mode7_bg = 0;
+                mode7_holdchar = 0;
+                mode7_heldchar = 0x20;
+                mode7_p = mode7_chars;
+                mode7_flash = 0;
+                mode7_sep = 0;
+                mode7_gfx = 0;
+                mode7_heldp = mode7_p;
+                if (cmd->flags & VR_HSYNC_SPECT)
+                    nula_spect_toggle = 0;
+                if (cmd->flags & VR_HSYNC_ROW) {
+                    if (mode7_nextdbl)
+                        mode7_nextdbl = 0;
+                    else
+                        mode7_nextdbl = mode7_wasdbl;
+                }
+                if (cmd->flags & VR_HSYNC_VSYNC) {
+                    mode7_flashtime++;
+                    if ((mode7_flashon && mode7_flashtime == 32) || (!mode7_flashon && mode7_flashtime == 16)) {
+                        mode7_flashon = !mode7_flashon;
+                        mode7_flashtime = 0;
+                    }
+                }
+                mode7_dbl = mode7_wasdbl = 0;
                 break;
-            case 29: /* 157: new background */
-                mode7_bg = mode7_col;
-                break;
-            case 30: /* 158: hold graphics */
-                mode7_holdchar = 1;
-                break;
-            case 31: /* 159: release graphics */
-                holdoff = 1;
-                break;
+        }
+    }
+}
+
+static void *vr_thread_proc(ALLEGRO_THREAD *thread, void *arg)
+{
+    al_lock_mutex(vr_mutex);
+    for (;;) {
+        while (vr_tail == vr_head && !vr_stop)
+            al_wait_cond(vr_cond, vr_mutex);
+        if (vr_tail == vr_head)
+            break;
+        vr_batch_t *batch = vr_batches + (vr_tail % VR_NUM_BATCHES);
+        al_unlock_mutex(vr_mutex);
+        vr_render(batch);
+        al_lock_mutex(vr_mutex);
+        vr_tail++;
+        al_broadcast_cond(vr_cond);
+    }
+    al_unlock_mutex(vr_mutex);
+    return NULL;
+}
+
+static void vr_start(void)
+{
+    bool threaded = vid_render_thread;
+
+    if (threaded && al_get_cpu_count() < 2) {
+        log_info("video: only one CPU, rendering on the emulation thread");
+        threaded = false;
+    }
+    if (!(vr_batches = malloc((threaded ? VR_NUM_BATCHES : 1) * sizeof(vr_batch_t)))) {
+        log_fatal("video: out of memory allocating render buffers");
+        exit(1);
+    }
+    vr_cur = vr_batches;
+    vr_cur->used = 0;
+    vr_head = vr_tail = 0;
+    if (threaded) {
+        vr_stop = false;
+        if ((vr_mutex = al_create_mutex())) {
+            if ((vr_cond = al_create_cond())) {
+                if ((vr_thread = al_create_thread(vr_thread_proc, NULL))) {
+                    al_start_thread(vr_thread);
+                    log_debug("video: render thread started");
+                    return;
+                }
+                al_destroy_cond(vr_cond);
+                vr_cond = NULL;
             }
-            if (mode7_holdchar) {
-                dat = mode7_heldchar;
-                if (!(dat & 0x20))
-                    dat = 0x20;
-                mode7_px = mode7_heldp;
-            } else
-                dat = 0x20;
-            if (mode7_dblx != mode7_dbl)
-                dat = 0x20;           /*Double height doesn't respect held characters */
-            if (!mode7_holdchar || !mode7_gfx)
-                mode7_heldchar = 0x20;
-        } else if (mode7_gfx && dat & 0x20) {
-            mode7_heldchar = dat;
-            mode7_heldp = mode7_px;
+            al_destroy_mutex(vr_mutex);
+            vr_mutex = NULL;
         }
+        log_warn("video: unable to start render thread, rendering on the emulation thread");
+    }
+}
 
-        int off = mode7_lookup[0][mode7_bg & 7][0];
-        int xpos = scrx + 16;
+/*
+ * Pass the batch being built to the renderer and start a new one.
+ */
 
-        if (mode7_flashx && !mode7_flashon) {
-            for (int c = 0; c < mode7_width; c++)
-                put_pixel(region, xpos++, scry, off);
+static void vr_publish(void)
+{
+    if (vr_cur->used) {
+        if (vr_thread) {
+            al_lock_mutex(vr_mutex);
+            vr_head++;
+            al_broadcast_cond(vr_cond);
+            while (vr_head - vr_tail >= VR_NUM_BATCHES)
+                al_wait_cond(vr_cond, vr_mutex);
+            al_unlock_mutex(vr_mutex);
+            vr_cur = vr_batches + (vr_head % VR_NUM_BATCHES);
         }
-        else {
-            const uint8_t *ptr = mode7_px + (dat - 0x20) * mode7_bytes_per_char;
-            if (mode7_dblx) {
-                if (!mode7_nextdbl)
-                    ptr += (sc >> 1) * mode7_width;
-                else
-                    ptr += ((sc >> 1) + 5) * mode7_width;
-            }
-            else
-                ptr += sc * mode7_width;
+        else
+            vr_render(vr_cur);
+        vr_cur->used = 0;
+    }
+}
 
-            if (!mode7_dbl && mode7_nextdbl)
-                on = mode7_lookup[mode7_bg & 7][mode7_bg & 7];
-            else
-                on = mode7_lookup[mcolx & 7][mode7_bg & 7];
+/*
+ * Wait until everything recorded so far has been drawn.
+ */
 
-            int interindex = (vid_dtype_intern == VDT_INTERLACE) && interlline;
-            if ((!mode7_dblx && interindex) || (mode7_dblx && sc & 1)) {
-                for (int c = 0; c < mode7_width; c++)
-                    put_pixel(region, xpos++, scry, on[*ptr++ >> 4]);
-            }
-            else {
-                for (int c = 0; c < mode7_width; c++)
-                    put_pixel(region, xpos++, scry, on[*ptr++ & 0x0f]);
-            }
+void video_render_sync(void)
+{
+    if (vr_cur) {
+        vr_publish();
+        if (vr_thread) {
+            al_lock_mutex(vr_mutex);
+            while (vr_tail != vr_head)
+                al_wait_cond(vr_cond, vr_mutex);
+            al_unlock_mutex(vr_mutex);
         }
-        scrx -= (16 - mode7_width);
+    }
+}
+
+void video_render_close(void)
+{
+    video_render_sync();
+    if (vr_thread) {
+        al_lock_mutex(vr_mutex);
+        vr_stop = true;
+        al_broadcast_cond(vr_cond);
+        al_unlock_mutex(vr_mutex);
+        al_join_thread(vr_thread, NULL);
+        al_destroy_thread(vr_thread);
+        vr_thread = NULL;
+        al_destroy_cond(vr_cond);
+        al_destroy_mutex(vr_mutex);
+    }
+    if (vr_batches) {
+        free(vr_batches);
+        vr_batches = vr_cur = NULL;
+    }
+}
+
+static void *vr_alloc(size_t size)
+{
+    if (vr_cur->used + size > VR_BATCH_SIZE)
+        vr_publish();
+    void *ptr = vr_cur->data + vr_cur->used;
+    vr_cur->used += size;
+    return ptr;
+}
+
+static vr_cmd_t *vr_cmd(uint8_t op, int x, int y)
+{
+    if (vr_state_dirty) {
+        vr_cmd_t *cmd = vr_alloc(sizeof(vr_cmd_t) + sizeof(vr_state_t));
+        vr_state_t *st = (vr_state_t *)(cmd + 1);
+        cmd->op = VR_STATE;
+        memcpy(st->ula_pal, ula_pal, sizeof(st->ula_pal));
+        memcpy(st->nula_collook, nula_collook, sizeof(st->nula_collook));
+        st->colblack = colblack;
+        st->ula_ctrl = ula_ctrl;
+        st->ula_mode = ula_mode;
+        st->crtc_mode = crtc_mode;
+        st->crtc1 = crtc[1];
+        st->nula_palette_mode = nula_palette_mode;
+        st->nula_attribute_mode = nula_attribute_mode;
+        st->nula_attribute_text = nula_attribute_text;
+        st->nula_horizontal_offset = nula_horizontal_offset;
+        st->nula_left_blank = nula_left_blank;
+        vr_state_dirty = false;
+    }
+    vr_cmd_t *cmd = vr_alloc(sizeof(vr_cmd_t));
+    cmd->op = op;
+    cmd->x = x;
+    cmd->y = y;
+    return cmd;
+}
+
+static inline void vr_fill(int x, int y, int count)
+{
+    vr_cmd(VR_FILL, x, y)->arg = count;
+}
 
-        if ((scrx + 16) < firstx)
-            firstx = scrx + 16;
-        if ((scrx + 32) > lastx)
-            lastx = scrx + 32;
+static inline void vr_cursor(int x, int y, int count, uint32_t xor)
+{
+    vr_cmd_t *cmd = vr_cmd(VR_CURSOR, x, y);
+    cmd->dat = count;
+    cmd->arg = xor;
+}
 
-        if (holdoff) {
-            mode7_holdchar = 0;
-            mode7_heldchar = 32;
+/*
+ * Pass a character to the SAA5050 which, being two characters behind
+ * the CRTC, draws the one from two calls ago.
+ */
+
+static void mode7_fetch(uint8_t dat)
+{
+    if (scrx < (1280-32)) {
+        uint8_t t = mode7_buf[0];
+        mode7_buf[0] = mode7_buf[1];
+        mode7_buf[1] = dat;
+        if (t == 255)
+            vr_cmd(VR_MODE7_BLANK, scrx, scry);
+        else {
+            vr_cmd_t *cmd = vr_cmd(VR_MODE7, scrx, scry);
+            cmd->dat = t;
+            cmd->sc = sc;
+            cmd->flags = (vid_dtype_intern == VDT_INTERLACE) && interlline;
+            scrx -= (16 - mode7_width);
+            if ((scrx + 16) < firstx)
+                firstx = scrx + 16;
+            if ((scrx + 32) > lastx)
+                lastx = scrx + 32;
         }
-        if (holdclear)
-            mode7_heldchar = 32;
     }
 }
 
@@ -784,33 +1380,14 @@ static int oldr8;
 int firstx, firsty, lastx, lasty;
 
 static ALLEGRO_DISPLAY *display;
-ALLEGRO_BITMAP *b, *b16, *b32;
+ALLEGRO_BITMAP *b, *b16, *b32, *bdisp;
 
 ALLEGRO_LOCKED_REGION *region;
 
 ALLEGRO_COLOR border_col;
 
-ALLEGRO_DISPLAY *video_init(void)
+static void video_init_bitmaps(void)
 {
-#ifdef ALLEGRO_GTK_TOPLEVEL
-    al_set_new_display_flags(ALLEGRO_WINDOWED | ALLEGRO_GTK_TOPLEVEL | ALLEGRO_RESIZABLE);
-#else
-    al_set_new_display_flags(ALLEGRO_WINDOWED | ALLEGRO_RESIZABLE);
-#endif
-    int vsync = get_config_int("video", "allegro_vsync", -1);
-    if (vsync >= 0) {
-        int temp;
-        al_set_new_display_option(ALLEGRO_VSYNC, 2, ALLEGRO_SUGGEST);
-        log_debug("video: config vsync=%d, actual=%d", vsync, al_get_new_display_option(ALLEGRO_VSYNC, &temp));
-    }
-    video_set_window_size(true);
-
-    if ((display = al_create_display(winsizex, winsizey)) == NULL) {
-        log_fatal("video: unable to create display");
-        exit(1);
-    }
-
-    al_set_new_bitmap_flags(ALLEGRO_VIDEO_BITMAP|ALLEGRO_NO_PRESERVE_TEXTURE);
     b16 = al_create_bitmap(832, 614);
     b32 = al_create_bitmap(1536, 800);
 
@@ -844,13 +1421,56 @@ ALLEGRO_DISPLAY *video_init(void)
             table4bpp[0][temp][c] = table4bpp[3][temp][c >> 3];
         }
     }
+    // Rendered to in memory, changes are uploaded to bdisp by video_doblit.
+    int flags = al_get_new_bitmap_flags();
+    al_set_new_bitmap_flags(ALLEGRO_MEMORY_BITMAP);
     b = al_create_bitmap(1280, 800);
+    al_set_new_bitmap_flags(flags);
     al_set_target_bitmap(b);
     al_clear_to_color(al_map_rgb(0, 0,0));
     region = al_lock_bitmap(b, ALLEGRO_PIXEL_FORMAT_ARGB_8888, ALLEGRO_LOCK_WRITEONLY);
+    vr_start();
+}
+
+ALLEGRO_DISPLAY *video_init(void)
+{
+#ifdef ALLEGRO_GTK_TOPLEVEL
+    al_set_new_display_flags(ALLEGRO_WINDOWED | ALLEGRO_GTK_TOPLEVEL | ALLEGRO_RESIZABLE);
+#else
+    al_set_new_display_flags(ALLEGRO_WINDOWED | ALLEGRO_RESIZABLE);
+#endif
+    int vsync = get_config_int("video", "allegro_vsync", -1);
+    if (vsync >= 0) {
+        int temp;
+        al_set_new_display_option(ALLEGRO_VSYNC, 2, ALLEGRO_SUGGEST);
+        log_debug("video: config vsync=%d, actual=%d", vsync, al_get_new_display_option(ALLEGRO_VSYNC, &temp));
+    }
+    video_set_window_size(true);
+
+    if ((display = al_create_display(winsizex, winsizey)) == NULL) {
+        log_fatal("video: unable to create display");
+        exit(1);
+    }
+
+    al_set_new_bitmap_flags(ALLEGRO_VIDEO_BITMAP|ALLEGRO_NO_PRESERVE_TEXTURE);
+    video_init_bitmaps();
+    bdisp = al_create_bitmap(1280, 800);
     return display;
 }
 
+/*
+ * Initialise video for the headless runner: the CRTC and ULA are
+ * emulated and frames rendered into memory bitmaps, for screenshots,
+ * but nothing is ever displayed.
+ */
+
+void video_init_headless(void)
+{
+    vid_headless = true;
+    al_set_new_bitmap_flags(ALLEGRO_MEMORY_BITMAP);
+    video_init_bitmaps();
+}
+
 void video_set_disptype(enum vid_disptype dtype)
 {
     vid_dtype_user = dtype;
@@ -880,11 +1500,13 @@ void video_reset()
     charsleft = 0;
     vidbank = 0;
 
+    video_render_sync();
     nula_left_cut = 0;
     nula_left_edge = 0;
     nula_left_blank = 0;
     nula_horizontal_offset = 0;
     nula_spect_toggle = 0;
+    vr_state_dirty = true;
 }
 
 #if 0
@@ -901,7 +1523,7 @@ static inline int is_free_run(void) {
 
 void video_poll(int clocks, int timer_enable)
 {
-    int c, oldvc;
+    int oldvc;
     uint16_t addr;
     uint8_t dat;
 
@@ -938,7 +1560,13 @@ void video_poll(int clocks, int timer_enable)
                 break;
         }
 
-        if (dispen) {
+        if (turbo) {
+            // The CRTC runs as normal but nothing is fetched or drawn.
+            if (dispen) {
+                ma++;
+                vidbytes++;
+            }
+        } else if (dispen) {
             if (!((ma ^ (crtc[15] | (crtc[14] << 8))) & 0x3FFF) && con)
                 cdraw = cdrawlook[crtc[8] >> 6];
 
@@ -957,158 +1585,30 @@ void video_poll(int clocks, int timer_enable)
             if (scrx < (1280-16)) {
                 if ((crtc[8] & 0x30) == 0x30 || ((sc & 8) && !(ula_ctrl & 2))) {
                     // Gaps between lines in modes 3 & 6.
-                    put_pixels(region, scrx, scry, (ula_ctrl & 0x10) ? 8 : 16, colblack);
+                    vr_fill(scrx, scry, (ula_ctrl & 0x10) ? 8 : 16);
                 } else
                     switch (crtc_mode) {
                     case CRTC_TELETEXT:
-                        mode7_render(region, dat & 0x7F);
+                        mode7_fetch(dat & 0x7F);
                         break;
                     case CRTC_HIFREQ:
-                        {
-                            if (scrx < firstx)
-                                firstx = scrx;
-                            if ((scrx + 8) > lastx)
-                                lastx = scrx + 8;
-                            if (nula_attribute_mode && ula_mode > 1) {
-                                if (ula_mode == 3) {
-                                    // 1bpp
-                                    if (nula_attribute_text) {
-                                        int attribute = ((dat & 7) << 1);
-                                        float pc = 0.0f;
-                                        for (c = 0; c < 7; c++, pc += 0.75f) {
-                                            int output = ula_pal[attribute | (dat >> (7 - (int) pc) & 1)];
-                                            nula_putpixel(region, scrx + c, scry, output);
-                                        }
-                                        // Very loose approximation of the text attribute mode
-                                        nula_putpixel(region, scrx + 7, scry, ula_pal[attribute]);
-                                    }
-                                    else if (nula_attribute_mode >= 2) {
-                                        /* Spectrum mode */
-                                        if (nula_spect_toggle) {
-                                            for (int c = -8; c < 8; c += 2) {
-                                                int colour = dat & 0x80 ? nula_spect_ink : nula_spect_paper;
-                                                nula_putpixel(region, scrx + c, scry, colour);
-                                                nula_putpixel(region, scrx + c + 1, scry, colour);
-                                                dat <<= 1;
-                                            }
-                                            nula_spect_toggle = 0;
-                                        }
-                                        else {
-                                            if (dat == 0x80 && nula_attribute_mode == 2) {
-                                                /* Spectrum Border colour */
-                                                nula_spect_ink = nula_spect_paper = nula_collook[0];
-                                            }
-                                            else {
-                                                /* Convert the ink and paper colours from the
-                                                 * attribute byte into indexes into the NuLA 12-bit
-                                                 * pallete as the bits are in the wrong order.
-                                                 */
-                                                int ink = nula_spect_colours[dat & 7];
-                                                int paper = nula_spect_colours[(dat >> 3) & 7];
-                                                if (nula_attribute_mode == 2) {
-                                                    /* Spectrum attributes. */
-                                                    if (dat & 0x40) {
-                                                        // Brightness bit shared between ink and paper.
-                                                        ink |= 0x08;
-                                                        paper |= 0x08;
-                                                    }
-                                                }
-                                                else {
-                                                    /* Thomson attributes.  Black is not mapped to palette
-                                                     * entry 8 like the spectrum.
-                                                     */
-                                                    ink &= 7;
-                                                    paper &= 7;
-                                                    /* Most significant bit, equivalent to brightness bit in
-                                                     * spectrum mode, is separate for fg and bg.
-                                                     */
-                                                    if (dat & 0x40)
-                                                        ink |= 0x08;
-                                                    if (dat & 0x80)
-                                                        paper |= 0x08;
-                                                }
-                                                if (dat & 0x80 && ula_ctrl & 1) {
-                                                    // Flashing - use swapped colours.
-                                                    int tmp = ink;
-                                                    ink = paper;
-                                                    paper = tmp;
-                                                }
-                                                /* Do the lookup into the 12-bit pallete to get final RGB
-                                                 * values now - they will be the same for each of the
-                                                 * pixels that follow.
-                                                 */
-                                                nula_spect_ink = nula_collook[ink];
-                                                nula_spect_paper = nula_collook[paper];
-                                            }
-                                            nula_spect_toggle = 1;
-                                        }
-                                    }
-                                    else {
-                                        /* Normal NuLA attribute mode */
-                                        int attribute = ((dat & 3) << 2);
-                                        float pc = 0.0f;
-                                        for (c = 0; c < 8; c++, pc += 0.75f) {
-                                            int output = ula_pal[attribute | (dat >> (7 - (int) pc) & 1)];
-                                            nula_putpixel(region, scrx + c, scry, output);
-                                        }
-                                    }
-                                } else {
-                                    int attribute = (((dat & 16) >> 1) | ((dat & 1) << 2));
-                                    float pc = 0.0f;
-                                    for (c = 0; c < 8; c++, pc += 0.75f) {
-                                        int a = 3 - ((int) pc) / 2;
-                                        int output = ula_pal[attribute | ((dat >> (a + 3)) & 2) | ((dat >> a) & 1)];
-                                        nula_putpixel(region, scrx + c, scry, output);
-                                    }
-                                }
-                            } else {
-                                for (c = 0; c < 8; c++) {
-                                    nula_putpixel(region, scrx + c, scry, nula_palette_mode ? nula_collook[table4bpp[ula_mode][dat][c]] : ula_pal[table4bpp[ula_mode][dat][c]]);
-                                }
-                            }
-                        }
+                        if (scrx < firstx)
+                            firstx = scrx;
+                        if ((scrx + 8) > lastx)
+                            lastx = scrx + 8;
+                        vr_cmd(VR_HIFREQ, scrx, scry)->dat = dat;
                         break;
                     case CRTC_LOFREQ:
-                        {
-                            if (scrx < firstx)
-                                firstx = scrx;
-                            if ((scrx + 16) > lastx)
-                                lastx = scrx + 16;
-                            if (nula_attribute_mode && ula_mode > 1) {
-                                // In low frequency clock can only have 1bpp modes
-                                if (nula_attribute_text) {
-                                    int attribute = ((dat & 7) << 1);
-                                    float pc = 0.0f;
-                                    for (c = 0; c < 14; c++, pc += 0.375f) {
-                                        int output = ula_pal[attribute | (dat >> (7 - (int) pc) & 1)];
-                                        nula_putpixel(region, scrx + c, scry, output);
-                                    }
-
-                                    // Very loose approximation of the text attribute mode
-                                    nula_putpixel(region, scrx + 14, scry, ula_pal[attribute]);
-                                    nula_putpixel(region, scrx + 15, scry, ula_pal[attribute]);
-                                } else {
-                                    int attribute = ((dat & 3) << 2);
-                                    float pc = 0.0f;
-                                    for (c = 0; c < 16; c++, pc += 0.375f) {
-                                        int output = ula_pal[attribute | (dat >> (7 - (int) pc) & 1)];
-                                        nula_putpixel(region, scrx + c, scry, output);
-                                    }
-                                }
-                            } else {
-                                for (c = 0; c < 16; c++) {
-                                    nula_putpixel(region, scrx + c, scry, nula_palette_mode ? nula_collook[table4bpp[ula_mode][dat][c]] : ula_pal[table4bpp[ula_mode][dat][c]]);
-                                }
-                            }
-                        }
+                        if (scrx < firstx)
+                            firstx = scrx;
+                        if ((scrx + 16) > lastx)
+                            lastx = scrx + 16;
+                        vr_cmd(VR_LOFREQ, scrx, scry)->dat = dat;
                         break;
                     }
                 if (cdraw) {
-                    if (cursoron && (ula_ctrl & cursorlook[cdraw])) {
-                        for (c = ((ula_ctrl & 0x10) ? 8 : 16); c >= 0; c--) {
-                            nula_putpixel(region, scrx + c, scry, get_pixel(region, scrx + c, scry) ^ 0x00ffffff);
-                        }
-                    }
+                    if (cursoron && (ula_ctrl & cursorlook[cdraw]))
+                        vr_cursor(scrx, scry, (ula_ctrl & 0x10) ? 8 : 16, 0x00ffffff);
                     cdraw++;
                     if (cdraw == 7)
                         cdraw = 0;
@@ -1119,20 +1619,17 @@ void video_poll(int clocks, int timer_enable)
         } else {
             if (charsleft) {
                 if (charsleft != 1)
-                    mode7_render(region, 255);
+                    mode7_fetch(255);
                 charsleft--;
 
             } else if (scrx < (1280-32)) {
-                put_pixels(region, scrx, scry, (ula_ctrl & 0x10) ? 8 : 16, colblack);
+                vr_fill(scrx, scry, (ula_ctrl & 0x10) ? 8 : 16);
                 if (!crtc_mode)
-                    put_pixels(region, scrx + 16, scry, 16, colblack);
+                    vr_fill(scrx + 16, scry, 16);
             }
             if (cdraw && scrx < (1280-16)) {
-                if (cursoron && (ula_ctrl & cursorlook[cdraw])) {
-                    for (c = ((ula_ctrl & 0x10) ? 8 : 16); c >= 0; c--) {
-                        nula_putpixel(region, scrx + c, scry, get_pixel(region, scrx + c, scry) ^ colwhite);
-                    }
-                }
+                if (cursoron && (ula_ctrl & cursorlook[cdraw]))
+                    vr_cursor(scrx, scry, (ula_ctrl & 0x10) ? 8 : 16, colwhite);
                 cdraw++;
                 if (cdraw == 7)
                     cdraw = 0;
@@ -1162,30 +1659,23 @@ void video_poll(int clocks, int timer_enable)
             else
                 scrx = 128 - ((crtc[3] & 15) * 8);
         } else if (hc == crtc[0]) {
-            mode7_col = 7;
-            mode7_bg = 0;
-            mode7_holdchar = 0;
-            mode7_heldchar = 0x20;
-            mode7_p = mode7_chars;
-            mode7_flash = 0;
-            mode7_sep = 0;
-            mode7_gfx = 0;
-            mode7_heldp = mode7_p;
+            int hsync_flags = 0;
 
             hc = 0;
 
-            if (crtc_mode) {
+            if (crtc_mode && !turbo) {
                 // NULA left edge
-                nula_left_edge = scrx + crtc_mode * 8;
+                int left_edge = scrx + crtc_mode * 8;
 
                 // NULA left cut
-                nula_left_cut = nula_left_edge + nula_left_blank * crtc_mode * 8;
+                vr_cmd(VR_EDGE, left_edge, scry)->arg = left_edge + nula_left_blank * crtc_mode * 8;
 
                 // NULA horizontal offset - "delay" the pixel clock
-                for (c = 0; c < nula_horizontal_offset * crtc_mode; c++, scrx++) {
-                    put_pixel(region, scrx + crtc_mode * 8, scry, colblack);
+                if (nula_horizontal_offset) {
+                    vr_fill(scrx + crtc_mode * 8, scry, nula_horizontal_offset * crtc_mode);
+                    scrx += nula_horizontal_offset * crtc_mode;
                 }
-                nula_spect_toggle = 0;
+                hsync_flags |= VR_HSYNC_SPECT;
             }
 
             if (sc == (crtc[11] & 31) || ((crtc[8] & 3) == 3 && sc == ((crtc[11] & 31) >> 1))) {
@@ -1208,10 +1698,7 @@ void video_poll(int clocks, int timer_enable)
                 sc = 0;
                 con = 0;
                 coff = 0;
-                if (mode7_nextdbl)
-                    mode7_nextdbl = 0;
-                else
-                    mode7_nextdbl = mode7_wasdbl;
+                hsync_flags |= VR_HSYNC_ROW;
                 oldvc = vc;
                 vc++;
                 vc &= 127;
@@ -1234,7 +1721,8 @@ void video_poll(int clocks, int timer_enable)
                 if (vc == crtc[7]) {
                     // Reached vertical sync position.
                     int intsync = crtc[8] & 1;
-                    if (!intsync && oldr8) {
+                    video_render_sync();
+                    if (!intsync && oldr8 && !turbo) {
                         ALLEGRO_COLOR black = al_map_rgb(0, 0, 0);
                         al_set_target_bitmap(b32);
                         al_clear_to_color(black);
@@ -1251,7 +1739,7 @@ void video_poll(int clocks, int timer_enable)
                     if (vidclocks > 1024 && !ccount) {
                         video_doblit(crtc_mode, crtc[4]);
                         vid_cleared = 0;
-                    } else if (vidclocks <= 1024 && !vid_cleared) {
+                    } else if (vidclocks <= 1024 && !vid_cleared && !turbo) {
                         vid_cleared = 1;
                         al_unlock_bitmap(b);
                         al_set_target_bitmap(b);
@@ -1272,11 +1760,7 @@ void video_poll(int clocks, int timer_enable)
                     if (!(crtc[3] >> 4))
                         vsynctime = 17;
 
-                    mode7_flashtime++;
-                    if ((mode7_flashon && mode7_flashtime == 32) || (!mode7_flashon && mode7_flashtime == 16)) {
-                        mode7_flashon = !mode7_flashon;
-                        mode7_flashtime = 0;
-                    }
+                    hsync_flags |= VR_HSYNC_VSYNC;
 
                     vidclocks = vidbytes = 0;
                 }
@@ -1286,7 +1770,12 @@ void video_poll(int clocks, int timer_enable)
                 ma = maback;
             }
 
-            mode7_dbl = mode7_wasdbl = 0;
+            if (!turbo) {
+                vr_cmd(VR_HSYNC, scrx, scry)->flags = hsync_flags;
+                if (!vr_thread)
+                    vr_publish();
+            }
+
             if ((sc == (crtc[10] & 31) || ((crtc[8] & 3) == 3 && sc == ((crtc[10] & 31) >> 1))) && !coff)
                 con = 1;
 
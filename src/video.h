@@ -37,6 +37,7 @@ extern uint8_t nula_attribute_mode;
 extern uint8_t nula_attribute_text;
 
 ALLEGRO_DISPLAY *video_init(void);
+void video_init_headless(void);
 void video_reset(void);
 void video_poll(int clocks, int timer_enable);
 void video_savestate(FILE *f);
@@ -1,7 +1,7 @@
 #ifndef __INC_VIDEO_RENDER_H
 #define __INC_VIDEO_RENDER_H
 
-extern ALLEGRO_BITMAP *b, *b16, *b32;
+extern ALLEGRO_BITMAP *b, *b16, *b32, *bdisp;
 extern ALLEGRO_LOCKED_REGION *region;
 extern ALLEGRO_COLOR border_col, mono_green_col, mono_amber_col, mono_white_col;
 
@@ -56,6 +56,8 @@ extern enum vid_coltype {
 extern int vid_fskipmax, vid_fullborders;
 extern int vid_ledlocation, vid_ledvisibility;
 extern bool vid_print_mode;
+extern bool vid_headless;
+extern bool vid_render_thread;
 
 extern int vid_savescrshot;
 extern char vid_scrshotname[260];
@@ -72,6 +74,8 @@ void video_set_led_location(int location);
 void video_set_led_visibility(int visibility);
 
 void video_close(void);
+void video_render_sync(void);
+void video_render_close(void);
 
 void clearscreen(void);
 
@@ -607,6 +607,16 @@ static void wd1770_writeprotect()
     wd1770_fault(0x40, "write protect");
 }
 
+static bool wd1770_drq(void)
+{
+    return wd1770.status & 0x02;
+}
+
+static bool wd1770_busy(void)
+{
+    return wd1770.status & 0x01;
+}
+
 void wd1770_reset()
 {
     if (fdc_type >= FDC_ACORN) { /* if FDC is a 1770 */
@@ -625,6 +635,8 @@ void wd1770_reset()
         fdc_headercrcerror = wd1770_headercrcerror;
         fdc_writeprotect   = wd1770_writeprotect;
         fdc_getdata        = wd1770_getdata;
+        fdc_drq            = wd1770_drq;
+        fdc_busy           = wd1770_busy;
         motorspin = 45000;
         if (motoron)
             wd1770.status |= 0x80;